@@ -4,7 +4,10 @@
 /*	Gamma - Generic processing library
 	See COPYRIGHT file for authors and license information */
 
+#include <vector>
+#include "Gamma/FFT.h"
 #include "Gamma/Filter.h"
+#include "Gamma/tbl.h"
 
 namespace gam{
 
@@ -190,5 +193,556 @@ private:
 	unsigned mCount;
 };
 
+
+
+/// Bank of Goertzel filters for analyzing a few arbitrary frequencies
+
+/// This evaluates the discrete-time Fourier transform of windows of the input
+/// at a set of arbitrary frequencies using the Goertzel algorithm. Each
+/// frequency costs one multiply-add pair per sample and window, so for a
+/// handful of frequencies this is much cheaper than an FFT of the whole
+/// window. Windows of sizeWin() samples start every sizeHop() samples, so they
+/// overlap when the hop is less than the window size.
+///
+/// Results are normalized by the sum of the window so that a sinusoid of
+/// amplitude A at an analyzed frequency gives a magnitude of A/2, as for DFT.
+/// Phases are relative to the start of the window.
+///\ingroup Analysis
+template <class T=gam::real, class Td=DomainObserver>
+class GoertzelBank : public Td{
+public:
+
+	/// \param[in] numFreqs	number of frequencies to analyze
+	/// \param[in] winSize		size of analysis window, in samples
+	/// \param[in] hopSize		samples between window starts; 0 sets it to the
+	///							window size
+	/// \param[in] winType		type of analysis window
+	GoertzelBank(unsigned numFreqs=1, unsigned winSize=256, unsigned hopSize=0,
+		WindowType winType=RECTANGLE)
+	:	mWinType(winType)
+	{
+		resize(numFreqs, winSize, hopSize);
+	}
+
+
+	/// Set number of frequencies, window size and hop size
+
+	/// This resets all windows in progress. Frequencies that are kept retain
+	/// their values and new frequencies are set to 0.
+	GoertzelBank& resize(unsigned numFreqs, unsigned winSize, unsigned hopSize=0);
+
+	/// Set window type
+	GoertzelBank& windowType(WindowType v){ mWinType=v; computeWindow(); return *this; }
+
+	/// Set an analysis frequency, in Hz
+	GoertzelBank& freq(unsigned i, T hz){
+		mFreqs[i]=hz; computeCoef(i); return *this; }
+
+	/// Set all analysis frequencies, in Hz, from an array of numFreqs() values
+	GoertzelBank& freqs(const T * hz){
+		for(unsigned i=0; i<numFreqs(); ++i) freq(i, hz[i]);
+		return *this;
+	}
+
+	/// Clear windows in progress and results
+	void reset();
+
+
+	/// Input next sample
+
+	/// \returns whether a window was completed, updating the results
+	///
+	bool operator()(T input);
+
+	/// Input a block of samples
+
+	/// \param[in] input		input samples
+	/// \param[in] numSamples	number of input samples
+	/// \param[in] onWindow		function called with no arguments after each
+	///							window is completed
+	/// \returns number of windows completed
+	template <class OnWindow>
+	unsigned operator()(const T * input, unsigned numSamples, OnWindow onWindow);
+
+	/// Input a block of samples
+
+	/// \returns number of windows completed; results are from the last one
+	///
+	unsigned operator()(const T * input, unsigned numSamples){
+		return (*this)(input, numSamples, [](){});
+	}
+
+
+	/// Get result at a frequency
+	const Complex<T>& bin(unsigned i) const { return mBins[i]; }
+
+	/// Get pointer to results
+	const Complex<T> * bins() const { return &mBins[0]; }
+
+	/// Get magnitude at a frequency
+	T mag(unsigned i) const { return mBins[i].mag(); }
+
+	/// Get power (squared magnitude) at a frequency
+	T power(unsigned i) const { return mBins[i].magSqr(); }
+
+	/// Get an analysis frequency, in Hz
+	T freq(unsigned i) const { return mFreqs[i]; }
+
+	unsigned numFreqs() const { return mFreqs.size(); }	///< Get number of frequencies
+	unsigned sizeWin() const { return mWin.size(); }	///< Get window size
+	unsigned sizeHop() const { return mHop; }			///< Get hop size
+	WindowType windowType() const { return mWinType; }	///< Get window type
+
+	void onDomainChange(double r){
+		for(unsigned i=0; i<numFreqs(); ++i) computeCoef(i);
+	}
+
+protected:
+	std::vector<T> mFreqs;
+	std::vector<T> mCoef;		// 2 cos(w), feedback coefficient
+	std::vector<Complex<T>> mEnd;	// conj(e^jw) and e^-jw(N-1): complete a window
+	std::vector<Complex<T>> mRot;
+	std::vector<T> mS1, mS2;	// filter states, numFreqs() per window slot
+	std::vector<unsigned> mPos;	// sample position in each window slot
+	std::vector<T> mWin;		// analysis window
+	std::vector<Complex<T>> mBins;
+	WindowType mWinType;
+	T mWinNorm;
+	unsigned mHop, mHopCnt, mSlot;
+
+	unsigned numSlots() const { return mPos.size(); }
+	void computeCoef(unsigned i);
+	void computeWindow();
+	void finish(unsigned slot);
+};
+
+
+
+/// Pitch detector
+
+/// This estimates the fundamental frequency of the input over a window of
+/// sizeWin() samples every sizeHop() samples. Two periodicity functions are
+/// available, both computed through correlations using RFFT in O(N log N):
+///
+/// MPM (McLeod pitch method) uses the normalized square difference function
+/// (NSDF), an autocorrelation normalized to [-1, 1]. The period is the first
+/// of the highest peaks between zero crossings that reaches threshold() times
+/// the highest of them. Its confidence is the NSDF at that peak.
+///
+/// YIN uses the cumulative mean normalized difference function over the first
+/// sizeWin() - (longest period) samples of the window. The period is the first
+/// dip below threshold(), or the lowest point if there is none. Its confidence
+/// is one minus the difference at the period.
+///
+/// In both cases the period is refined with parabolic interpolation. The
+/// window should hold at least two periods of the lowest frequency.
+///\ingroup Analysis
+template <class T=float, class Td=DomainObserver>
+class PitchTrack : public Td{
+public:
+
+	/// Periodicity function
+	enum Method{
+		MPM,	/**< McLeod pitch method */
+		YIN		/**< YIN */
+	};
+
+	/// \param[in] winSize		analysis window size, in samples
+	/// \param[in] hopSize		samples between analyses
+	/// \param[in] method		periodicity function
+	PitchTrack(unsigned winSize=2048, unsigned hopSize=512, Method method=MPM)
+	:	mMinFreq(40), mMaxFreq(2000)
+	{
+		this->method(method);
+		resize(winSize, hopSize);
+	}
+
+
+	/// Set window and hop size, in samples
+	PitchTrack& resize(unsigned winSize, unsigned hopSize);
+
+	/// Set periodicity function; this also sets its default threshold
+	PitchTrack& method(Method v){
+		mMethod = v;
+		mThresh = MPM == v ? T(0.9) : T(0.15);
+		return *this;
+	}
+
+	/// Set range of frequencies to detect, in Hz
+	PitchTrack& range(T minFreq, T maxFreq){
+		mMinFreq = minFreq; mMaxFreq = maxFreq;
+		computeLags();
+		return *this;
+	}
+
+	/// Set peak picking threshold
+
+	/// For MPM, this is the fraction of the highest peak a peak must reach,
+	/// typically 0.8 to 1. For YIN, it is the difference below which a dip is
+	/// taken, typically 0.1 to 0.2.
+	PitchTrack& threshold(T v){ mThresh=v; return *this; }
+
+	/// Clear input history and estimate
+	void reset();
+
+
+	/// Input next sample
+
+	/// \returns whether a new estimate was made
+	///
+	bool operator()(T input);
+
+	/// Input a block of samples
+
+	/// \returns number of estimates made; the current one is the last
+	///
+	unsigned operator()(const T * input, unsigned numSamples){
+		unsigned count = 0;
+		for(unsigned i=0; i<numSamples; ++i) count += (*this)(input[i]);
+		return count;
+	}
+
+
+	/// Get estimated frequency, in Hz, or 0 if there is no estimate
+	T freq() const { return mPeriod > T(0) ? T(Td::spu()) / mPeriod : T(0); }
+
+	/// Get estimated period, in samples, or 0 if there is no estimate
+	T period() const { return mPeriod; }
+
+	/// Get confidence of estimate, in [0, 1]
+	T confidence() const { return mConf; }
+
+	unsigned sizeWin() const { return mWin; }	///< Get window size
+	unsigned sizeHop() const { return mHop; }	///< Get hop size
+	Method method() const { return mMethod; }	///< Get periodicity function
+	T threshold() const { return mThresh; }		///< Get peak picking threshold
+
+	void onDomainChange(double r){ computeLags(); }
+
+protected:
+	RFFT<T> mFFT;
+	std::vector<T> mRing;		// input history
+	std::vector<T> mBuf, mAux;	// transform buffers
+	std::vector<T> mFunc;		// periodicity function, by lag
+	std::vector<T> mX;			// current window
+	Method mMethod;
+	T mMinFreq, mMaxFreq, mThresh;
+	T mPeriod, mConf;
+	unsigned mWin, mHop, mTap, mHopCnt;
+	unsigned mMinLag, mMaxLag;
+
+	void computeLags();
+	void analyze();
+	void analyzeMPM();
+	void analyzeYIN();
+	void refine(unsigned lag, bool peak);
+};
+
+
+
+// Implementation_______________________________________________________________
+
+template <class T, class Td>
+PitchTrack<T,Td>& PitchTrack<T,Td>::resize(unsigned winSize, unsigned hopSize){
+	mWin = scl::max(winSize, 8u);
+	mHop = scl::clip(hopSize, mWin, 1u);
+	mRing.resize(mWin);
+	mX.resize(mWin);
+	mFunc.resize(mWin/2 + 2);
+
+	// Autocorrelation up to half the window without circular aliasing
+	unsigned N = scl::ceilPow2(mWin + mWin/2 + 1);
+	mFFT.resize(N);
+	mBuf.resize(N+2);
+	mAux.resize(N+2);
+
+	computeLags();
+	reset();
+	return *this;
+}
+
+template <class T, class Td>
+void PitchTrack<T,Td>::reset(){
+	for(auto& v : mRing) v = T(0);
+	mTap = 0;
+	mHopCnt = 0;
+	mPeriod = T(0);
+	mConf = T(0);
+}
+
+template <class T, class Td>
+void PitchTrack<T,Td>::computeLags(){
+	// lags are limited to half the window and must have neighbors to refine
+	unsigned maxLag = mWin/2;
+	double lo = Td::spu() / mMaxFreq;
+	double hi = Td::spu() / mMinFreq;
+	mMinLag = scl::clip<unsigned>(lo, maxLag, 2);
+	mMaxLag = scl::clip<unsigned>(hi + 1., maxLag, mMinLag);
+}
+
+template <class T, class Td>
+inline bool PitchTrack<T,Td>::operator()(T input){
+	mRing[mTap] = input;
+	if(++mTap == mWin) mTap = 0;
+	if(++mHopCnt < mHop) return false;
+	mHopCnt = 0;
+	analyze();
+	return true;
+}
+
+template <class T, class Td>
+void PitchTrack<T,Td>::analyze(){
+	mem::copyAllFromRing(&mRing[0], mWin, mTap, &mX[0]);
+	if(MPM == mMethod)	analyzeMPM();
+	else				analyzeYIN();
+}
+
+template <class T, class Td>
+void PitchTrack<T,Td>::refine(unsigned lag, bool peak){
+	const T * f = &mFunc[0];
+	T d = ipl::parabolic(f[lag-1], f[lag], f[lag+1]);
+	if(!(scl::abs(d) <= T(1))) d = T(0);
+	T v = f[lag] - T(0.25) * (f[lag-1] - f[lag+1]) * d;
+	mPeriod = T(lag) + d;
+	mConf = scl::clip(peak ? v : T(1) - v);
+}
+
+template <class T, class Td>
+void PitchTrack<T,Td>::analyzeMPM(){
+	const unsigned W = mWin;
+	const unsigned N = mFFT.size();
+	const unsigned L = mMaxLag + 1;	// highest lag computed
+	const T * x = &mX[0];
+	T * b = &mBuf[0];
+	T * f = &mFunc[0];
+
+	// autocorrelation r = IFFT(|FFT(x)|^2)
+	for(unsigned i=0; i<W; ++i) b[i+1] = x[i];
+	for(unsigned i=W+1; i<=N; ++i) b[i] = T(0);
+	mFFT.forward(b, true, false);
+	for(unsigned k=0; k<N/2+1; ++k){
+		b[2*k] = b[2*k]*b[2*k] + b[2*k+1]*b[2*k+1];
+		b[2*k+1] = T(0);
+	}
+	mFFT.inverse(b, true);
+	const T * r = b + 1;
+
+	// NSDF = 2 r(t) / m(t), m(t) = sum of squares of the overlapping parts
+	T m = T(0);
+	for(unsigned i=0; i<W; ++i) m += x[i]*x[i];
+	m *= T(2);
+	if(m <= T(0)){ mPeriod = mConf = T(0); return; }
+
+	const T rNorm = T(2) / T(N);
+	for(unsigned t=0; t<=L; ++t){
+		if(t){
+			m -= x[t-1]*x[t-1] + x[W-t]*x[W-t];
+		}
+		f[t] = m > T(0) ? r[t]*rNorm / m : T(0);
+	}
+
+	// Key maxima are the highest points between a positive-going zero
+	// crossing and the next negative-going one, after the zero-lag lobe.
+	unsigned t = 1;
+	while(t < L && f[t] > T(0)) ++t;
+
+	unsigned keys[64];
+	unsigned numKeys = 0;
+	T highest = T(0);
+	while(t < L && numKeys < 64){
+		while(t < L && f[t] <= T(0)) ++t;
+		unsigned best = 0;
+		while(t < L && f[t] > T(0)){
+			if(t >= mMinLag && (!best || f[t] > f[best])) best = t;
+			++t;
+		}
+		if(best){
+			keys[numKeys++] = best;
+			highest = scl::max(highest, f[best]);
+		}
+	}
+
+	if(!numKeys){ mPeriod = mConf = T(0); return; }
+
+	T cutoff = mThresh * highest;
+	for(unsigned k=0; k<numKeys; ++k){
+		if(f[keys[k]] >= cutoff){
+			refine(keys[k], true);
+			return;
+		}
+	}
+}
+
+template <class T, class Td>
+void PitchTrack<T,Td>::analyzeYIN(){
+	const unsigned W = mWin;
+	const unsigned N = mFFT.size();
+	const unsigned L = mMaxLag + 1;	// highest lag computed
+	const unsigned Wi = W - L;		// integration window
+	const T * x = &mX[0];
+	T * a = &mAux[0];
+	T * b = &mBuf[0];
+	T * f = &mFunc[0];
+
+	// cross-correlation of the integration window with the whole window,
+	// c(t) = sum_{j<Wi} x_j x_{j+t} = IFFT(conj(A) B)
+	for(unsigned i=0; i<Wi; ++i) a[i+1] = x[i];
+	for(unsigned i=Wi+1; i<=N; ++i) a[i] = T(0);
+	for(unsigned i=0; i<W; ++i) b[i+1] = x[i];
+	for(unsigned i=W+1; i<=N; ++i) b[i] = T(0);
+	mFFT.forward(a, true, false);
+	mFFT.forward(b, true, false);
+	for(unsigned k=0; k<N/2+1; ++k){
+		T ar = a[2*k], ai = a[2*k+1];
+		T br = b[2*k], bi = b[2*k+1];
+		b[2*k  ] = ar*br + ai*bi;
+		b[2*k+1] = ar*bi - ai*br;
+	}
+	mFFT.inverse(b, true);
+	const T * c = b + 1;
+	const T cNorm = T(1) / T(N);
+
+	// difference d(t) = e(0) + e(t) - 2 c(t), normalized by its running mean
+	T e0 = T(0);
+	for(unsigned i=0; i<Wi; ++i) e0 += x[i]*x[i];
+	T et = e0;
+	T sum = T(0);
+	f[0] = T(1);
+	for(unsigned t=1; t<=L; ++t){
+		et += x[t+Wi-1]*x[t+Wi-1] - x[t-1]*x[t-1];
+		T d = scl::max(e0 + et - T(2)*c[t]*cNorm, T(0));
+		sum += d;
+		f[t] = sum > T(0) ? d * T(t) / sum : T(1);
+	}
+
+	unsigned best = mMinLag;
+	for(unsigned t=mMinLag; t<L; ++t){
+		if(f[t] < mThresh){
+			while(t+1 < L && f[t+1] < f[t]) ++t;
+			refine(t, false);
+			return;
+		}
+		if(f[t] < f[best]) best = t;
+	}
+	refine(best, false);
+}
+
+template <class T, class Td>
+GoertzelBank<T,Td>& GoertzelBank<T,Td>::resize(
+	unsigned numFreqs, unsigned winSize, unsigned hopSize
+){
+	if(winSize < 1) winSize = 1;
+	mHop = hopSize ? scl::min(hopSize, winSize) : winSize;
+
+	mFreqs.resize(numFreqs, T(0));
+	mCoef.resize(numFreqs);
+	mEnd.resize(numFreqs);
+	mRot.resize(numFreqs);
+	mBins.assign(numFreqs, Complex<T>(0));
+	mWin.resize(winSize);
+
+	// one slot per window that can be in progress at once
+	unsigned slots = (winSize + mHop - 1) / mHop;
+	mPos.resize(slots);
+	mS1.resize(slots * numFreqs);
+	mS2.resize(slots * numFreqs);
+
+	computeWindow();
+	reset();
+	return *this;
+}
+
+template <class T, class Td>
+void GoertzelBank<T,Td>::reset(){
+	for(auto& v : mS1) v = T(0);
+	for(auto& v : mS2) v = T(0);
+	for(auto& v : mBins) v = T(0);
+	// all slots idle until their first window starts
+	for(auto& v : mPos) v = sizeWin();
+	mHopCnt = 0;
+	mSlot = 0;
+}
+
+template <class T, class Td>
+void GoertzelBank<T,Td>::computeCoef(unsigned i){
+	double w = M_2PI * mFreqs[i] * Td::ups();
+	mCoef[i] = T(2. * cos(w));
+	mEnd[i](T(cos(w)), T(-sin(w)));
+	double wn = w * (sizeWin() - 1);
+	mRot[i](T(cos(wn) / mWinNorm), T(-sin(wn) / mWinNorm));
+}
+
+template <class T, class Td>
+void GoertzelBank<T,Td>::computeWindow(){
+	tbl::window(&mWin[0], sizeWin(), mWinType);
+	double sum = 0;
+	for(auto v : mWin) sum += v;
+	mWinNorm = T(sum);
+	for(unsigned i=0; i<numFreqs(); ++i) computeCoef(i);
+}
+
+template <class T, class Td>
+void GoertzelBank<T,Td>::finish(unsigned slot){
+	const T * s1 = &mS1[slot * numFreqs()];
+	const T * s2 = &mS2[slot * numFreqs()];
+	for(unsigned i=0; i<numFreqs(); ++i){
+		// X = (s1 - s2 e^-jw) e^-jw(N-1)
+		Complex<T> y(s1[i] - s2[i]*mEnd[i].r, -s2[i]*mEnd[i].i);
+		mBins[i] = y * mRot[i];
+	}
+}
+
+template <class T, class Td>
+inline bool GoertzelBank<T,Td>::operator()(T input){
+
+	// start a new window every hop
+	if(0 == mHopCnt){
+		T * s1 = &mS1[mSlot * numFreqs()];
+		T * s2 = &mS2[mSlot * numFreqs()];
+		for(unsigned i=0; i<numFreqs(); ++i) s1[i] = s2[i] = T(0);
+		mPos[mSlot] = 0;
+		if(++mSlot == numSlots()) mSlot = 0;
+	}
+	if(++mHopCnt == mHop) mHopCnt = 0;
+
+	bool done = false;
+	const T * c = &mCoef[0];
+
+	for(unsigned p=0; p<numSlots(); ++p){
+		unsigned& pos = mPos[p];
+		if(pos >= sizeWin()) continue;
+
+		const T x = input * mWin[pos];
+		T * s1 = &mS1[p * numFreqs()];
+		T * s2 = &mS2[p * numFreqs()];
+		for(unsigned i=0; i<numFreqs(); ++i){
+			T s = x + c[i]*s1[i] - s2[i];
+			s2[i] = s1[i];
+			s1[i] = s;
+		}
+
+		if(++pos == sizeWin()){
+			finish(p);
+			done = true;
+		}
+	}
+	return done;
+}
+
+template <class T, class Td>
+template <class OnWindow>
+unsigned GoertzelBank<T,Td>::operator()(
+	const T * input, unsigned numSamples, OnWindow onWindow
+){
+	unsigned count = 0;
+	for(unsigned i=0; i<numSamples; ++i){
+		if((*this)(input[i])){
+			++count;
+			onWindow();
+		}
+	}
+	return count;
+}
+
 } // gam::
 #endif
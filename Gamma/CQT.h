@@ -0,0 +1,139 @@
+#ifndef GAMMA_CQT_H_INC
+#define GAMMA_CQT_H_INC
+
+/*	Gamma - Generic processing library
+	See COPYRIGHT file for authors and license information */
+
+#include "Gamma/Domain.h"
+#include "Gamma/Types.h"
+
+namespace gam{
+
+/// Constant-Q transform
+
+/// This computes a spectrum with logarithmically spaced frequency bins whose
+/// bandwidths are proportional to their center frequencies. It uses the
+/// sparse spectral kernel method on top of RFFT. The kernel of one octave is
+/// precomputed and applied to the transform of the highest octave. Each lower
+/// octave is analyzed with the same kernel after repeatedly decimating the
+/// input by two with a halfband lowpass, so all FFTs have the same small size.
+/// Kernels are shared between all CQTs with the same configuration.
+///
+/// Octave o, counting down from the highest, computes a new frame every
+/// 2^o hops with a hop of 2^o times the hop size in input samples, so the
+/// time resolution of each octave matches its atom lengths. The atoms of all
+/// octaves are aligned exactly in time. A sinusoid of amplitude A at a bin's
+/// center frequency gives that bin a magnitude of A/2.
+///
+/// With a non-zero gamma, bandwidths are alpha*f + gamma instead of alpha*f
+/// (variable-Q), which shortens the atoms of low bins. Each octave then has
+/// its own kernel.
+///
+/// The inverse transform is approximate. It applies the conjugate kernels
+/// with a per-frequency gain correction, overlap-adds the result of each
+/// octave, and upsamples and sums the octaves. Its quality degrades with
+/// larger hops; the default hop of a quarter of the shortest atom gives
+/// reconstruction errors around -50 dB within the analyzed frequency range.
+/// Content outside the range is attenuated.
+///
+/// The frequency of the highest bin should be no more than about 0.8 times
+/// the Nyquist frequency to leave room for the decimation filters.
+///
+/// \ingroup Spectral
+class CQT : public DomainObserver{
+public:
+
+	/// \param[in] minFreq			center frequency of lowest bin, in Hz
+	/// \param[in] numOctaves		number of octaves
+	/// \param[in] binsPerOctave	number of bins per octave
+	/// \param[in] hopSize			samples between frames of the highest
+	///								octave; 0 chooses a quarter of the
+	///								shortest atom
+	/// \param[in] qScale			bandwidth scale; 1 spaces the bins one
+	///								bandwidth apart
+	/// \param[in] gamma			bandwidth offset, in Hz, for variable-Q
+	CQT(double minFreq=55, unsigned numOctaves=8, unsigned binsPerOctave=24,
+		unsigned hopSize=0, double qScale=1, double gamma=0);
+
+	~CQT();
+
+
+	/// Set parameters; see constructor for their description
+	void resize(double minFreq, unsigned numOctaves, unsigned binsPerOctave,
+		unsigned hopSize=0, double qScale=1, double gamma=0);
+
+	/// Input next time-domain sample
+
+	/// \returns whether a new frame is available. The highest
+	/// octavesUpdated() octaves of the frame have new values.
+	bool operator()(float input);
+
+	/// Compute inverse transform of octaves updated in current frame
+
+	/// This must be called after every frame to resynthesize. The output is
+	/// sizeHop() samples which can be read through operator()().
+	///
+	/// \param[out] dst		optional array to copy sizeHop() samples into
+	void inverse(float * dst=0);
+
+	/// Get next sample of inverse transform output
+	float operator()();
+
+	/// Clear all input history and output
+	void reset();
+
+
+	/// Get pointer to bins, ordered from lowest to highest frequency
+	Complex<float> * bins();
+	const Complex<float> * bins() const;
+
+	/// Get reference to bin value
+	Complex<float>& bin(unsigned k){ return bins()[k]; }
+	const Complex<float>& bin(unsigned k) const { return bins()[k]; }
+
+	/// Get center frequency of a bin, in Hz
+	double binFreq(unsigned k) const;
+
+	/// Get bandwidth of a bin, in Hz
+	double binWidth(unsigned k) const;
+
+	/// Get number of octaves updated in the current frame, from the highest
+	unsigned octavesUpdated() const;
+
+	/// Get index of lowest bin updated in the current frame
+	unsigned binsUpdatedFrom() const;
+
+
+	unsigned numBins() const;		///< Get number of bins
+	unsigned numOctaves() const;	///< Get number of octaves
+	unsigned binsPerOctave() const;	///< Get number of bins per octave
+	unsigned sizeHop() const;		///< Get hop size of highest octave, in samples
+	unsigned sizeFFT() const;		///< Get size of the FFT of each octave
+	double minFreq() const;			///< Get center frequency of lowest bin
+	double qScale() const;			///< Get bandwidth scale
+	double gamma() const;			///< Get variable-Q bandwidth offset
+
+	/// Get delay of frame centers, in samples
+
+	/// The center of the current frame is the input sample latency() samples
+	/// before the next one.
+	unsigned latency() const;
+
+	/// Get delay from an input sample to its resynthesis, in samples
+
+	/// This assumes that operator()() is called once after each input sample.
+	///
+	unsigned latencyInverse() const;
+
+	void onDomainChange(double r);
+
+private:
+	class Impl; Impl * mImpl;
+
+	CQT(const CQT&);
+	CQT& operator= (const CQT&);
+};
+
+} // gam::
+
+#endif
@@ -77,12 +77,24 @@ int32_t floatToInt(float v);
 ///
 uint32_t floatToUInt(float v);
 
+/// Convert float to IEEE 754 half-precision (binary16) bits
+
+/// Rounds to nearest even. Values too large for half precision become
+/// infinity and values too small become subnormal or zero.
+uint16_t floatToHalf(float v);
+
 /// Converts linear integer phase to fraction
 
 ///	2^bits is the effective size of the lookup table. \n
 ///	Note: the fraction only has 24-bits of precision.
 float fraction(uint32_t bits, uint32_t phase);
 
+/// Convert IEEE 754 half-precision (binary16) bits to float
+
+/// The conversion is exact.
+///
+float halfToFloat(uint16_t v);
+
 /// Convert 16-bit signed integer to floating point in [-1, 1)
 float intToUnit(int16_t v);
 
@@ -203,11 +215,42 @@ inline float floatMantissa(float v){
 	return punUF(frac) - 1.f;
 }
 
+inline uint16_t floatToHalf(float v){
+	uint32_t x = punFU(v);
+	uint32_t sign = (x >> 16) & 0x8000;
+	uint32_t a = x & 0x7fffffff;
+
+	if(a >= 0x7f800000)	// Inf or NaN
+		return sign | 0x7c00 | (a > 0x7f800000 ? 0x200 : 0);
+	if(a >= 0x477ff000)	// rounds above max half, 65504
+		return sign | 0x7c00;
+	if(a < 0x38800000){	// subnormal half
+		// adding 0.5 aligns the float ulp with the half subnormal ulp, 2^-24
+		return sign | (punFU(punUF(a) + 0.5f) - 0x3f000000);
+	}
+
+	// rebias exponent and round mantissa to nearest even
+	a += ((15U - 127U) << 23) + 0xfff + ((a >> 13) & 1);
+	return sign | (a >> 13);
+}
+
 inline float fraction(uint32_t bits, uint32_t phase){	
 	phase = phase << bits >> 9 | Expo1<float>();
 	return punUF(phase) - 1.f;
 }
 
+inline float halfToFloat(uint16_t v){
+	uint32_t sign = uint32_t(v & 0x8000) << 16;
+	uint32_t a = v & 0x7fff;
+
+	if(a >= 0x7c00)		// Inf or NaN
+		return punUF(sign | 0x7f800000 | (a & 0x3ff) << 13);
+	if(a < 0x400)		// subnormal: a * 2^-24
+		return punUF(sign | punFU(punUF(0x3f000000 | a) - 0.5f));
+
+	return punUF(sign | ((a << 13) + ((127U - 15U) << 23)));
+}
+
 inline float intToUnit(int16_t v){
 	uint32_t vu = (((uint32_t)v) + 0x808000) << 7; // set fraction in float [2, 4)
 	return punUF(vu) - 3.f;
@@ -0,0 +1,92 @@
+#ifndef GAMMA_CONVOLVER_H_INC
+#define GAMMA_CONVOLVER_H_INC
+
+/*	Gamma - Generic processing library
+	See COPYRIGHT file for authors and license information */
+
+namespace gam{
+
+/// Partitioned FFT convolution with a fixed impulse response
+
+/// The impulse response is split into partitions that are convolved with the
+/// input by uniformly partitioned overlap-save in the frequency domain.
+/// The first partitions equal the block size, so the output has no latency
+/// beyond the host block. Later partitions double in size up to a maximum
+/// (non-uniform partitioning) so that long impulse responses need few
+/// transforms per block. If the maximum partition size equals the block size,
+/// the partitioning is uniform.
+///
+/// Partitions larger than the block size can optionally be computed on a
+/// background thread. A partition of size P has P samples of slack between
+/// being scheduled and its output being needed. If its computation has not
+/// started by then, the audio thread computes it itself; if it is still
+/// running, the audio thread waits for it. Either case is counted as a missed
+/// deadline.
+///
+/// \ingroup Spectral
+class Convolver{
+public:
+
+	Convolver();
+
+	/// \param[in] blockSize	number of samples per call to process;
+	///							should be a power of two
+	/// \param[in] ir			impulse response
+	/// \param[in] irSize		length of impulse response
+	/// \param[in] maxPartition	maximum partition size; rounded down to a
+	///							power-of-two multiple of the block size
+	Convolver(int blockSize, const float * ir, int irSize, int maxPartition=8192);
+
+	~Convolver();
+
+
+	/// Set block size and impulse response
+
+	/// This resets all internal state.
+	///
+	void setup(int blockSize, const float * ir, int irSize, int maxPartition=8192);
+
+	/// Set whether to compute long partitions on a background thread
+	void threaded(bool v);
+
+	/// Convolve a block of blockSize() samples
+
+	/// \param[in]	in		input samples
+	/// \param[out]	out		output samples; may be the same as input
+	void process(const float * in, float * out);
+
+	/// Clear all input history and pending output
+	void reset();
+
+
+	/// Get block size
+	int blockSize() const;
+
+	/// Get length of impulse response
+	int irSize() const;
+
+	/// Get number of partition levels
+	int numLevels() const;
+
+	/// Get partition size of a level
+	int partitionSize(int level) const;
+
+	/// Get number of partitions in a level
+	int numPartitions(int level) const;
+
+	/// Get whether long partitions are computed on a background thread
+	bool threaded() const;
+
+	/// Get number of background computations that missed their deadline
+	unsigned missedDeadlines() const;
+
+private:
+	class Impl; Impl * mImpl;
+
+	Convolver(const Convolver&);
+	Convolver& operator= (const Convolver&);
+};
+
+} // gam::
+
+#endif
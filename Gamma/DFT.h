@@ -4,6 +4,7 @@
 /*	Gamma - Generic processing library
 	See COPYRIGHT file for authors and license information */
 
+#include <vector>
 #include "Gamma/mem.h"			// *Ring functions
 #include "Gamma/tbl.h"			// WindowType
 #include "Gamma/Domain.h"
@@ -60,6 +61,19 @@ public:
 	/// 'dst' must have a size of at least sizeWin().
 	bool operator()(T * dst, T input);
 
+	/// Write sample into ring buffer without copying out the window
+
+	/// Returns true when sample window is ready to be processed. The window
+	/// can then be read from ring() starting at index tap() and wrapping
+	/// around at sizeWin().
+	bool write(T input);
+
+	/// Get ring buffer written by write()
+	const T * ring() const { return mBuf; }
+
+	/// Get index of oldest sample in ring buffer written by write()
+	unsigned tap() const { return mTapW; }
+
 protected:
 	void slide();	// Slides samples in window left by hop num samples
 	// After processing the window samples, a call to slide() must be made
@@ -250,6 +264,9 @@ public:
 	void print(FILE * fp=stdout, const char * append="\n");
 	
 protected:
+	void forwardTransform();		// transform forward buffer and convert spectrum
+	void inverseTransform();		// convert copy of spectrum and inverse transform it
+
 	unsigned mSizeWin;				// samples in analysis window
 	unsigned mSizeHop;				// samples between forward transforms (= winSize() for DFT)
 	SpectralType mSpctFormat;		// format of spectrum
@@ -259,6 +276,7 @@ protected:
 	// Buffers
 	float * mPadOA;			// Overlap-add buffer (alloc'ed only if zero-padded)
 	float * mBufInv;		// Pointer to inverse sample buffer
+	unsigned mInvPos;		// Start of current hop in inverse sample buffer
 	unsigned mTapW, mTapR;	// DFT i/o read/write taps
 	bool mPrecise;
 };
@@ -345,9 +363,17 @@ public:
 
 protected:
 	void computeInvWinMul();	// compute inverse normalization factor (due to overlap-add)
+	void resizeInvRing();		// resize overlap-add ring to fit hop and DFT size
+
+	// Copy windowed samples from ring 'src' starting at index 'start' into
+	// forward buffer, applying zero-phase rotation (if enabled) and zero-padding
+	void window(const float * src, unsigned start);
+	void analyze();				// forward transform and frequency estimation
 
 	SlidingWindow<float> mSlide;
 	float * mFwdWin;			// forward transform window
+	float * mInvWin;			// inverse window, including overlap-add normalization
+	unsigned mSizeInvRing;		// size of overlap-add ring, a multiple of hop size
 	float * mPhases;			// copy of current phases (mag-freq mode)
 	double * mAccums;			// phase accumulators (mag-freq mode)
 	WindowType mWinType;		// type of analysis window used
@@ -359,12 +385,154 @@ protected:
 
 
 
+/// Multichannel short-time Fourier transform
+
+/// This performs the same analysis and resynthesis as STFT on several
+/// channels in lockstep. All channels share one analysis window, inverse
+/// window and FFT plan, are transformed as a batch and produce spectral frames
+/// at the same hop. Bins are stored channel-major, i.e. all the bins of
+/// channel 0 followed by all the bins of channel 1 and so on.
+///
+/// \ingroup Spectral
+class MultiSTFT : public DomainObserver {
+public:
+
+	/// \param[in]	numChans	Number of channels
+	/// \param[in]	winSize		Number of samples to window
+	/// \param[in]	hopSize		Number of samples between successive windows
+	/// \param[in]	padSize		Number of zeros to append to window
+	/// \param[in]	winType		Type of forward transform window
+	/// \param[in]	specType	Format of spectrum data
+	MultiSTFT(unsigned numChans=2, unsigned winSize=1024, unsigned hopSize=256,
+		unsigned padSize=0,
+		WindowType winType = RECTANGLE,
+		SpectralType specType = COMPLEX
+	);
+
+
+	/// Input next sample of each channel
+
+	/// \param[in] input	one sample per channel
+	/// \returns whether new spectral frames are available
+	bool operator()(const float * input);
+
+	/// Get next resynthesized sample of each channel
+
+	/// \param[out] dst		one sample per channel
+	void output(float * dst);
+
+	/// Analyze and resynthesize a block of samples
+
+	/// 'onFrame' is called with no arguments each time new spectral frames are
+	/// available and before they are resynthesized.
+	/// \param[in]	input		array of numChannels() input blocks
+	/// \param[out]	output		array of numChannels() output blocks or 0 for
+	///							analysis only
+	/// \param[in]	numFrames	number of samples per block
+	/// \param[in]	onFrame		function object called on each spectral frame
+	template <class OnFrame>
+	void operator()(
+		const float * const * input, float * const * output,
+		unsigned numFrames, OnFrame onFrame);
+
+	/// Perform forward transform of current input windows
+	void forward();
+
+	/// Resynthesize current spectral frames into the overlap-add buffers
+	void inverse();
+
+
+	/// Set number of channels and window, hop and zero-padding size, in samples
+	void resize(unsigned numChans, unsigned winSize, unsigned hopSize, unsigned padSize=0);
+
+	/// Set window type
+	MultiSTFT& windowType(WindowType type);
+
+	/// Whether to apply a triangular window to inverse transform samples
+	MultiSTFT& inverseWindowing(bool v);
+
+	/// Set whether to use precise (but slower) polar conversion
+	MultiSTFT& precise(bool v){ mPrecise=v; return *this; }
+
+	/// Set format of spectrum data
+	MultiSTFT& spectrumType(SpectralType v){ mSpctFormat=v; return *this; }
+
+	/// Set number of threads used for the batched transforms
+	MultiSTFT& threads(unsigned n){ mFFT.batchThreads(n); return *this; }
+
+	/// Reset phases of all channels (MAG_FREQ format only)
+
+	/// \sa STFT::resetPhases
+	///
+	MultiSTFT& resetPhases();
+
+
+	/// Get pointer to bins of a channel
+	Complex<float> * bins(unsigned chan){
+		return (Complex<float> *)&mBufFwd[chan*stride()]; }
+	const Complex<float> * bins(unsigned chan) const {
+		return (const Complex<float> *)&mBufFwd[chan*stride()]; }
+
+	/// Get reference to bin value of a channel
+	Complex<float>& bin(unsigned chan, unsigned k){ return bins(chan)[k]; }
+	const Complex<float>& bin(unsigned chan, unsigned k) const { return bins(chan)[k]; }
+
+	/// Returns array of current analysis phases of a channel (MAG_FREQ format only)
+	float * phases(unsigned chan){ return &mPhases[chan*numBins()]; }
+
+	/// Returns array of current accumulator phases of a channel (MAG_FREQ format only)
+	double * accumPhases(unsigned chan){ return &mAccums[chan*numBins()]; }
+
+	unsigned numChannels() const { return mNumChans; }	///< Get number of channels
+	unsigned numBins() const { return (mSizeDFT+2)>>1; }///< Get number of frequency bins
+	unsigned sizeDFT() const { return mSizeDFT; }		///< Get size of transform, in samples
+	unsigned sizeWin() const { return mSizeWin; }		///< Get size of window
+	unsigned sizeHop() const { return mSizeHop; }		///< Get size of hop
+	unsigned sizePad() const { return mSizeDFT - mSizeWin; }///< Get size of zero-padding
+	double binFreq() const { return spu() / sizeDFT(); }///< Get width of frequency bins
+	double unitsHop() const { return sizeHop() * ups(); }///< Get hop size, in units
+	bool overlapping() const { return sizeHop() < sizeWin(); }///< Whether windows overlap
+
+protected:
+	unsigned stride() const { return mSizeDFT+2; }
+	void computeInvWin();
+
+	unsigned mNumChans, mSizeWin, mSizeHop, mSizeDFT;
+	SpectralType mSpctFormat;
+	WindowType mWinType;
+	float mInvWinMul;				// overlap-add normalization
+	RFFT<float> mFFT;
+	std::vector<float> mFwdWin;		// forward transform window
+	std::vector<float> mInvWin;		// inverse window including overlap-add normalization
+	std::vector<float> mBufIn;		// input rings, sizeWin() per channel
+	std::vector<float> mBufFwd;		// forward transforms/bins, stride() per channel
+	std::vector<float> mBufInv;		// inverse transforms, stride() per channel
+	std::vector<float> mBufOut;		// overlap-add rings, sizeDFT() per channel
+	std::vector<float> mPhases;		// copy of current phases (mag-freq mode)
+	std::vector<double> mAccums;	// phase accumulators (mag-freq mode)
+	unsigned mTapW, mHopCnt;		// input ring write tap and hop counter
+	unsigned mTapR, mOutCnt;		// output ring read tap and hop counter
+	bool mWindowInverse;
+	bool mPrecise;
+};
+
+
+
+
 /// Sliding discrete Fourier transform
 
 /// This transform computes the DFT with a fixed hop size of 1 sample and
 /// within a specified frequency interval. The computational complexity per
 /// sample is O(M), where M is the size, in samples, of the frequency interval.
 ///
+/// Each bin k is updated independently by the recursion
+///		X_k[n] = r e^(i 2pi k/N) X_k[n-1] + (x[n] - r^N x[n-N]) 2/N
+/// using a table of per-bin twiddle factors, so the bin loop has no
+/// loop-carried dependency and vectorizes. A damping factor r < 1 makes the
+/// recursion strictly stable at the cost of exponentially weighting the
+/// window. Rounding errors accumulate when r = 1; they are removed by
+/// periodically recomputing the bins exactly from the input history.
+///
 /// \ingroup Spectral
 template <class T>
 class SlidingDFT : public DFTBase<T> {
@@ -373,26 +541,52 @@ public:
 	/// \param[in] sizeDFT	transform size, in samples
 	/// \param[in] binLo	lower closed endpoint of frequency interval
 	/// \param[in] binHi	upper open endpoint of frequency interval
-	SlidingDFT(unsigned sizeDFT, unsigned binLo, unsigned binHi);
+	/// \param[in] damping	damping factor, r, in (0, 1]
+	SlidingDFT(unsigned sizeDFT, unsigned binLo, unsigned binHi, T damping=T(1));
 	
 	/// Input next sample and perform forward transform
 	void forward(T input);
+
+	/// Input a block of samples, performing a forward transform on each
+	void forward(const T * src, unsigned len);
+
+	/// Recompute bins exactly from the input history
+
+	/// This is an O(N log N) operation that removes accumulated rounding
+	/// error from the recursion.
+	void refresh();
 	
 	/// Set endpoints of frequency interval
+	
+	/// Bins in the new interval are computed exactly from the input history.
+	///
 	SlidingDFT& interval(unsigned binLo, unsigned binHi);
 
+	/// Set damping factor, r, in (0, 1]
+	SlidingDFT& damping(T r);
+
+	/// Set number of samples between automatic calls to refresh(); 0 disables
+	SlidingDFT& refreshInterval(unsigned samples){ mRefresh=samples; return *this; }
+
 	/// Resize transform
 	void resize(unsigned sizeDFT, unsigned binLo, unsigned binHi);
+
+	unsigned binLo() const { return mBinLo; }		///< Get lower endpoint of frequency interval
+	unsigned binHi() const { return mBinHi; }		///< Get upper endpoint of frequency interval
+	T damping() const { return mDamp; }				///< Get damping factor
+	unsigned refreshInterval() const { return mRefresh; }///< Get automatic refresh interval
 		
 protected:
 	unsigned mBinLo, mBinHi;
 	DelayN<T> mDelay;
-	//T * mBufI;				// alias to imaginaries
-	Complex<T> mF1;
-	Complex<T> mFL;
-	//double mC0, mS0;		// phasor rotators
-	//double mCL, mSL;		// low bin phasor
-	T mNorm;				// fwd transform normalization
+	std::vector<T> mTwiddles;	// per-bin r e^(i 2pi k/N), interleaved real/imag
+	RFFT<T> mFFT;				// for exact recomputation of bins
+	std::vector<T> mFFTBuf;
+	T mNorm;					// fwd transform normalization
+	T mDamp, mDampN;			// damping factor, r, and r^N
+	unsigned mRefresh, mCount;	// automatic refresh interval and counter
+
+	void computeTwiddles();
 };
 
 
@@ -470,11 +664,19 @@ inline bool SlidingWindow<T>::operator()(T input){
 
 template<class T>
 inline bool SlidingWindow<T>::operator()(T * output, T input){
+	if(write(input)){
+		mem::copyAllFromRing(mBuf, sizeWin(), mTapW, output);
+		return true;
+	}
+	return false;
+}
+
+template<class T>
+inline bool SlidingWindow<T>::write(T input){
 	mBuf[mTapW] = input;
 	if(++mTapW == sizeWin()) mTapW = 0; // increment tap and modulo window size
 
 	if(++mHopCnt == sizeHop()){
-		mem::copyAllFromRing(mBuf, sizeWin(), mTapW, output);
 		mHopCnt = 0;
 		return true;
 	}
@@ -598,7 +800,7 @@ inline float DFT::operator()(){
 		inverse();	// this is a virtual method
 		mTapR = 0;
 	}
-	return mBufInv[mTapR];
+	return mBufInv[mInvPos + mTapR];
 }
 
 inline bool DFT::inverseOnNext(){ return mTapR == (sizeHop() - 1); }
@@ -607,8 +809,9 @@ inline bool DFT::inverseOnNext(){ return mTapR == (sizeHop() - 1); }
 
 
 inline bool STFT::operator()(float input){
-	if(mSlide(bufFwdPos(), input)){
-		forward();
+	if(mSlide.write(input)){
+		window(mSlide.ring(), mSlide.tap());
+		analyze();
 		return true;
 	}
 	return false;
@@ -621,9 +824,69 @@ inline double * STFT::accumPhases(){ return mAccums; }
 
 
 
+inline bool MultiSTFT::operator()(const float * input){
+	for(unsigned c=0; c<mNumChans; ++c) mBufIn[c*mSizeWin + mTapW] = input[c];
+	if(++mTapW == mSizeWin) mTapW = 0;
+
+	if(++mHopCnt == mSizeHop){
+		mHopCnt = 0;
+		forward();
+		return true;
+	}
+	return false;
+}
+
+inline void MultiSTFT::output(float * dst){
+	if(++mOutCnt >= mSizeHop){
+		mOutCnt = 0;
+		inverse();
+	}
+
+	for(unsigned c=0; c<mNumChans; ++c){
+		float& o = mBufOut[c*mSizeDFT + mTapR];
+		dst[c] = o;
+		o = 0.f;
+	}
+	if(++mTapR == mSizeDFT) mTapR = 0;
+}
+
+template <class OnFrame>
+void MultiSTFT::operator()(
+	const float * const * input, float * const * output,
+	unsigned numFrames, OnFrame onFrame
+){
+	for(unsigned i=0; i<numFrames; ++i){
+		for(unsigned c=0; c<mNumChans; ++c) mBufIn[c*mSizeWin + mTapW] = input[c][i];
+		if(++mTapW == mSizeWin) mTapW = 0;
+
+		if(++mHopCnt == mSizeHop){
+			mHopCnt = 0;
+			forward();
+			onFrame();
+		}
+
+		if(output){
+			if(++mOutCnt >= mSizeHop){
+				mOutCnt = 0;
+				inverse();
+			}
+			for(unsigned c=0; c<mNumChans; ++c){
+				float& o = mBufOut[c*mSizeDFT + mTapR];
+				output[c][i] = o;
+				o = 0.f;
+			}
+			if(++mTapR == mSizeDFT) mTapR = 0;
+		}
+	}
+}
+
+
+
+
 template<class T>
-SlidingDFT<T>::SlidingDFT(unsigned sizeDFT, unsigned binLo, unsigned binHi)
-	: DFTBase<T>(), mBinLo(0), mBinHi(0), mDelay(0)
+SlidingDFT<T>::SlidingDFT(unsigned sizeDFT, unsigned binLo, unsigned binHi, T dampingA)
+:	DFTBase<T>(), mBinLo(0), mBinHi(0), mDelay(0),
+	mNorm(1), mDamp(dampingA), mDampN(1), mRefresh(1<<16), mCount(0)
 {
 	resize(sizeDFT, binLo, binHi);
 }
@@ -636,8 +899,13 @@ void SlidingDFT<T>::resize(unsigned sizeDFT, unsigned binLo, unsigned binHi){
 
 	mDelay.resize(sizeDFT);
 	mDelay.assign(T(0));
+	mDelay.reset();
+
+	mFFT.resize(sizeDFT);
+	mFFTBuf.assign(sizeDFT + 2, T(0));
 
 	this->mSizeDFT = sizeDFT;
+	mNorm = T(2) / T(this->sizeDFT());
 
 	interval(binLo, binHi);
 
@@ -646,33 +914,84 @@ void SlidingDFT<T>::resize(unsigned sizeDFT, unsigned binLo, unsigned binHi){
 
 template<class T>
 SlidingDFT<T>& SlidingDFT<T>::interval(unsigned binLo, unsigned binHi){
-	mBinLo = binLo;
-	mBinHi = binHi;
-	
-	double theta = M_2PI / this->sizeDFT();
+	mBinHi = scl::min(binHi, this->numBins());
+	mBinLo = scl::min(binLo, mBinHi);
+	computeTwiddles();
+	refresh();
+	return *this;
+}
 
-	mF1.fromPhase(theta);
-	mFL.fromPhase(theta*mBinLo);
-	mNorm = T(2) / T(this->sizeDFT());
+template<class T>
+SlidingDFT<T>& SlidingDFT<T>::damping(T r){
+	mDamp = r;
+	computeTwiddles();
+	refresh();
 	return *this;
 }
 
-//
+template<class T>
+void SlidingDFT<T>::computeTwiddles(){
+	double theta = M_2PI / this->sizeDFT();
+	mTwiddles.resize(2*(mBinHi - mBinLo));
+	for(unsigned k=mBinLo; k<mBinHi; ++k){
+		unsigned m = k - mBinLo;
+		// computed directly (not by recursion) so each has full precision
+		mTwiddles[2*m  ] = T(mDamp * ::cos(theta*k));
+		mTwiddles[2*m+1] = T(mDamp * ::sin(theta*k));
+	}
+	mDampN = T(::pow(double(mDamp), double(this->sizeDFT())));
+}
+
+template<class T>
+void SlidingDFT<T>::refresh(){
+	const unsigned N = this->sizeDFT();
+	if(!N) return;
+
+	// weighted history, newest first: y[j] = r^j x[n-j]
+	T * y = &mFFTBuf[1];
+	unsigned i = mDelay.pos();
+	T w = T(1);
+	for(unsigned j=0; j<N; ++j){
+		y[j] = mDelay[i] * w;
+		w *= mDamp;
+		i = (i ? i : N) - 1;
+	}
+
+	mFFT.forward(&mFFTBuf[0], true, false);
+
+	// forward FFT uses e^(-i...), bins use e^(+i...), so conjugate
+	for(unsigned k=mBinLo; k<mBinHi; ++k){
+		this->bin(k)( mFFTBuf[2*k] * mNorm, -mFFTBuf[2*k+1] * mNorm);
+	}
+
+	mCount = 0;
+}
+
 template<class T>
 inline void SlidingDFT<T>::forward(T input){
-	T dif = (input - mDelay(input)) * mNorm;	// ffd comb zeroes
-												// difference between temporal 'frames'
-	Complex<T> c = mFL;							// phasor at low bin
+	// ffd comb zeroes; difference between temporal 'frames'
+	const T dif = (input - mDampN * mDelay(input)) * mNorm;
 
 	// apply complex resonators:
-	// multiply freq samples by 1st harmonic (shift time signal)
+	// multiply freq samples by bin's harmonic (shift time signal)
 	// add time sample to all bins (set time sample at n=0)
-	
-	for(unsigned k=mBinLo; k<mBinHi; ++k){
-		Complex<T>& b = this->bins(k);
-		b = b*c + dif;
-		c *= mF1;
+	T * b = this->mBuf + 2*mBinLo;
+	const T * w = mTwiddles.data();
+	const unsigned M = mBinHi - mBinLo;
+
+	for(unsigned m=0; m<M; ++m){
+		T br = b[2*m], bi = b[2*m+1];
+		T wr = w[2*m], wi = w[2*m+1];
+		b[2*m  ] = br*wr - bi*wi + dif;
+		b[2*m+1] = br*wi + bi*wr;
 	}
+
+	if(mRefresh && ++mCount >= mRefresh) refresh();
+}
+
+template<class T>
+void SlidingDFT<T>::forward(const T * src, unsigned len){
+	for(unsigned i=0; i<len; ++i) forward(src[i]);
 }
 
 //template<class T>
@@ -4,6 +4,9 @@
 /*	Gamma - Generic processing library
 	See COPYRIGHT file for authors and license information */
 
+#include <algorithm>
+#include <initializer_list>
+#include <vector>
 #include "Gamma/ipl.h"
 #include "Gamma/scl.h"
 #include "Gamma/tbl.h"
@@ -73,6 +76,33 @@ public:
 	Tv read(float ago) const;					///< Returns element 'ago' units ago
 	void write(const Tv& v);					///< Writes new element into buffer
 
+	/// Filter a block of samples
+
+	/// This gives the same output as calling operator()(const Tv&) on each
+	/// sample. When the delay is a whole number of samples, or when linear
+	/// interpolation is used, the buffer is read and written in contiguous
+	/// spans that are only split where they wrap around. Other delays and
+	/// strategies read each sample through the interpolation strategy.
+	///
+	/// \param[in]	in		input samples
+	/// \param[out]	out		output samples; may equal in
+	/// \param[in]	n		number of samples
+	void process(const Tv * in, Tv * out, unsigned n);
+
+	/// Filter a block of samples in place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
+
+	/// Filter a block of samples while sweeping the delay length
+
+	/// The delay is interpolated linearly from its current value to delayEnd
+	/// across the block and is delayEnd after the last sample.
+	///
+	/// \param[in]	in			input samples
+	/// \param[out]	out			output samples; may equal in
+	/// \param[in]	n			number of samples
+	/// \param[in]	delayEnd	delay length at end of block
+	void process(const Tv * in, Tv * out, unsigned n, float delayEnd);
+
 	/// Copy delay elements to another array
 
 	/// \param[out] dst		array to copy element to
@@ -82,6 +112,18 @@ public:
 	template <class V>
 	void read(V * dst, unsigned len, unsigned end=0) const;
 
+	/// Read a block of delayed elements from the last writes
+
+	/// Element i is what read(ago) returned right after the i-th of the last
+	/// n writes, so writing a block and then reading it gives the delayed
+	/// block. The delay plus n must not exceed the buffer size. With linear
+	/// interpolation, the buffer is read in contiguous spans.
+	///
+	/// \param[out] dst	n delayed elements
+	/// \param[ in] n		number of elements
+	/// \param[ in] ago	delay length
+	void readBlock(Tv * dst, unsigned n, float ago) const;
+
 	float delay() const;						///< Get current delay length
 	uint32_t delaySamples() const;				///< Get current delay length in samples
 	float delaySamplesR() const;				///< Get current delay length in samples (real-valued)
@@ -109,12 +151,22 @@ protected:
 	void incPhase();				// increment phase
 	void refreshDelayFactor();
 	uint32_t delayFToI(float v) const; // convert f.p. delay to fixed-point
+
+	// Run n samples through the delay line, writing f(i, delayed) for each
+	// sample i after reading its delayed value
+	template <class F> void circulate(unsigned n, F f);
+
+	// Same as circulate, while sweeping the delay to delayEnd
+	template <class F> void sweep(unsigned n, float delayEnd, F f);
 };
 
 
 
 /// Variable delay-line with multiple read taps
 
+/// With linear interpolation, block processing writes the input block first
+/// and then accumulates each tap in turn over contiguous spans.
+///
 /// \ingroup Delay
 ///
 template <
@@ -140,6 +192,14 @@ public:
 		return this->mIpol(*this, this->mPhase - mDelays[tap]);
 	}
 
+	/// Read samples from all taps, without gains
+
+	/// \param[out] dst		taps() samples, one per tap
+	void readTaps(Tv * dst) const;
+
+	/// Read sum of all taps weighted by their gains
+	Tv readSum() const;
+
 	/// Set delay length
 	void delay(float length, unsigned tap){
 		mDelays[tap] = this->delayFToI(length);
@@ -150,11 +210,178 @@ public:
 		delay(1.f/v, tap);
 	}
 
+	/// Set a tap's gain, used by readSum()
+	void gain(float v, unsigned tap){ mGains[tap] = v; }
+
+	/// Get a tap's gain
+	float gain(unsigned tap) const { return mGains[tap]; }
+
 	/// Set number of read taps
-	void taps(unsigned numTaps){ mDelays.resize(numTaps); }
+
+	/// New taps have a gain of 1.
+	///
+	void taps(unsigned numTaps){
+		mDelays.resize(numTaps);
+		mGains.resize(numTaps, 1.f);
+	}
+
+	/// Filter a block of samples into the weighted sum of taps
+
+	/// For each sample, readSum() is output and then the input is written.
+	///
+	/// \param[in]	in		input samples
+	/// \param[out]	out		output samples; may equal in
+	/// \param[in]	n		number of samples
+	void process(const Tv * in, Tv * out, unsigned n);
+
+	/// Filter a block of samples in place into the weighted sum of taps
+	void process(Tv * io, unsigned n){ process(io, io, n); }
+
+	/// Filter a block of samples into separate taps
+
+	/// \param[in]	in		input samples
+	/// \param[out]	out		n frames of taps() samples, one per tap
+	/// \param[in]	n		number of samples
+	void processTaps(const Tv * in, Tv * out, unsigned n){
+		for(unsigned i=0; i<n; ++i){
+			readTaps(out + i*taps());
+			this->write(in[i]);
+		}
+	}
 
 protected:
-	std::vector<unsigned> mDelays;
+	std::vector<uint32_t> mDelays;	// fixed-point delays
+	std::vector<float> mGains;
+
+	// Get number of samples that can be written ahead of reading all taps
+	unsigned writeAhead() const;
+};
+
+
+
+/// Delay lines sharing one block of memory
+
+/// All lines are allocated from one contiguous buffer. Each line occupies a
+/// power-of-two region starting at its own offset, aligned to a cache line,
+/// and all lines share one write index. Writing a frame to every line and
+/// reading each line at its own delay therefore only needs per-line offsets
+/// and masks, which are small arrays that a network of delay lines can
+/// process across lines at once.
+///
+/// Each sample period, read the lines and then write them before calling
+/// advance(), in the same order as Delay reads and writes.
+///
+/// \tparam Tv	Value (sample) type
+/// \ingroup Delay
+template <class Tv = gam::real>
+class DelayPool{
+public:
+
+	DelayPool(): mPos(0){}
+
+	/// \param[in]	maxDelays	maximum delay of each line, in samples
+	DelayPool(std::initializer_list<unsigned> maxDelays): mPos(0){
+		resize(maxDelays);
+	}
+
+	/// Copies are realigned to their own memory
+	DelayPool(const DelayPool& src): mPos(0){ *this = src; }
+	DelayPool(DelayPool&&) = default;
+
+	DelayPool& operator=(const DelayPool& src);
+	DelayPool& operator=(DelayPool&&) = default;
+
+
+	/// Allocate lines and zero them
+
+	/// \param[in]	maxDelays	maximum delay of each line, in samples
+	/// \param[in]	numLines	number of lines
+	void resize(const unsigned * maxDelays, unsigned numLines);
+
+	/// Allocate lines and zero them
+	void resize(std::initializer_list<unsigned> maxDelays){
+		resize(maxDelays.begin(), maxDelays.size());
+	}
+
+	/// Zero all lines
+	void zero();
+
+
+	/// Read a line at a delay, in [1, size(line)] samples
+	Tv read(unsigned line, unsigned delay) const {
+		return base()[mOffset[line] + ((mPos - delay) & mMask[line])];
+	}
+
+	/// Read a line at a fractional delay, in [1, size(line)-1] samples
+	Tv read(unsigned line, float delay) const {
+		unsigned d = unsigned(delay);
+		Tv x = read(line, d + 1);
+		return ipl::linear(delay - float(d), read(line, d), x);
+	}
+
+	/// Read all lines, each at its own delay
+
+	/// \param[out]	dst			one sample per line
+	/// \param[in]	delays		delay of each line, in samples
+	void read(Tv * dst, const unsigned * delays) const {
+		const Tv * b = base();
+		const unsigned * off = &mOffset[0];
+		const uint32_t * mask = &mMask[0];
+		for(unsigned l=0, n=lines(); l<n; ++l){
+			dst[l] = b[off[l] + ((mPos - delays[l]) & mask[l])];
+		}
+	}
+
+	/// Write a sample into a line at the write index
+	void write(unsigned line, const Tv& v){
+		base()[mOffset[line] + (mPos & mMask[line])] = v;
+	}
+
+	/// Write one sample into each line at the write index
+	void write(const Tv * src){
+		Tv * b = base();
+		const unsigned * off = &mOffset[0];
+		const uint32_t * mask = &mMask[0];
+		for(unsigned l=0, n=lines(); l<n; ++l){
+			b[off[l] + (mPos & mask[l])] = src[l];
+		}
+	}
+
+	/// Advance the shared write index by a number of samples
+	void advance(unsigned n=1){ mPos += n; }
+
+
+	/// Get number of lines
+	unsigned lines() const { return mOffset.size(); }
+
+	/// Get number of samples a line holds (a power of two)
+	unsigned size(unsigned line) const { return mMask[line] + 1; }
+
+	/// Get write index
+	uint32_t pos() const { return mPos; }
+
+	/// Get memory of a line, holding size(line) samples
+	Tv * data(unsigned line){ return base() + mOffset[line]; }
+	const Tv * data(unsigned line) const { return base() + mOffset[line]; }
+
+	/// Get per-line offsets into the shared memory, in samples
+	const unsigned * offsets() const { return &mOffset[0]; }
+
+	/// Get per-line index masks, one less than the line sizes
+	const uint32_t * masks() const { return &mMask[0]; }
+
+private:
+	std::vector<Tv> mMem;
+	unsigned mAlign = 0;			// index of first cache line aligned element
+	std::vector<unsigned> mOffset;
+	std::vector<uint32_t> mMask;
+	uint32_t mPos;					// shared write index
+
+	Tv * base(){ return &mMem[mAlign]; }
+	const Tv * base() const { return &mMem[mAlign]; }
+
+	// Set index of first aligned element of current memory
+	void align();
 };
 
 
@@ -308,6 +535,27 @@ public:
 
 	/// Filters sample (feedback only).
 	Tv nextFbk(const Tv& i0);
+
+	/// Filter a block of samples
+
+	/// This gives the same output as calling operator()(const Tv&) on each
+	/// sample and reads the buffer in contiguous spans like Delay::process.
+	///
+	/// \param[in]	in		input samples
+	/// \param[out]	out		output samples; may equal in
+	/// \param[in]	n		number of samples
+	void process(const Tv * in, Tv * out, unsigned n);
+
+	/// Filter a block of samples in place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
+
+	/// Filter a block of samples while sweeping the delay length
+
+	/// \param[in]	in			input samples
+	/// \param[out]	out			output samples; may equal in
+	/// \param[in]	n			number of samples
+	/// \param[in]	delayEnd	delay length at end of block
+	void process(const Tv * in, Tv * out, unsigned n, float delayEnd);
 	
 	float norm() const;				///< Get unity gain scale factor
 	float normFbk() const;			///< Get unity gain scale factor due to feedback
@@ -430,6 +678,139 @@ void Delay<TM2>::read(V * dst, unsigned len, unsigned end) const {
 	}
 }
 
+TM1 void Delay<TM2>::readBlock(Tv * dst, unsigned n, float ago) const {
+	if(!n) return;
+	const uint32_t one = this->oneIndex();
+	uint32_t p = mPhase - delayFToI(ago) - (n-1)*one;
+	if(mIpol.type() != ipl::LINEAR){
+		for(unsigned i=0; i<n; ++i){ dst[i] = mIpol(*this, p); p += one; }
+		return;
+	}
+	// Consecutive elements share one fraction
+	const unsigned size = this->size();
+	const float frac = this->fraction(p);
+	const Tv * buf = this->elems();
+	unsigned r = this->index(p);
+	unsigned i = 0;
+	while(i < n){
+		// Spans end where the second element of a pair would wrap
+		unsigned k = n - i;
+		if(k > size - r - 1) k = size - r - 1;
+		if(0 == k){
+			dst[i] = ipl::linear(frac, buf[r], buf[0]);
+			r = 0; ++i;
+			continue;
+		}
+		const Tv * x = buf + r;
+		Tv * o = dst + i;
+		for(unsigned j=0; j<k; ++j) o[j] = ipl::linear(frac, x[j], x[j+1]);
+		r += k; i += k;
+	}
+}
+
+TM1
+template <class F>
+void Delay<TM2>::circulate(unsigned n, F f){
+	const uint32_t fracMask = this->oneIndex() - 1;
+	const ipl::Type type = mIpol.type();
+	bool whole = (mDelay & fracMask) == 0;
+	// These strategies return the element itself at whole positions
+	bool exact = type == ipl::TRUNC || type == ipl::ROUND || type == ipl::LINEAR || type == ipl::CUBIC;
+
+	if(whole && exact){
+		const unsigned size = this->size();
+		Tv * buf = this->elems();
+		unsigned i = 0;
+		while(i < n){
+			unsigned w = this->index(mPhase);
+			unsigned r = this->index(mPhase - mDelay);
+			unsigned m = n - i;
+			if(m > size - w) m = size - w;
+			if(m > size - r) m = size - r;
+			Tv * bw = buf + w;
+			const Tv * br = buf + r;
+			for(unsigned k=0; k<m; ++k){
+				Tv d = br[k];
+				bw[k] = f(i+k, d);
+			}
+			mPhase += m * mPhaseInc;
+			i += m;
+		}
+	}
+
+	else if(type == ipl::LINEAR){
+		// The fraction stays the same across the block. Spans end where the
+		// second element of a pair would wrap around.
+		const unsigned size = this->size();
+		const float frac = this->fraction(mPhase - mDelay);
+		Tv * buf = this->elems();
+		unsigned i = 0;
+		while(i < n){
+			unsigned w = this->index(mPhase);
+			unsigned r = this->index(mPhase - mDelay);
+			unsigned m = n - i;
+			if(m > size - w) m = size - w;
+			if(m > size - r - 1) m = size - r - 1;
+			if(0 == m){
+				Tv d = (*this)();
+				write(f(i, d));
+				++i;
+				continue;
+			}
+			Tv * bw = buf + w;
+			const Tv * br = buf + r;
+			for(unsigned k=0; k<m; ++k){
+				Tv d = ipl::linear(frac, br[k], br[k+1]);
+				bw[k] = f(i+k, d);
+			}
+			mPhase += m * mPhaseInc;
+			i += m;
+		}
+	}
+
+	else{
+		for(unsigned i=0; i<n; ++i){
+			Tv d = (*this)();
+			write(f(i, d));
+		}
+	}
+}
+
+TM1
+template <class F>
+void Delay<TM2>::sweep(unsigned n, float delayEnd, F f){
+	if(0 == n){
+		delay(delayEnd);
+		return;
+	}
+	uint32_t end = delayFToI(delayEnd);
+	int64_t dly = mDelay;
+	int64_t inc = (int64_t(end) - dly) / int64_t(n);
+	for(unsigned i=0; i<n; ++i){
+		dly += inc;
+		mDelay = uint32_t(i+1 < n ? dly : end);
+		Tv d = (*this)();
+		write(f(i, d));
+	}
+	mDelayLength = delayEnd;
+}
+
+TM1 void Delay<TM2>::process(const Tv * in, Tv * out, unsigned n){
+	circulate(n, [in, out](unsigned i, const Tv& d){
+		Tv v = in[i];
+		out[i] = d;
+		return v;
+	});
+}
+
+TM1 void Delay<TM2>::process(const Tv * in, Tv * out, unsigned n, float delayEnd){
+	sweep(n, delayEnd, [in, out](unsigned i, const Tv& d){
+		Tv v = in[i];
+		out[i] = d;
+		return v;
+	});
+}
+
 TM1 void Delay<TM2>::refreshDelayFactor(){ mDelayFactor = 1./maxDelay(); }
 
 TM1 inline void Delay<TM2>::write(const Tv& v){
@@ -499,6 +880,175 @@ TM1 void Delay<TM2>::print(){
 
 
 
+#define TM1 template<class Tv, template<class> class Si, class Td>
+#define TM2 Tv,Si,Td
+
+TM1 void Multitap<TM2>::readTaps(Tv * dst) const {
+	const unsigned num = taps();
+	if(this->mIpol.type() == ipl::LINEAR){
+		const uint32_t bits = this->log2Size();
+		const uint32_t fbits = this->fracBits();
+		const uint32_t mask = this->size() - 1;
+		const uint32_t phase = this->mPhase;
+		const uint32_t * dly = &mDelays[0];
+		const Tv * buf = this->elems();
+		for(unsigned t=0; t<num; ++t){
+			uint32_t p = phase - dly[t];
+			uint32_t i = p >> fbits;
+			dst[t] = ipl::linear(gam::fraction(bits, p), buf[i], buf[(i+1) & mask]);
+		}
+	}
+	else{
+		for(unsigned t=0; t<num; ++t) dst[t] = read(t);
+	}
+}
+
+TM1 Tv Multitap<TM2>::readSum() const {
+	const unsigned num = taps();
+	const float * g = &mGains[0];
+	Tv s = Tv(0);
+	if(this->mIpol.type() == ipl::LINEAR){
+		const uint32_t bits = this->log2Size();
+		const uint32_t fbits = this->fracBits();
+		const uint32_t mask = this->size() - 1;
+		const uint32_t phase = this->mPhase;
+		const uint32_t * dly = &mDelays[0];
+		const Tv * buf = this->elems();
+		for(unsigned t=0; t<num; ++t){
+			uint32_t p = phase - dly[t];
+			uint32_t i = p >> fbits;
+			s += ipl::linear(gam::fraction(bits, p), buf[i], buf[(i+1) & mask]) * g[t];
+		}
+	}
+	else{
+		for(unsigned t=0; t<num; ++t) s += read(t) * g[t];
+	}
+	return s;
+}
+
+TM1 unsigned Multitap<TM2>::writeAhead() const {
+	if(this->mIpol.type() != ipl::LINEAR || mDelays.empty()) return 0;
+	uint32_t lo = mDelays[0], hi = mDelays[0];
+	for(auto d : mDelays){
+		if(d < lo) lo = d;
+		if(d > hi) hi = d;
+	}
+	// Reading before writing lets a tap under one sample see the oldest
+	// sample, which writing ahead would overwrite
+	if(lo < this->oneIndex()) return 0;
+	// A tap reads up to one sample beyond its delay
+	unsigned back = (hi >> this->fracBits()) + 1;
+	return back < this->size() ? this->size() - back : 0;
+}
+
+TM1 void Multitap<TM2>::process(const Tv * in, Tv * out, unsigned n){
+	const unsigned ahead = writeAhead();
+	if(0 == ahead){
+		for(unsigned i=0; i<n; ++i){
+			Tv v = in[i];
+			out[i] = readSum();
+			this->write(v);
+		}
+		return;
+	}
+
+	const unsigned size = this->size();
+	const unsigned num = taps();
+	Tv * buf = this->elems();
+
+	while(n){
+		unsigned m = n < ahead ? n : ahead;
+		uint32_t phase = this->mPhase;
+
+		// Write whole block before out is touched, as it may equal in
+		for(unsigned i=0; i<m; ++i) this->write(in[i]);
+		for(unsigned i=0; i<m; ++i) out[i] = Tv(0);
+
+		for(unsigned t=0; t<num; ++t){
+			const uint32_t p = phase - mDelays[t];
+			const float frac = this->fraction(p);
+			const float g = mGains[t];
+			unsigned r = this->index(p);
+			unsigned i = 0;
+			while(i < m){
+				// Spans end where the second element of a pair would wrap
+				unsigned k = m - i;
+				if(k > size - r - 1) k = size - r - 1;
+				if(0 == k){
+					out[i] += ipl::linear(frac, buf[r], buf[0]) * g;
+					r = 0; ++i;
+					continue;
+				}
+				const Tv * x = buf + r;
+				Tv * o = out + i;
+				for(unsigned j=0; j<k; ++j) o[j] += ipl::linear(frac, x[j], x[j+1]) * g;
+				r += k; i += k;
+			}
+		}
+		in += m; out += m; n -= m;
+	}
+}
+
+#undef TM1
+#undef TM2
+
+
+
+
+template <class Tv>
+void DelayPool<Tv>::align(){
+	const unsigned align = 64;
+	uintptr_t addr = uintptr_t(mMem.data());
+	uintptr_t pad = (align - addr % align) % align;
+	mAlign = pad % sizeof(Tv) ? 0 : pad / sizeof(Tv);
+}
+
+template <class Tv>
+DelayPool<Tv>& DelayPool<Tv>::operator=(const DelayPool& src){
+	if(this == &src) return *this;
+	mMem.resize(src.mMem.size());
+	align();
+	if(mMem.size()){
+		// the two may be aligned at different indices, so copy from base to
+		// base over the part both can hold
+		unsigned n = mMem.size() - (mAlign > src.mAlign ? mAlign : src.mAlign);
+		std::copy(src.base(), src.base() + n, base());
+	}
+	mOffset = src.mOffset;
+	mMask = src.mMask;
+	mPos = src.mPos;
+	return *this;
+}
+
+template <class Tv>
+void DelayPool<Tv>::resize(const unsigned * maxDelays, unsigned numLines){
+	// Lines start on cache line boundaries so one line's end does not share
+	// a cache line with the next line's start
+	const unsigned align = 64;
+	const unsigned grain = sizeof(Tv) < align ? align/sizeof(Tv) : 1;
+
+	mOffset.resize(numLines);
+	mMask.resize(numLines);
+	unsigned total = 0;
+	for(unsigned l=0; l<numLines; ++l){
+		unsigned n = 1;
+		while(n < maxDelays[l]) n <<= 1;
+		mOffset[l] = total;
+		mMask[l] = n - 1;
+		total += (n + grain - 1) / grain * grain;
+	}
+
+	mMem.assign(total + grain, Tv(0));
+	this->align();
+	mPos = 0;
+}
+
+template <class Tv>
+void DelayPool<Tv>::zero(){
+	for(auto& v : mMem) v = Tv(0);
+}
+
+
 
 #define TM1 template<class Tv, template<class> class Si, class Tp, class Td>
 #define TM2 Tv,Si,Tp,Td
@@ -535,6 +1085,24 @@ TM1 inline Tv Comb<TM2>::circulateFbk(const Tv& i0, const Tv& oN){
 TM1 inline Tv Comb<TM2>::nextFbk(const Tv& i0){
 	return circulateFbk(i0, (*this)()); }
 
+TM1 void Comb<TM2>::process(const Tv * in, Tv * out, unsigned n){
+	const Tp fb = mFBK, ff = mFFD;
+	this->circulate(n, [in, out, fb, ff](unsigned i, const Tv& oN){
+		Tv t = in[i] + oN * fb;
+		out[i] = oN + t * ff;
+		return t;
+	});
+}
+
+TM1 void Comb<TM2>::process(const Tv * in, Tv * out, unsigned n, float delayEnd){
+	const Tp fb = mFBK, ff = mFFD;
+	this->sweep(n, delayEnd, [in, out, fb, ff](unsigned i, const Tv& oN){
+		Tv t = in[i] + oN * fb;
+		out[i] = oN + t * ff;
+		return t;
+	});
+}
+
 TM1 inline void Comb<TM2>::decay(float units, float end){
 	mFBK = pow(end, this->delay() / scl::abs(units));
 	if(units < 0.f) mFBK = -mFBK;
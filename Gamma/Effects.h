@@ -270,6 +270,27 @@ public:
 	T operator()(T in){
 		return (hil(in) * mod()).r;
 	}
+
+	/// Frequency shift a block of samples
+
+	/// \param[in]	in		input samples
+	/// \param[out]	out		output samples; may equal in
+	/// \param[in]	n		number of samples
+	void process(const T * in, T * out, unsigned n){
+		T re[64], im[64];
+		while(n){
+			unsigned nb = n < 64 ? n : 64;
+			hil.process(in, re, im, nb);
+			for(unsigned i=0; i<nb; ++i){
+				Complex<T> m = mod();
+				out[i] = re[i]*m.r - im[i]*m.i;
+			}
+			in += nb; out += nb; n -= nb;
+		}
+	}
+
+	/// Frequency shift a block of samples in place
+	void process(T * io, unsigned n){ process(io, io, n); }
 	
 	/// Set frequency shift amount
 	FreqShift& freq(T v){ mod.freq(v); return *this; }
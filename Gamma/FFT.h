@@ -40,6 +40,41 @@ public:
 	template <template <class> class ComplexType>
 	void inverse(ComplexType<T> * buf){ inverse((T*)buf); }
 
+	/// Perform forward transforms in-place on several buffers
+
+	/// All buffers are transformed with the same plan back-to-back and, if
+	/// batchThreads() is greater than one, the batch is split across threads.
+	/// \param[in,out] bufs		array of pointers to input/output buffers
+	/// \param[in] count		number of buffers
+	/// \param[in] normalize	whether to scale magnitudes by 1/N
+	/// \param[in] nrmGain		gain to apply if normalizing
+	void forwardBatch(T * const * bufs, int count, bool normalize=true, T nrmGain=1.);
+
+	/// Perform forward transforms in-place on a strided block of buffers
+
+	/// \param[in,out] block	first input/output buffer
+	/// \param[in] count		number of buffers
+	/// \param[in] stride		number of elements between starts of successive buffers
+	/// \param[in] normalize	whether to scale magnitudes by 1/N
+	/// \param[in] nrmGain		gain to apply if normalizing
+	void forwardBatch(T * block, int count, int stride, bool normalize=true, T nrmGain=1.);
+
+	/// Perform inverse transforms in-place on several buffers
+	void inverseBatch(T * const * bufs, int count);
+
+	/// Perform inverse transforms in-place on a strided block of buffers
+	void inverseBatch(T * block, int count, int stride);
+
+	/// Set number of threads used by batch transforms
+
+	/// Helper threads and their scratch memory are created here and kept
+	/// until the thread count changes, so batch transforms neither start
+	/// threads nor allocate and can run on the audio thread.
+	void batchThreads(int n);
+
+	/// Get number of threads used by batch transforms
+	int batchThreads() const;
+
 	/// Set size of transform
 	void resize(int n);
 
@@ -90,6 +125,43 @@ public:
 	///									output is [x0, x1, x2, ..., x(n)  ].
 	void inverse(T * buf, bool complexBuf=false);
 
+	/// Perform real-to-complex forward transforms in-place on several buffers
+
+	/// All buffers are transformed with the same plan back-to-back and, if
+	/// batchThreads() is greater than one, the batch is split across threads.
+	/// \param[in,out]	bufs		array of pointers to input/output buffers
+	/// \param[in]		count		number of buffers
+	/// \param[in]		complexBuf	buffer format (\sa forward)
+	/// \param[in]		normalize	whether to scale magnitudes by 1/N
+	/// \param[in]		nrmGain		gain to apply if normalizing
+	void forwardBatch(T * const * bufs, int count, bool complexBuf=false, bool normalize=true, T nrmGain=1.);
+
+	/// Perform real-to-complex forward transforms in-place on a strided block of buffers
+
+	/// \param[in,out]	block		first input/output buffer
+	/// \param[in]		count		number of buffers
+	/// \param[in]		stride		number of elements between starts of successive buffers
+	/// \param[in]		complexBuf	buffer format (\sa forward)
+	/// \param[in]		normalize	whether to scale magnitudes by 1/N
+	/// \param[in]		nrmGain		gain to apply if normalizing
+	void forwardBatch(T * block, int count, int stride, bool complexBuf=false, bool normalize=true, T nrmGain=1.);
+
+	/// Perform complex-to-real inverse transforms in-place on several buffers
+	void inverseBatch(T * const * bufs, int count, bool complexBuf=false);
+
+	/// Perform complex-to-real inverse transforms in-place on a strided block of buffers
+	void inverseBatch(T * block, int count, int stride, bool complexBuf=false);
+
+	/// Set number of threads used by batch transforms
+
+	/// Helper threads and their scratch memory are created here and kept
+	/// until the thread count changes, so batch transforms neither start
+	/// threads nor allocate and can run on the audio thread.
+	void batchThreads(int n);
+
+	/// Get number of threads used by batch transforms
+	int batchThreads() const;
+
 	/// Set size of transform
 	void resize(int n);
 	
@@ -0,0 +1,655 @@
+#ifndef GAMMA_FIR_H_INC
+#define GAMMA_FIR_H_INC
+
+/*	Gamma - Generic processing library
+	See COPYRIGHT file for authors and license information
+
+	File Description:
+	Direct-form FIR filters with polyphase decimation and interpolation.
+*/
+
+#include <vector>
+#include "Gamma/scl.h"
+#include "Gamma/tbl.h"
+#include "Gamma/Types.h"
+
+namespace gam{
+
+/// Design linear-phase lowpass FIR filter by the window method
+
+/// The coefficients are a sinc function truncated by a window and normalized
+/// to unit gain at DC. Windows are symmetric about the center tap and do not
+/// have zero end points, so no taps are wasted. The transition band is about
+/// as wide as the window's main lobe, e.g. 8/len for BLACKMAN_HARRIS, and is
+/// centered on the cutoff.
+///
+/// \param[out] dst		output coefficients
+/// \param[in] len		number of coefficients; odd lengths have an integer delay
+/// \param[in] cutoff	cutoff frequency, as a fraction of the sample rate
+/// \param[in] win		window type
+/// \ingroup Filter
+template <class T>
+void firLowpass(T * dst, unsigned len, double cutoff, WindowType win=BLACKMAN_HARRIS);
+
+
+
+/// Dot product of coefficients and samples
+
+/// This accumulates into independent partial sums in a fixed-size lane loop,
+/// which the compiler vectorizes without reassociating floating-point
+/// additions.
+///
+/// \ingroup Filter
+template <class Tv, class Tp>
+Tv firDot(const Tp * h, const Tv * x, unsigned len);
+
+
+
+/// Doubled circular history of the newest samples
+
+/// Each sample is written twice, len samples apart, so that the newest len
+/// samples are always contiguous in memory, newest first. This lets
+/// convolutions run as plain dot products without checking for wrap-around.
+///
+/// \ingroup Filter
+template <class Tv=real>
+class FIRHistory{
+public:
+
+	/// \param[in] len		number of samples to hold
+	explicit FIRHistory(unsigned len=0){ resize(len); }
+
+	/// Set number of samples to hold and zero history
+	void resize(unsigned len){
+		mBuf.assign(2*len, Tv(0));
+		mLen = len;
+		mPos = 0;
+	}
+
+	/// Zero history
+	void zero(){ mBuf.assign(mBuf.size(), Tv(0)); }
+
+	/// Write next sample; does nothing if the history holds no samples
+	void write(Tv v){
+		if(!mLen) return;
+		mPos = (mPos ? mPos : mLen) - 1;
+		mBuf[mPos] = mBuf[mPos + mLen] = v;
+	}
+
+	/// Get pointer to newest sample; older samples follow
+	const Tv * newest() const { return mBuf.data() + mPos; }
+
+	/// Get i-th newest sample
+	const Tv& operator[](unsigned i) const { return mBuf[mPos + i]; }
+
+	/// Get dot product of coefficients with the newest len samples
+	template <class Tp>
+	Tv dot(const Tp * h, unsigned len) const { return firDot(h, newest(), len); }
+
+	/// Get number of samples held
+	unsigned size() const { return mLen; }
+
+private:
+	std::vector<Tv> mBuf;
+	unsigned mLen, mPos;
+};
+
+
+
+/// Direct-form FIR filter
+
+/// The output is the convolution of the input with the coefficients h,
+///
+///		y[n] = h[0] x[n] + h[1] x[n-1] + ... + h[N-1] x[n-N+1].
+///
+/// The input history is kept in a FIRHistory so each output is a single
+/// contiguous dot product. With no coefficients the output is zero.
+///
+/// \tparam Tv	value type
+/// \tparam Tp	coefficient type
+/// \ingroup Filter
+template <class Tv=real, class Tp=real>
+class FIR{
+public:
+
+	FIR(){}
+
+	/// \param[in] h		coefficients
+	/// \param[in] len		number of coefficients
+	FIR(const Tp * h, unsigned len){ coefs(h, len); }
+
+
+	/// Set coefficients
+
+	/// The history is zeroed if the number of coefficients changes.
+	///
+	FIR& coefs(const Tp * h, unsigned len){
+		mH.assign(h, h+len);
+		if(mHist.size() != len) mHist.resize(len);
+		return *this;
+	}
+
+	/// Set coefficients to a windowed-sinc lowpass; see firLowpass()
+	FIR& lowpass(unsigned len, double cutoff, WindowType win=BLACKMAN_HARRIS){
+		std::vector<Tp> h(len);
+		firLowpass(h.data(), len, cutoff, win);
+		return coefs(h.data(), len);
+	}
+
+	/// Filter next sample
+	Tv operator()(Tv i0){
+		mHist.write(i0);
+		return mHist.dot(mH.data(), size());
+	}
+
+	/// Filter a block of samples
+
+	/// \param[in] in		input samples
+	/// \param[out] out		output samples; may be the same as input
+	/// \param[in] n		number of samples
+	void process(const Tv * in, Tv * out, unsigned n){
+		for(unsigned i=0; i<n; ++i) out[i] = (*this)(in[i]);
+	}
+
+	/// Filter a block of samples in-place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
+
+	/// Zero history
+	void zero(){ mHist.zero(); }
+
+
+	/// Get number of coefficients
+	unsigned size() const { return mH.size(); }
+
+	/// Get coefficients
+	const Tp * coefs() const { return mH.data(); }
+
+	/// Get i-th coefficient
+	Tp coef(unsigned i) const { return mH[i]; }
+
+	/// Get group delay of a linear-phase (symmetric) filter, in samples
+	double delay() const { return 0.5*(double(size())-1.); }
+
+private:
+	std::vector<Tp> mH;
+	FIRHistory<Tv> mHist;
+};
+
+
+
+/// Polyphase FIR decimator
+
+/// This lowpass filters the input and keeps every factor-th output. Only the
+/// kept outputs are computed, so the cost is len/factor multiply-adds per
+/// input sample. Output m is the filter output at input
+/// factor*(m+1)-1, counting from the first input after the last reset.
+///
+/// \tparam Tv	value type
+/// \tparam Tp	coefficient type
+/// \ingroup Filter
+template <class Tv=real, class Tp=real>
+class FIRDecimator{
+public:
+
+	/// \param[in] factor		decimation factor
+	/// \param[in] len			number of coefficients; 0 chooses 32*factor+1
+	/// \param[in] bandwidth	cutoff, as a fraction of the output Nyquist
+	///							frequency
+	FIRDecimator(unsigned factor=2, unsigned len=0, double bandwidth=0.9){
+		design(factor, len, bandwidth);
+	}
+
+
+	/// Design windowed-sinc lowpass; see constructor for parameters
+	FIRDecimator& design(unsigned factor, unsigned len=0, double bandwidth=0.9,
+		WindowType win=BLACKMAN_HARRIS
+	){
+		if(!len) len = 32*factor + 1;
+		std::vector<Tp> h(len);
+		firLowpass(&h[0], len, 0.5*bandwidth/factor, win);
+		return coefs(&h[0], len, factor);
+	}
+
+	/// Set coefficients and decimation factor
+
+	/// This zeroes the history and restarts the output phase.
+	///
+	FIRDecimator& coefs(const Tp * h, unsigned len, unsigned factor){
+		mH.assign(h, h+len);
+		mHist.resize(len);
+		mFactor = factor;
+		mPhase = 0;
+		mOut = Tv(0);
+		return *this;
+	}
+
+	/// Input next sample
+
+	/// \returns whether a new output is available through value()
+	///
+	bool operator()(Tv i0){
+		mHist.write(i0);
+		if(++mPhase < mFactor) return false;
+		mPhase = 0;
+		mOut = mHist.dot(mH.data(), size());
+		return true;
+	}
+
+	/// Decimate a block of samples
+
+	/// \param[in] in		input samples
+	/// \param[out] out		output samples; must hold n/factor + 1 samples
+	/// \param[in] n		number of input samples
+	/// \returns number of output samples written
+	unsigned process(const Tv * in, Tv * out, unsigned n){
+		unsigned no = 0;
+		for(unsigned i=0; i<n; ++i){
+			if((*this)(in[i])) out[no++] = mOut;
+		}
+		return no;
+	}
+
+	/// Zero history and restart output phase
+	void zero(){ mHist.zero(); mPhase = 0; mOut = Tv(0); }
+
+
+	/// Get last output
+	const Tv& value() const { return mOut; }
+
+	/// Get decimation factor
+	unsigned factor() const { return mFactor; }
+
+	/// Get number of coefficients
+	unsigned size() const { return mH.size(); }
+
+	/// Get coefficients
+	const Tp * coefs() const { return mH.data(); }
+
+	/// Get group delay of a linear-phase filter, in input samples
+	double delay() const { return 0.5*(double(size())-1.); }
+
+private:
+	std::vector<Tp> mH;
+	FIRHistory<Tv> mHist;
+	unsigned mFactor, mPhase;
+	Tv mOut;
+};
+
+
+
+/// Polyphase FIR interpolator
+
+/// This inserts factor-1 zeros after each input sample and lowpass filters
+/// the result. The filter is split into factor branches, one per output
+/// phase, that only see the non-zero inputs, so the cost is len
+/// multiply-adds per input sample. The coefficients are scaled by the factor
+/// to keep unit passband gain.
+///
+/// \tparam Tv	value type
+/// \tparam Tp	coefficient type
+/// \ingroup Filter
+template <class Tv=real, class Tp=real>
+class FIRInterpolator{
+public:
+
+	/// \param[in] factor		interpolation factor
+	/// \param[in] len			number of coefficients; 0 chooses 32*factor+1
+	/// \param[in] bandwidth	cutoff, as a fraction of the input Nyquist
+	///							frequency
+	FIRInterpolator(unsigned factor=2, unsigned len=0, double bandwidth=0.9){
+		design(factor, len, bandwidth);
+	}
+
+
+	/// Design windowed-sinc lowpass; see constructor for parameters
+	FIRInterpolator& design(unsigned factor, unsigned len=0, double bandwidth=0.9,
+		WindowType win=BLACKMAN_HARRIS
+	){
+		if(!len) len = 32*factor + 1;
+		std::vector<Tp> h(len);
+		firLowpass(&h[0], len, 0.5*bandwidth/factor, win);
+		return coefs(&h[0], len, factor);
+	}
+
+	/// Set coefficients, at the output rate, and interpolation factor
+
+	/// The coefficients should have unit gain at DC; they are scaled by the
+	/// factor. This zeroes the history.
+	///
+	FIRInterpolator& coefs(const Tp * h, unsigned len, unsigned factor){
+		mFactor = factor;
+		mLen = len;
+		mBranchLen = (len + factor-1) / factor;
+		// Branch p holds taps p, p+factor, p+2*factor, ...
+		mH.assign(mBranchLen*factor, Tp(0));
+		for(unsigned k=0; k<len; ++k){
+			mH[(k%factor)*mBranchLen + k/factor] = h[k]*Tp(factor);
+		}
+		mHist.resize(mBranchLen);
+		return *this;
+	}
+
+	/// Input next sample and write factor() output samples
+	void operator()(Tv * out, Tv i0){
+		mHist.write(i0);
+		for(unsigned p=0; p<mFactor; ++p){
+			out[p] = mHist.dot(&mH[p*mBranchLen], mBranchLen);
+		}
+	}
+
+	/// Interpolate a block of samples
+
+	/// \param[in] in		input samples
+	/// \param[out] out		output samples; must hold n*factor() samples
+	/// \param[in] n		number of input samples
+	void process(const Tv * in, Tv * out, unsigned n){
+		for(unsigned i=0; i<n; ++i) (*this)(out + i*mFactor, in[i]);
+	}
+
+	/// Zero history
+	void zero(){ mHist.zero(); }
+
+
+	/// Get interpolation factor
+	unsigned factor() const { return mFactor; }
+
+	/// Get number of coefficients
+	unsigned size() const { return mLen; }
+
+	/// Get group delay of a linear-phase filter, in output samples
+	double delay() const { return 0.5*(double(size())-1.); }
+
+private:
+	std::vector<Tp> mH;		// branch-major polyphase coefficients
+	FIRHistory<Tv> mHist;
+	unsigned mFactor, mLen, mBranchLen;
+};
+
+
+
+
+/// Halfband FIR interpolator by two
+
+/// A halfband lowpass with 4M-1 taps has every other tap zero except the
+/// center one, so one output of each pair is a dot product of 2M taps with
+/// the input and the other is a scaled, delayed input. Each polyphase branch
+/// has unit DC gain. The output is delayed by 2M-1 output samples.
+///
+/// \tparam Tv	value type
+/// \tparam Tp	coefficient type
+/// \ingroup Filter
+template <class Tv=real, class Tp=real>
+class HalfbandInterpolator{
+public:
+
+	/// \param[in] M		half the number of non-zero taps
+	explicit HalfbandInterpolator(unsigned M=16){ resize(M); }
+
+	/// Set filter length and zero history
+
+	/// \param[in] M		half the number of non-zero taps
+	/// \param[in] win		window of the halfband design
+	void resize(unsigned M, WindowType win=BLACKMAN_HARRIS){
+		halfband(mG, M, win);
+		for(auto& g : mG) g *= Tp(2);
+		mHist.resize(2*M);
+	}
+
+	/// Input next sample and get two output samples
+	void operator()(Tv& out0, Tv& out1, Tv i0){
+		mHist.write(i0);
+		out0 = mHist.dot(mG.data(), mG.size());
+		out1 = mHist[mG.size()/2 - 1];
+	}
+
+	/// Zero history
+	void zero(){ mHist.zero(); }
+
+	/// Get number of taps of full-rate filter
+	unsigned size() const { return 2*mG.size() - 1; }
+
+	/// Get delay, in output samples
+	unsigned delay() const { return mG.size() - 1; }
+
+	/// Compute the 2M even-indexed taps of a halfband lowpass
+
+	/// The odd-indexed taps are zero except the center one, which is 1/2.
+	/// The even-indexed taps are scaled to sum to 1/2.
+	static void halfband(std::vector<Tp>& g, unsigned M, WindowType win=BLACKMAN_HARRIS){
+		const unsigned L = 4*M-1;
+		std::vector<double> h(L);
+		firLowpass(&h[0], L, 0.25, win);
+		double sum = 0;
+		for(unsigned m=0; m<2*M; ++m) sum += h[2*m];
+		g.resize(2*M);
+		for(unsigned m=0; m<2*M; ++m) g[m] = Tp(0.5*h[2*m]/sum);
+	}
+
+private:
+	std::vector<Tp> mG;
+	FIRHistory<Tv> mHist;
+};
+
+
+
+/// Halfband FIR decimator by two
+
+/// This is the counterpart of HalfbandInterpolator. Each output costs 2M
+/// multiply-adds and is aligned with the first input of its pair, so that
+/// output n is the filter output at input 2n, delayed by 2M-1 input samples.
+///
+/// \tparam Tv	value type
+/// \tparam Tp	coefficient type
+/// \ingroup Filter
+template <class Tv=real, class Tp=real>
+class HalfbandDecimator{
+public:
+
+	/// \param[in] M		half the number of non-zero taps
+	explicit HalfbandDecimator(unsigned M=16){ resize(M); }
+
+	/// Set filter length and zero history
+
+	/// \param[in] M		half the number of non-zero taps
+	/// \param[in] win		window of the halfband design
+	void resize(unsigned M, WindowType win=BLACKMAN_HARRIS){
+		HalfbandInterpolator<Tv,Tp>::halfband(mG, M, win);
+		mEven.resize(2*M);
+		mOdd.resize(M);
+	}
+
+	/// Input next two samples and get one output sample
+	Tv operator()(Tv i0, Tv i1){
+		mEven.write(i0);
+		Tv o = mEven.dot(mG.data(), mG.size()) + Tv(0.5)*mOdd[mG.size()/2 - 1];
+		mOdd.write(i1);
+		return o;
+	}
+
+	/// Zero history
+	void zero(){ mEven.zero(); mOdd.zero(); }
+
+	/// Get number of taps of full-rate filter
+	unsigned size() const { return 2*mG.size() - 1; }
+
+	/// Get delay, in input samples
+	unsigned delay() const { return mG.size() - 1; }
+
+private:
+	std::vector<Tp> mG;
+	FIRHistory<Tv> mEven, mOdd;
+};
+
+
+
+/// Runs a processor at a multiple of the sample rate
+
+/// The input is upsampled by N with a cascade of halfband interpolators,
+/// each sample is passed through the processor and the result is
+/// decimated back with the mirror cascade. Nonlinear processors, such as
+/// waveshapers or feedback FM, then only alias what lands above the base
+/// rate passband after filtering. The first stage has 79 taps and the
+/// later ones, which see narrower bands, 27 and 23. Content up to 0.8 of
+/// the Nyquist frequency passes and images and aliases that would fall
+/// below it are attenuated by about 90 dB.
+///
+/// The processor is called as Tv proc(Tv) once per oversampled sample.
+/// Filters are linear phase, so the output is the processed input delayed
+/// by latency() samples at the base rate.
+///
+/// \tparam N		oversampling factor: 2, 4, 8 or 16
+/// \tparam Proc	processor type
+/// \tparam Tv		value type
+/// \ingroup Filter
+template <unsigned N, class Proc, class Tv=real>
+class Oversample{
+public:
+
+	Oversample(){ init(); }
+
+	/// \param[in] proc		processor to copy
+	explicit Oversample(const Proc& proc): mProc(proc){ init(); }
+
+
+	/// Process next sample
+	Tv operator()(Tv i0){
+		Tv buf[N];
+		buf[N-1] = i0;
+		upsample(buf, 1);
+		for(unsigned i=0; i<N; ++i) buf[i] = mProc(buf[i]);
+		downsample(buf, 1);
+		return buf[0];
+	}
+
+	/// Process a block of samples
+
+	/// \param[in] in		input samples
+	/// \param[out] out		output samples; may be the same as input
+	/// \param[in] n		number of samples
+	void process(const Tv * in, Tv * out, unsigned n){
+		Tv buf[N*B];
+		while(n){
+			unsigned nb = n < B ? n : B;
+			for(unsigned i=0; i<nb; ++i) buf[(N-1)*nb + i] = in[i];
+			upsample(buf, nb);
+			for(unsigned i=0; i<N*nb; ++i) buf[i] = mProc(buf[i]);
+			downsample(buf, nb);
+			for(unsigned i=0; i<nb; ++i) out[i] = buf[i];
+			in += nb; out += nb; n -= nb;
+		}
+	}
+
+	/// Process a block of samples in-place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
+
+	/// Zero filter histories
+	void zero(){
+		for(unsigned s=0; s<S; ++s){ mUp[s].zero(); mDown[s].zero(); }
+	}
+
+
+	/// Get processor
+	Proc& proc(){ return mProc; }
+	const Proc& proc() const { return mProc; }
+
+	/// Get oversampling factor
+	static unsigned factor(){ return N; }
+
+	/// Get delay of the output relative to the input, in base rate samples
+
+	/// The delay is fractional for N above 2.
+	///
+	double latency() const {
+		double d = 0;
+		// Stage s runs at 2^(s+1) times the base rate and each of its two
+		// filters delays by 2M-1 samples at that rate
+		for(unsigned s=0; s<S; ++s) d += 2.*mUp[s].delay() / (2u<<s);
+		return d;
+	}
+
+private:
+	static_assert(N==2 || N==4 || N==8 || N==16, "Oversampling factor must be 2, 4, 8 or 16");
+	static const unsigned S = N==2 ? 1 : N==4 ? 2 : N==8 ? 3 : 4;	// number of stages
+	static const unsigned B = 64;	// block size at base rate
+
+	HalfbandInterpolator<Tv,Tv> mUp[S];
+	HalfbandDecimator<Tv,Tv> mDown[S];
+	Proc mProc;
+
+	void init(){
+		static const unsigned M[] = {20, 7, 6, 6};
+		for(unsigned s=0; s<S; ++s){ mUp[s].resize(M[s]); mDown[s].resize(M[s]); }
+	}
+
+	// Expand n samples at the end of buf to N*n samples
+	void upsample(Tv * buf, unsigned n){
+		Tv * end = buf + N*n;
+		for(unsigned s=0; s<S; ++s){
+			// Inputs and outputs are both kept at the end of the buffer, so
+			// going forward in time never overwrites an unread input
+			const Tv * src = end - n;
+			Tv * dst = end - 2*n;
+			for(unsigned i=0; i<n; ++i){
+				Tv v = src[i];
+				mUp[s](dst[2*i], dst[2*i+1], v);
+			}
+			n *= 2;
+		}
+	}
+
+	// Reduce N*n samples in buf to n samples at its start
+	void downsample(Tv * buf, unsigned n){
+		n *= N;
+		for(unsigned s=S; s--;){
+			n /= 2;
+			for(unsigned i=0; i<n; ++i) buf[i] = mDown[s](buf[2*i], buf[2*i+1]);
+		}
+	}
+};
+
+
+
+// Implementation_______________________________________________________________
+
+template <class Tv, class Tp>
+Tv firDot(const Tp * h, const Tv * x, unsigned len){
+	// Stepping pointers over whole lanes, with the remainder folded into
+	// the lanes afterwards, keeps the accumulators in vector registers
+	const unsigned K = 8;
+	Tv s[K];
+	for(unsigned k=0; k<K; ++k) s[k] = Tv(0);
+	const Tp * he = h + (len & ~(K-1));
+	for(; h != he; h+=K, x+=K){
+		for(unsigned k=0; k<K; ++k) s[k] += x[k] * h[k];
+	}
+	for(unsigned k=0; k < (len & (K-1)); ++k) s[k] += x[k] * h[k];
+	for(unsigned k=K/2; k; k>>=1){
+		for(unsigned j=0; j<k; ++j) s[j] += s[j+k];
+	}
+	return s[0];
+}
+
+template <class T>
+void firLowpass(T * dst, unsigned len, double cutoff, WindowType win){
+	if(!len) return;
+
+	// Periodic window of length len+1 without its first (zero) point is
+	// symmetric about the center tap
+	std::vector<double> w(len+1);
+	tbl::window(&w[0], len+1, win);
+
+	double c = 0.5*(double(len)-1.);
+	double sum = 0;
+	std::vector<double> h(len);
+	for(unsigned i=0; i<len; ++i){
+		double t = double(i) - c;
+		double s = t != 0. ? std::sin(M_2PI*cutoff*t)/(M_PI*t) : 2.*cutoff;
+		h[i] = s * w[i+1];
+		sum += h[i];
+	}
+	for(unsigned i=0; i<len; ++i) dst[i] = T(h[i]/sum);
+}
+
+} // gam::
+
+#endif
@@ -52,6 +52,57 @@ inline T freqToRad(T freq, double ups){ return scl::clip(freq * ups, 0.499) * M_
 
 
 
+/// Linear ramp of filter coefficients across a processing block
+
+/// This remembers the coefficients used at the end of the last block so that
+/// a filter's block processing can interpolate from them to the current ones.
+/// The first block after construction or reset() is not ramped.
+///
+/// \tparam T	Coefficient type
+/// \tparam N	Number of coefficients
+/// \ingroup Filter
+template <class T, unsigned N>
+class CoefRamp{
+public:
+
+	/// Begin a block of samples
+
+	/// \param[in,out]	c	current coefficients; on return, the starting
+	///						coefficients if they are ramped
+	/// \param[out]		dc	per-sample increments of coefficients
+	/// \param[in]		n	number of samples in block
+	/// \returns whether the coefficients are ramped. If so, the filter should
+	/// add dc to c before computing each sample so that the last sample uses
+	/// the current coefficients.
+	bool begin(T * c, T * dc, unsigned n){
+		bool ramp = false;
+		if(mValid && n){
+			for(unsigned i=0; i<N; ++i) ramp |= (c[i] != mPrev[i]);
+		}
+		if(ramp){
+			T rn = T(1)/T(n);
+			for(unsigned i=0; i<N; ++i){
+				dc[i] = (c[i] - mPrev[i]) * rn;
+				T t = c[i]; c[i] = mPrev[i]; mPrev[i] = t;
+			}
+		}
+		else{
+			for(unsigned i=0; i<N; ++i) mPrev[i] = c[i];
+		}
+		mValid = true;
+		return ramp;
+	}
+
+	/// Do not ramp the next block
+	void reset(){ mValid = false; }
+
+private:
+	T mPrev[N];
+	bool mValid = false;
+};
+
+
+
 /// First-order all-pass filter
 
 /// This filter has the transfer function H(z) = (a + z^-1) / (1 + a z^-1).
@@ -79,6 +130,18 @@ public:
 	void zero(){ d1=Tv(0); }
 	
 	Tv operator()(Tv in);	///< Filters sample
+
+	/// Filter a block of samples
+
+	/// The coefficient is ramped linearly across the block from its value at
+	/// the end of the previous block (see CoefRamp).
+	/// \param[in]	in		input samples
+	/// \param[out]	out		output samples; may equal in
+	/// \param[in]	n		number of samples
+	void process(const Tv * in, Tv * out, unsigned n);
+
+	/// Filter a block of samples in place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
 	
 	Tv high(Tv in);			///< High-pass filters sample
 	Tv low (Tv in);			///< Low-pass filters sample
@@ -91,6 +154,7 @@ protected:
 	Tv d1;		// once delayed value
 	Tp c;		// feed coefficient
 	Tp mFreq;
+	CoefRamp<Tp,1> mRamp;
 };
 
 
@@ -105,6 +169,12 @@ protected:
 ///
 /// http://www.musicdsp.org/files/Audio-EQ-Cookbook.txt
 ///
+/// By default, the sine and cosine of the center frequency are computed with
+/// polynomial approximations so that the frequency can be swept cheaply at
+/// control or audio rate. Their absolute error is below 4e-7 for frequencies
+/// up to 1/8 of the sample rate and below 1.6e-4 above that. Filters that need
+/// exact coefficients can use precise().
+///
 /// \tparam Tv	Value (sample) type
 /// \tparam Tp	Parameter type
 /// \tparam Td	Domain observer type
@@ -140,8 +210,26 @@ public:
 	void type(FilterType type);			///< Set type of filter
 	void zero();						///< Zero internal delays
 
+	/// Set whether to compute coefficients with exact (but slower) math
+	void precise(bool v){ mPrecise=v; freq(mFreq); }
+	bool precise() const { return mPrecise; }	///< Get whether coefficients use exact math
+
 	Tv operator()(Tv in);				///< Filter next sample
 	Tv nextBP(Tv in);					///< Optimized for band-pass types
+
+	/// Filter a block of samples
+
+	/// The coefficients are ramped linearly across the block from their values
+	/// at the end of the previous block (see CoefRamp), so parameters can be
+	/// set once per block without clicks. Linear interpolation between two
+	/// stable filters gives a stable filter.
+	/// \param[in]	in		input samples
+	/// \param[out]	out		output samples; may equal in
+	/// \param[in]	n		number of samples
+	void process(const Tv * in, Tv * out, unsigned n);
+
+	/// Filter a block of samples in place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
 	
 	Tp freq() const;					///< Get center frequency
 	Tp res() const;						///< Get resonance (Q)
@@ -150,6 +238,18 @@ public:
 	
 	void onDomainChange(double r);
 
+
+	/// Compute coefficients
+
+	/// \param[out] a		3 feedforward coefficients
+	/// \param[out] b		3 feedback coefficients; b[0] is set to 1/b_0
+	/// \param[in] re		cosine of center frequency, in radians/sample
+	/// \param[in] im		sine of center frequency, in radians/sample
+	/// \param[in] resRecip	0.5/resonance
+	/// \param[in] level	amplitude level (PEAKING, LOW_SHELF, HIGH_SHELF)
+	/// \param[in] type		filter type
+	static void design(Tp * a, Tp * b, Tp re, Tp im, Tp resRecip, Tp level, FilterType type);
+
 protected:
 	Tp mA[3];			// feedforward coefs
 	Tp mB[3];			// feedback coefs (first element used to scale coefs)
@@ -158,14 +258,100 @@ protected:
 	Tp mLevel;			// amplitude level (for peaking)
 	FilterType mType;
 	Tp mReal, mImag;	// real, imag components of center frequency
-	Tp mAlpha, mBeta;
 	Tp mFrqToRad;
+	CoefRamp<Tp,5> mRamp;
+	bool mPrecise;
 
-	void resRecip(Tp v);
+	void compute(){ design(mA, mB, mReal, mImag, mResRecip, mLevel, mType); }
 };
 
 
 
+/// Bank of independent 2-pole/2-zero IIR filters
+
+/// This runs N biquad filters side by side, one per lane, with coefficients
+/// computed by the same formulas as Biquad.
+///
+/// Sample frames hold one sample for each lane. Multichannel audio is
+/// processed with interleaved frames; a filter bank can also be fed the same
+/// input in all lanes.
+///
+/// \tparam N	Number of filters (lanes)
+/// \tparam Tv	Value (sample) type
+/// \tparam Tp	Parameter type
+/// \tparam Td	Domain observer type
+/// \ingroup Filter
+template <unsigned N, class Tv=gam::real, class Tp=gam::real, class Td=DomainObserver>
+class BiquadBank : public Td{
+public:
+
+	/// \param[in]	frq		Center frequency of all lanes
+	/// \param[in]	res		Resonance (Q) of all lanes
+	/// \param[in]	type	Type of filter of all lanes
+	BiquadBank(Tp frq = Tp(1000), Tp res = Tp(0.707), FilterType type = LOW_PASS);
+
+
+	/// Set parameters of one lane
+	void set(unsigned lane, Tp frq, Tp res, FilterType type);
+
+	/// Set parameters of one lane, keeping its type
+	void set(unsigned lane, Tp frq, Tp res){ set(lane, frq, res, mType[lane]); }
+
+	/// Set parameters of all lanes
+	void set(Tp frq, Tp res, FilterType type);
+
+	void freq(unsigned lane, Tp v);			///< Set center frequency of a lane
+	void res(unsigned lane, Tp v);			///< Set resonance (Q) of a lane
+	void level(unsigned lane, Tp v);		///< Set level of a lane (PEAKING, LOW_SHELF, HIGH_SHELF types only)
+	void type(unsigned lane, FilterType v);	///< Set filter type of a lane
+
+	/// Set feedforward (a) and feedback (b) coefficients of a lane directly
+	void coef(unsigned lane, Tp a0, Tp a1, Tp a2, Tp b1, Tp b2);
+
+	void zero();							///< Zero internal delays
+	void zero(unsigned lane);				///< Zero internal delays of a lane
+
+
+	/// Filter one frame of N samples, one per lane
+	void operator()(const Tv * in, Tv * out);
+
+	/// Filter one frame of N samples in place
+	void operator()(Tv * io){ (*this)(io, io); }
+
+	/// Filter a block of interleaved frames
+
+	/// \param[in]	in			input frames, N samples each
+	/// \param[out]	out			output frames, N samples each; may equal in
+	/// \param[in]	numFrames	number of frames
+	void process(const Tv * in, Tv * out, unsigned numFrames);
+
+	/// Filter a block of one input through all lanes
+
+	/// \param[in]	in			input samples
+	/// \param[out]	out			interleaved output frames, N samples each
+	/// \param[in]	numFrames	number of input samples
+	void processBank(const Tv * in, Tv * out, unsigned numFrames);
+
+
+	Tp freq(unsigned lane) const { return mFreq[lane]; }		///< Get center frequency of a lane
+	Tp res(unsigned lane) const { return mRes[lane]; }			///< Get resonance (Q) of a lane
+	Tp level(unsigned lane) const { return mLevel[lane]; }		///< Get level of a lane
+	FilterType type(unsigned lane) const { return mType[lane]; }///< Get filter type of a lane
+	static unsigned size(){ return N; }							///< Get number of lanes
+
+	void onDomainChange(double r);
+
+protected:
+	Tp mA0[N], mA1[N], mA2[N];	// feedforward coefs
+	Tp mB1[N], mB2[N];			// feedback coefs
+	Tv mD1[N], mD2[N];			// inner sample delays
+	Tp mFreq[N], mRes[N], mLevel[N];
+	FilterType mType[N];
+
+	void compute(unsigned lane);
+};
+
+
 /// DC frequency blocker
 
 /// \tparam Tv	Value (sample) type
@@ -191,6 +377,31 @@ public:
 		return o0;
 	}
 
+	/// Filter a block of samples, ramping the pole (see CoefRamp)
+	void process(const Tv * in, Tv * out, unsigned n){
+		Tp b1 = mB1, db1;
+		Tv z = d1;
+		if(mRamp.begin(&b1, &db1, n)){
+			for(unsigned i=0; i<n; ++i){
+				b1 += db1;
+				Tv t = in[i] + z*b1;
+				out[i] = t - z;
+				z = t;
+			}
+		}
+		else{
+			for(unsigned i=0; i<n; ++i){
+				Tv t = in[i] + z*b1;
+				out[i] = t - z;
+				z = t;
+			}
+		}
+		d1 = z;
+	}
+
+	/// Filter a block of samples in place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
+
 	/// Set bandwidth of pole
 	void width(Tp v){
 		mWidth = v;
@@ -204,6 +415,7 @@ public:
 protected:
 	Tv d1;
 	Tp mWidth, mB1;
+	CoefRamp<Tp,1> mRamp;
 };
 
 
@@ -231,6 +443,31 @@ public:
 		return o0;
 	}
 
+	/// Filter a block of samples, ramping the pole (see CoefRamp)
+	void process(const Tv * in, Tv * out, unsigned n){
+		Tp b1 = mB1, db1;
+		Tv z = d1;
+		if(mRamp.begin(&b1, &db1, n)){
+			for(unsigned i=0; i<n; ++i){
+				b1 += db1;
+				Tv t = in[i] + z*b1;
+				out[i] = t + z;
+				z = t;
+			}
+		}
+		else{
+			for(unsigned i=0; i<n; ++i){
+				Tv t = in[i] + z*b1;
+				out[i] = t + z;
+				z = t;
+			}
+		}
+		d1 = z;
+	}
+
+	/// Filter a block of samples in place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
+
 	/// Set bandwidth of pole
 	void width(Tp v){
 		Base::width(v);
@@ -239,18 +476,25 @@ public:
 
 protected:
 	typedef BlockDC<Tv,Tp,Td> Base;
-	using Base::d1; using Base::mB1;
+	using Base::d1; using Base::mB1; using Base::mRamp;
 };
 
 
 
 /// Abstract base class for 2-pole or 2-zero filter
 
-/// \tparam Tv	Value (sample) type
-/// \tparam Tp	Parameter type
-/// \tparam Td	Domain observer type
+/// By default, the cosine of the center frequency is computed with the same
+/// polynomial approximation as Biquad, whose absolute error is below 4e-7 for
+/// frequencies up to 1/8 of the sample rate and below 1.6e-4 above that.
+/// Filters that need exact coefficients can use precise().
+///
+/// \tparam Tv			Value (sample) type
+/// \tparam Tp			Parameter type
+/// \tparam Td			Domain observer type
+/// \tparam Derived	Derived filter type, whose freq() recomputes its
+///					coefficients
 /// \ingroup Filter
-template <class Tv=gam::real, class Tp=gam::real, class Td=DomainObserver>
+template <class Tv, class Tp, class Td, class Derived>
 class Filter2 : public Td{
 public:
 
@@ -267,20 +511,24 @@ public:
 
 	/// Zero delay elements
 	void zero(){ d2=d1=Tv(0); }
+
+	/// Set whether to compute coefficients with exact (but slower) math
+	void precise(bool v){ mPrecise=v; static_cast<Derived*>(this)->freq(mFreq); }
+	bool precise() const { return mPrecise; }	///< Get whether coefficients use exact math
 	
 	void onDomainChange(double r){ freq(mFreq); width(mWidth); }
 
 protected:
 
 	Filter2(Tp frq, Tp wid)
-	:	mFreq(frq), mWidth(wid)
+	:	mFreq(frq), mWidth(wid), mC(), mCos(0), mRad(0), mPrecise(false)
 	{	zero(); }
 
 	void freqRef(Tp& v){
 		mFreq = v;		
 		v = scl::clip<Tp>(v * Td::ups(), 0.5);
 		//mCos = scl::cosP3<Tp>(v);
-		mCos = scl::cosT8<Tp>(v * M_2PI);
+		mCos = mPrecise ? std::cos(v * Tp(M_2PI)) : scl::cosT8<Tp>(v * M_2PI);
 		computeCoef1();
 	}
 	
@@ -292,11 +540,13 @@ protected:
 	Tp mC[3];			// coefficients
 	Tp mCos, mRad;
 	Tv d2, d1;			// 2- and 1-sample delays
+	CoefRamp<Tp,3> mRamp;
+	bool mPrecise;
 };
 
 
-#define INHERIT_FILTER2 \
-typedef Filter2<Tv,Tp,Td> Base;\
+#define INHERIT_FILTER2(Derived) \
+typedef Filter2<Tv,Tp,Td,Derived<Tv,Tp,Td>> Base;\
 using Base::mFreq;\
 using Base::mWidth;\
 using Base::gain;\
@@ -304,7 +554,9 @@ using Base::mC;\
 using Base::mRad;\
 using Base::mCos;\
 using Base::d2;\
-using Base::d1
+using Base::d1;\
+using Base::mRamp;\
+using Base::mPrecise
 
 
 /// Second-order all-pass filter
@@ -316,13 +568,16 @@ using Base::d1
 /// \tparam Td	Domain observer type
 /// \ingroup Filter
 template <class Tv=gam::real, class Tp=gam::real, class Td=DomainObserver>
-class AllPass2 : public Filter2<Tv,Tp,Td>{
+class AllPass2 : public Filter2<Tv,Tp,Td,AllPass2<Tv,Tp,Td>>{
 public:
 
 	/// \param[in] frq	Center frequency
 	/// \param[in] wid	Bandwidth
 	AllPass2(Tp frq = Tp(1000), Tp wid = Tp(100))
-	:	Base(frq, wid){}
+	:	Base(frq, wid)
+	{
+		this->onDomainChange(1);
+	}
 
 	/// Filter sample
 	Tv operator()(Tv in){
@@ -332,8 +587,33 @@ public:
 		return o0;
 	}
 
+	/// Filter a block of samples, ramping the coefficients (see CoefRamp)
+	void process(const Tv * in, Tv * out, unsigned n){
+		Tp c[3] = {mC[0], mC[1], mC[2]}, dc[3];
+		Tv z1 = d1, z2 = d2;
+		if(mRamp.begin(c, dc, n)){
+			for(unsigned i=0; i<n; ++i){
+				c[1] += dc[1]; c[2] += dc[2];
+				Tv t = in[i] + z1*c[1] + z2*c[2];
+				out[i] = z2 - z1*c[1] - t*c[2];
+				z2 = z1; z1 = t;
+			}
+		}
+		else{
+			for(unsigned i=0; i<n; ++i){
+				Tv t = in[i] + z1*c[1] + z2*c[2];
+				out[i] = z2 - z1*c[1] - t*c[2];
+				z2 = z1; z1 = t;
+			}
+		}
+		d1 = z1; d2 = z2;
+	}
+
+	/// Filter a block of samples in place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
+
 protected:
-	INHERIT_FILTER2;
+	INHERIT_FILTER2(AllPass2);
 };
 
 
@@ -345,7 +625,7 @@ protected:
 /// \tparam Td	Domain observer type
 /// \ingroup Filter
 template <class Tv=gam::real, class Tp=gam::real, class Td=DomainObserver>
-class Notch : public Filter2<Tv,Tp,Td>{
+class Notch : public Filter2<Tv,Tp,Td,Notch<Tv,Tp,Td>>{
 public:
 	
 	/// \param[in] frq	Center frequency
@@ -370,10 +650,35 @@ public:
 		return o0;
 	}
 
+	/// Filter a block of samples, ramping the coefficients (see CoefRamp)
+	void process(const Tv * in, Tv * out, unsigned n){
+		Tp c[3] = {mC[0], mC[1], mC[2]}, dc[3];
+		Tv z1 = d1, z2 = d2;
+		if(mRamp.begin(c, dc, n)){
+			for(unsigned i=0; i<n; ++i){
+				c[0] += dc[0]; c[1] += dc[1]; c[2] += dc[2];
+				Tv t = in[i] * c[0];
+				out[i] = t - z1*c[1] - z2*c[2];
+				z2 = z1; z1 = t;
+			}
+		}
+		else{
+			for(unsigned i=0; i<n; ++i){
+				Tv t = in[i] * c[0];
+				out[i] = t - z1*c[1] - z2*c[2];
+				z2 = z1; z1 = t;
+			}
+		}
+		d1 = z1; d2 = z2;
+	}
+
+	/// Filter a block of samples in place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
+
 	void onDomainChange(double r){ freq(mFreq); width(mWidth); }
 
 protected:
-	INHERIT_FILTER2;
+	INHERIT_FILTER2(Notch);
 
 	// compute constant gain factor
 	void computeGain(){ gain() = Tp(1) / (Tp(1) + scl::abs(mC[1]) - mC[2]); }
@@ -383,12 +688,16 @@ protected:
 
 /// Two-pole resonator
 
+/// The gain normalization uses the sine of the center frequency. By default,
+/// it is computed with a cubic approximation whose absolute error is below
+/// 0.02.
+///
 /// \tparam Tv	Value (sample) type
 /// \tparam Tp	Parameter type
 /// \tparam Td	Domain observer type
 /// \ingroup Filter
 template <class Tv=gam::real, class Tp=gam::real, class Td=DomainObserver>
-class Reson : public Filter2<Tv,Tp,Td>{
+class Reson : public Filter2<Tv,Tp,Td,Reson<Tv,Tp,Td>>{
 public:
 
 	/// \param[in] frq	Center frequency
@@ -402,7 +711,8 @@ public:
 	/// Set center frequency
 	void freq(Tp v){
 		Base::freqRef(v);
-		mSin = scl::cosP3<Tp>(scl::foldOnce<Tp>(v - Tp(0.25), Tp(0.5)));
+		mSin = mPrecise ? std::sin(v * Tp(M_2PI))
+						: scl::cosP3<Tp>(scl::foldOnce<Tp>(v - Tp(0.25), Tp(0.5)));
 		computeGain();
 	}
 
@@ -418,10 +728,35 @@ public:
 		return t;
 	}
 
+	/// Filter a block of samples, ramping the coefficients (see CoefRamp)
+	void process(const Tv * in, Tv * out, unsigned n){
+		Tp c[3] = {mC[0], mC[1], mC[2]}, dc[3];
+		Tv z1 = d1, z2 = d2;
+		if(mRamp.begin(c, dc, n)){
+			for(unsigned i=0; i<n; ++i){
+				c[0] += dc[0]; c[1] += dc[1]; c[2] += dc[2];
+				Tv t = in[i] * c[0] + z1*c[1] + z2*c[2];
+				out[i] = t;
+				z2 = z1; z1 = t;
+			}
+		}
+		else{
+			for(unsigned i=0; i<n; ++i){
+				Tv t = in[i] * c[0] + z1*c[1] + z2*c[2];
+				out[i] = t;
+				z2 = z1; z1 = t;
+			}
+		}
+		d1 = z1; d2 = z2;
+	}
+
+	/// Filter a block of samples in place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
+
 	void onDomainChange(double r){ freq(mFreq); width(mWidth); }
 
 protected:
-	INHERIT_FILTER2;
+	INHERIT_FILTER2(Reson);
 	Tp mSin;
 
 	// compute constant gain factor
@@ -441,37 +776,99 @@ protected:
 /// harmonic conjugate. The input and output of the Hilbert transform, comprise
 /// the real and imaginary components of a complex (analytic) signal.
 ///
+/// The real and imaginary parts come from two chains of six first-order
+/// all-pass filters. Their break frequencies are those of an analog design
+/// whose phase difference stays within 0.5 degrees of 90 from about 15 Hz
+/// to 13 kHz. The coefficients are mapped from the analog ones by the
+/// bilinear transform at the domain's sample rate, which keeps the phase
+/// difference of the two chains equiripple at any rate. If the domain's
+/// rate has not been set, or the domain is normalized to one sample per unit
+/// (as Domain1 is) and so has no rate in Hz, 44.1 kHz is assumed.
+///
 /// \tparam Tv	Value (sample) type
 /// \tparam Tp	Parameter type
+/// \tparam Td	Domain observer type
 /// \ingroup Filter
-template <class Tv=gam::real, class Tp=gam::real>
-class Hilbert {
+template <class Tv=gam::real, class Tp=gam::real, class Td=DomainObserver>
+class Hilbert : public Td{
 public:
-	#define SR 44100.
-	Hilbert()
-	:	cf0(   5.4135/SR), cf1(  41.118 /SR), cf2(  167.3595/SR),	/* for SR=44100 */
-		cf3( 671.3715/SR), cf4(2694.363 /SR), cf5(11976.867 /SR),
-		sf0(  18.786 /SR), sf1(  83.5065/SR), sf2(  335.1345/SR), 
-		sf3(1344.4065/SR), sf4(5471.871 /SR), sf5(41551.671 /SR)
-	{}
-	#undef SR
+
+	Hilbert(){
+		onDomainChange(1);
+		zero();
+	}
 
 	/// Convert input from real to complex
 	Complex<Tv> operator()(Tv in){
-		return Complex<Tv>(
-			 cf0(cf1(cf2(cf3(cf4(cf5(in)))))),
-			-sf0(sf1(sf2(sf3(sf4(sf5(in))))))
-		);
+		Complex<Tv> out;
+		process(&in, &out.r, &out.i, 1);
+		return out;
 	}
-	
-	void zero()
-	{
-		cf0.zero(); cf1.zero(); cf2.zero(); cf3.zero(); cf4.zero(); cf5.zero();
-		sf0.zero(); sf1.zero(); sf2.zero(); sf3.zero(); sf4.zero(); sf5.zero();
+
+	/// Convert a block of samples from real to complex
+
+	/// \param[in]	in		input samples
+	/// \param[out]	out		output samples
+	/// \param[in]	n		number of samples
+	void process(const Tv * in, Complex<Tv> * out, unsigned n){
+		process(in, &out[0].r, &out[0].i, n, 2);
+	}
+
+	/// Convert a block of samples from real to complex
+
+	/// \param[in]	in		input samples
+	/// \param[out]	re		real parts of output; may equal in
+	/// \param[out]	im		imaginary parts of output
+	/// \param[in]	n		number of samples
+	/// \param[in]	stride	output stride
+	void process(const Tv * in, Tv * re, Tv * im, unsigned n, unsigned stride=1){
+		// Work on local copies so the state stays in registers
+		Tp c[K][2];
+		Tv d[K][2];
+		for(unsigned k=0; k<K; ++k){
+			for(unsigned l=0; l<2; ++l){ c[k][l] = mC[k][l]; d[k][l] = mD[k][l]; }
+		}
+		for(unsigned i=0; i<n; ++i){
+			Tv x[2] = {in[i], in[i]};
+			for(unsigned k=0; k<K; ++k){
+				for(unsigned l=0; l<2; ++l){
+					Tv i0 = x[l] - d[k][l] * c[k][l];
+					x[l] = i0 * c[k][l] + d[k][l];
+					d[k][l] = i0;
+				}
+			}
+			re[i*stride] = x[0];
+			im[i*stride] =-x[1];
+		}
+		for(unsigned k=0; k<K; ++k){
+			for(unsigned l=0; l<2; ++l) mD[k][l] = d[k][l];
+		}
+	}
+
+	void zero(){
+		for(unsigned k=0; k<K; ++k){ mD[k][0] = mD[k][1] = Tv(0); }
+	}
+
+	void onDomainChange(double r){
+		// Break frequencies of the analog design, in Hz, real chain first
+		static const double f[2][K] = {
+			{11976.867, 2694.363, 671.3715, 167.3595, 41.118, 5.4135},
+			{41551.671, 5471.871, 1344.4065, 335.1345, 83.5065, 18.786}
+		};
+		double ups = 1./44100;
+		if(Td::domain() && Td::domain()->hasBeenSet() && Td::spu() > 1.) ups = Td::ups();
+		for(unsigned k=0; k<K; ++k){
+			for(unsigned l=0; l<2; ++l){
+				double t = M_PI * f[l][k] * ups;
+				mC[k][l] = Tp((t - 1.) / (t + 1.));
+			}
+		}
 	}
 
 protected:
-	AllPass1<Tv, Tp, Domain1> cf0,cf1,cf2,cf3,cf4,cf5, sf0,sf1,sf2,sf3,sf4,sf5;
+	static const unsigned K = 6;	// number of stages per chain
+	Tp mC[K][2];	// coefficients, real and imaginary lanes
+	Tv mD[K][2];	// delays
 };
 
 
@@ -496,6 +893,25 @@ public:
 	Tv operator()(Tv in) const {
 		return mo[0] = mo[0]*mb[0] + in;
 	}
+
+	/// Filter a block of samples, ramping the leak coefficient (see CoefRamp)
+	void process(const Tv * in, Tv * out, unsigned n){
+		Tp b = mb[0], db;
+		Tv o = mo[0];
+		if(mRamp.begin(&b, &db, n)){
+			for(unsigned i=0; i<n; ++i){
+				b += db;
+				out[i] = o = o*b + in[i];
+			}
+		}
+		else{
+			for(unsigned i=0; i<n; ++i) out[i] = o = o*b + in[i];
+		}
+		mo[0] = o;
+	}
+
+	/// Filter a block of samples in place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
 	
 	Integrator& leak(Tp v){ mb[0]=v; return *this; }
 	Integrator& zero(){ mo[0]=Tv(0); return *this; }
@@ -503,6 +919,7 @@ public:
 protected:
 	mutable Tv mo[1];
 	Tp mb[1];
+	CoefRamp<Tp,1> mRamp;
 };
 
 
@@ -573,6 +990,11 @@ protected:
 /// This filter uses a single pole at either DC or Nyquist to create a low-pass
 /// or high-pass response, respectively.
 ///
+/// By default, the cosine of the cutoff frequency is computed with a
+/// polynomial approximation whose absolute error is below 1.1e-3. This puts
+/// the -3 dB point within 0.4% of the cutoff frequency. Filters that need
+/// exact coefficients can use precise().
+///
 /// \tparam Tv	Value (sample) type
 /// \tparam Tp	Parameter type
 /// \tparam Td	Domain observer type
@@ -598,12 +1020,28 @@ public:
 	void lag(Tp length, Tp thresh=Tp(0.001));
 
 	void smooth(Tp val);				///< Set smoothing coefficient directly
+
+	/// Set whether to compute coefficients with exact (but slower) math
+	void precise(bool v){ mPrecise=v; freq(mFreq); }
+	bool precise() const { return mPrecise; }	///< Get whether coefficients use exact math
 	void zero(){ o1=0; }				///< Zero internal delay
 	void reset(Tv v = Tv(0)){ o1=mStored=v; }
 
 	const Tv& operator()();				///< Returns filtered output using stored value
 	const Tv& operator()(Tv in);		///< Returns filtered output from input value
 
+	/// Filter a block of samples
+
+	/// The coefficients are ramped linearly across the block from their values
+	/// at the end of the previous block (see CoefRamp).
+	/// \param[in]	in		input samples
+	/// \param[out]	out		output samples; may equal in
+	/// \param[in]	n		number of samples
+	void process(const Tv * in, Tv * out, unsigned n);
+
+	/// Filter a block of samples in place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
+
 	void operator  = (Tv val);			///< Stores input value for operator()
 	void operator *= (Tv val);			///< Multiplies stored value by value
 
@@ -619,6 +1057,8 @@ protected:
 	FilterType mType;
 	Tp mFreq, mA0, mB1;
 	Tv mStored, o1;
+	CoefRamp<Tp,2> mRamp;
+	bool mPrecise;
 };
 
 
@@ -664,6 +1104,28 @@ inline Tv AllPass1<Tv,Tp,Td>::operator()(Tv i0){
 	return o0;
 }
 
+template <class Tv, class Tp, class Td>
+void AllPass1<Tv,Tp,Td>::process(const Tv * in, Tv * out, unsigned n){
+	Tp c_ = c, dc;
+	Tv z = d1;
+	if(mRamp.begin(&c_, &dc, n)){
+		for(unsigned i=0; i<n; ++i){
+			c_ += dc;
+			Tv i0 = in[i] - z * c_;
+			out[i] = i0 * c_ + z;
+			z = i0;
+		}
+	}
+	else{
+		for(unsigned i=0; i<n; ++i){
+			Tv i0 = in[i] - z * c_;
+			out[i] = i0 * c_ + z;
+			z = i0;
+		}
+	}
+	d1 = z;
+}
+
 template <class Tv, class Tp, class Td>
 inline Tv AllPass1<Tv,Tp,Td>::high(Tv i0){ return (i0 - operator()(i0)) * Tv(0.5); }
 
@@ -681,10 +1143,10 @@ void AllPass1<Tv,Tp,Td>::onDomainChange(double /*r*/){ freq(mFreq); }
 //---- Biquad
 template <class Tv, class Tp, class Td>
 Biquad<Tv,Tp,Td>::Biquad(Tp frq, Tp res, FilterType type)
-:	d1(0), d2(0), mLevel(1), mBeta(1)
+:	mA(), mB(), d1(0), d2(0), mFreq(frq), mResRecip(Tp(0.5)/res), mLevel(1), mType(type),
+	mPrecise(false)
 {
 	onDomainChange(1);
-	set(frq, res, type);
 }
 
 template <class Tv, class Tp, class Td>
@@ -708,7 +1170,7 @@ FilterType Biquad<Tv,Tp,Td>::type() const { return mType; }
 template <class Tv, class Tp, class Td>
 void Biquad<Tv,Tp,Td>::set(Tp freq_, Tp res_, FilterType type_){
 	mType = type_;
-	res(res_);
+	mResRecip = Tp(0.5)/res_;
 	freq(freq_);
 }
 
@@ -727,9 +1189,15 @@ template <class Tv, class Tp, class Td>
 inline void Biquad<Tv,Tp,Td>::freq(Tp v){
 	mFreq = v;
 	Tp w = scl::clip(mFreq * mFrqToRad, Tp(3.13));
-	mReal = scl::cosT8(w);
-	mImag = scl::sinT7(w);
-	resRecip(mResRecip);
+	if(mPrecise){
+		mReal = std::cos(w);
+		mImag = std::sin(w);
+	}
+	else{
+		mReal = scl::cosT8(w);
+		mImag = scl::sinT7(w);
+	}
+	compute();
 }
 
 /*
@@ -751,106 +1219,103 @@ inline void Biquad<Tv,Tp,Td>::width(Tp v){
 
 template <class Tv, class Tp, class Td>
 inline void Biquad<Tv,Tp,Td>::level(Tp v){
-	mLevel=v;
-	switch(mType){
-	case PEAKING:
-		mBeta = Tp(1)/mLevel;
-		break;
-	case LOW_SHELF:
-	case HIGH_SHELF:
-		mBeta = Tp(2)*std::pow(mLevel, Tp(0.25));
-		break;
-	default:
-		mBeta = Tp(1);
-	}
-	resRecip(mResRecip);
+	mLevel = v;
+	compute();
 }
 
 template <class Tv, class Tp, class Td>
-inline void Biquad<Tv,Tp,Td>::resRecip(Tp v){
-	mResRecip = v;
-	mAlpha = mImag * mResRecip * mBeta;
-
-	switch(mType){
-	case LOW_SHELF: case HIGH_SHELF: break; // coefs computed in type()
-	default:
-		// Note: b_0 is assumed to be equal to 1 in the difference equation.
-		// For this reason, we divide all other coefficients by b_0.
-		mB[0] = Tp(1) / (Tp(1) + mAlpha);	// 1/b_0
-		mB[1] = Tp(-2) * mReal * mB[0];
-		mB[2] = (Tp(1) - mAlpha) * mB[0];
-	}
-
-	type(mType);
+inline void Biquad<Tv,Tp,Td>::res(Tp v){
+	mResRecip = Tp(0.5)/v;
+	compute();
 }
 
 template <class Tv, class Tp, class Td>
-inline void Biquad<Tv,Tp,Td>::res(Tp v){
-	resRecip(Tp(0.5)/v);
+inline void Biquad<Tv,Tp,Td>::type(FilterType v){
+	mType = v;
+	compute();
 }
 
 template <class Tv, class Tp, class Td>
-inline void Biquad<Tv,Tp,Td>::type(FilterType typeA){
-	mType = typeA;
-	
-	switch(mType){
+void Biquad<Tv,Tp,Td>::design(
+	Tp * a, Tp * b, Tp re, Tp im, Tp resRecip, Tp level, FilterType type
+){
+	Tp beta;
+	switch(type){
+	case PEAKING:		beta = Tp(1)/level; break;
+	case LOW_SHELF:
+	case HIGH_SHELF:	beta = Tp(2)*std::pow(level, Tp(0.25)); break;
+	default:			beta = Tp(1);
+	}
+	Tp alpha = im * resRecip * beta;
+
+	switch(type){
+	case LOW_SHELF: case HIGH_SHELF: break; // coefs computed below
+	default:
+		// Note: b_0 is assumed to be equal to 1 in the difference equation.
+		// For this reason, we divide all other coefficients by b_0.
+		b[0] = Tp(1) / (Tp(1) + alpha);	// 1/b_0
+		b[1] = Tp(-2) * re * b[0];
+		b[2] = (Tp(1) - alpha) * b[0];
+	}
+
+	switch(type){
 	case LOW_PASS:
-		mA[1] = (Tp(1) - mReal) * mB[0];
-		mA[0] = mA[1] * Tp(0.5);
-		mA[2] = mA[0];
+		a[1] = (Tp(1) - re) * b[0];
+		a[0] = a[1] * Tp(0.5);
+		a[2] = a[0];
 		break;
 	case HIGH_PASS: // low-pass with odd k a_k and freq flipped
-		mA[1] = (Tp(-1) - mReal) * mB[0];
-		mA[0] = mA[1] * Tp(-0.5);
-		mA[2] = mA[0];
+		a[1] = (Tp(-1) - re) * b[0];
+		a[0] = a[1] * Tp(-0.5);
+		a[2] = a[0];
 		break;
 	case RESONANT:
-		mA[0] = mImag * Tp(0.5) * mB[0];
-		mA[1] = Tp(0);
-		mA[2] =-mA[0];
+		a[0] = im * Tp(0.5) * b[0];
+		a[1] = Tp(0);
+		a[2] =-a[0];
 		break;
 	case BAND_PASS:
-		mA[0] = mAlpha * mB[0];
-		mA[1] = Tp(0);
-		mA[2] =-mA[0];
+		a[0] = alpha * b[0];
+		a[1] = Tp(0);
+		a[2] =-a[0];
 		break;
 	case BAND_REJECT:
-		mA[0] = mB[0];
-		mA[1] = mB[1];
-		mA[2] = mB[0];
+		a[0] = b[0];
+		a[1] = b[1];
+		a[2] = b[0];
 		break;
 	case ALL_PASS:
-		mA[0] = mB[2];
-		mA[1] = mB[1];
-		mA[2] = Tp(1);
+		a[0] = b[2];
+		a[1] = b[1];
+		a[2] = Tp(1);
 		break;
 	case PEAKING:{
-		Tp alpha_A_b0 = mAlpha * mLevel * mB[0];
-		mA[0] = mB[0] + alpha_A_b0;
-		mA[1] = mB[1];
-		mA[2] = mB[0] - alpha_A_b0;
+		Tp alpha_A_b0 = alpha * level * b[0];
+		a[0] = b[0] + alpha_A_b0;
+		a[1] = b[1];
+		a[2] = b[0] - alpha_A_b0;
 		}
 		break;
 	case LOW_SHELF:{
-		Tp A = mBeta*mBeta*Tp(0.25); // sqrt(mLevel)
+		Tp A = beta*beta*Tp(0.25); // sqrt(level)
 		Tp Ap1 = A + Tp(1), Am1 = A - Tp(1);
-		mB[0] =    Tp(1)/(Ap1 + Am1*mReal + mAlpha); // 1/b_0
-		mB[1] =   Tp(-2)*(Am1 + Ap1*mReal         ) * mB[0];
-		mB[2] =          (Ap1 + Am1*mReal - mAlpha) * mB[0];
-		mA[0] =        A*(Ap1 - Am1*mReal + mAlpha) * mB[0];
-		mA[1] = Tp( 2)*A*(Am1 - Ap1*mReal         ) * mB[0];
-		mA[2] =        A*(Ap1 - Am1*mReal - mAlpha) * mB[0];
+		b[0] =    Tp(1)/(Ap1 + Am1*re + alpha); // 1/b_0
+		b[1] =   Tp(-2)*(Am1 + Ap1*re        ) * b[0];
+		b[2] =          (Ap1 + Am1*re - alpha) * b[0];
+		a[0] =        A*(Ap1 - Am1*re + alpha) * b[0];
+		a[1] = Tp( 2)*A*(Am1 - Ap1*re        ) * b[0];
+		a[2] =        A*(Ap1 - Am1*re - alpha) * b[0];
 		}
 		break;
 	case HIGH_SHELF:{
-		Tp A = mBeta*mBeta*Tp(0.25); // sqrt(mLevel)
+		Tp A = beta*beta*Tp(0.25); // sqrt(level)
 		Tp Ap1 = A + Tp(1), Am1 = A - Tp(1);
-		mB[0] =   Tp(1)/(Ap1 - Am1*mReal + mAlpha); // 1/b_0
-		mB[1] =   Tp(2)*(Am1 - Ap1*mReal         ) * mB[0];
-		mB[2] =         (Ap1 - Am1*mReal - mAlpha) * mB[0];
-		mA[0] =       A*(Ap1 + Am1*mReal + mAlpha) * mB[0];
-		mA[1] =Tp(-2)*A*(Am1 + Ap1*mReal         ) * mB[0];
-		mA[2] =       A*(Ap1 + Am1*mReal - mAlpha) * mB[0];
+		b[0] =   Tp(1)/(Ap1 - Am1*re + alpha); // 1/b_0
+		b[1] =   Tp(2)*(Am1 - Ap1*re        ) * b[0];
+		b[2] =         (Ap1 - Am1*re - alpha) * b[0];
+		a[0] =       A*(Ap1 + Am1*re + alpha) * b[0];
+		a[1] =Tp(-2)*A*(Am1 + Ap1*re        ) * b[0];
+		a[2] =       A*(Ap1 + Am1*re - alpha) * b[0];
 		}
 		break;
 	default:;
@@ -874,11 +1339,166 @@ inline Tv Biquad<Tv,Tp,Td>::nextBP(Tv i0){
 	return o0;
 }
 
+template <class Tv, class Tp, class Td>
+void Biquad<Tv,Tp,Td>::process(const Tv * in, Tv * out, unsigned n){
+	Tp c[5] = {mA[0], mA[1], mA[2], mB[1], mB[2]}, dc[5];
+	Tv z1 = d1, z2 = d2;
+	if(mRamp.begin(c, dc, n)){
+		for(unsigned i=0; i<n; ++i){
+			for(unsigned k=0; k<5; ++k) c[k] += dc[k];
+			Tv i0 = in[i] - z1*c[3] - z2*c[4];
+			out[i] = i0*c[0] + z1*c[1] + z2*c[2];
+			z2 = z1; z1 = i0;
+		}
+	}
+	else{
+		for(unsigned i=0; i<n; ++i){
+			Tv i0 = in[i] - z1*c[3] - z2*c[4];
+			out[i] = i0*c[0] + z1*c[1] + z2*c[2];
+			z2 = z1; z1 = i0;
+		}
+	}
+	d1 = z1; d2 = z2;
+}
+
+
+//---- BiquadBank
+template <unsigned N, class Tv, class Tp, class Td>
+BiquadBank<N,Tv,Tp,Td>::BiquadBank(Tp frq, Tp res, FilterType type){
+	for(unsigned i=0; i<N; ++i){
+		mFreq[i] = frq;
+		mRes[i] = res;
+		mLevel[i] = Tp(1);
+		mType[i] = type;
+	}
+	zero();
+	onDomainChange(1);
+}
+
+template <unsigned N, class Tv, class Tp, class Td>
+void BiquadBank<N,Tv,Tp,Td>::onDomainChange(double /*r*/){
+	for(unsigned i=0; i<N; ++i) compute(i);
+}
+
+template <unsigned N, class Tv, class Tp, class Td>
+void BiquadBank<N,Tv,Tp,Td>::compute(unsigned i){
+	Tp w = scl::clip(mFreq[i] * Tp(M_2PI * Td::ups()), Tp(3.13));
+	Tp a[3] = {}, b[3] = {};
+	Biquad<Tv,Tp,Td>::design(a, b, scl::cosT8(w), scl::sinT7(w), Tp(0.5)/mRes[i], mLevel[i], mType[i]);
+	mA0[i] = a[0];
+	mA1[i] = a[1];
+	mA2[i] = a[2];
+	mB1[i] = b[1];
+	mB2[i] = b[2];
+}
+
+template <unsigned N, class Tv, class Tp, class Td>
+void BiquadBank<N,Tv,Tp,Td>::set(unsigned i, Tp frq, Tp res, FilterType type){
+	mFreq[i] = frq;
+	mRes[i] = res;
+	mType[i] = type;
+	compute(i);
+}
+
+template <unsigned N, class Tv, class Tp, class Td>
+void BiquadBank<N,Tv,Tp,Td>::set(Tp frq, Tp res, FilterType type){
+	for(unsigned i=0; i<N; ++i) set(i, frq, res, type);
+}
+
+template <unsigned N, class Tv, class Tp, class Td>
+void BiquadBank<N,Tv,Tp,Td>::freq(unsigned i, Tp v){ mFreq[i]=v; compute(i); }
+
+template <unsigned N, class Tv, class Tp, class Td>
+void BiquadBank<N,Tv,Tp,Td>::res(unsigned i, Tp v){ mRes[i]=v; compute(i); }
+
+template <unsigned N, class Tv, class Tp, class Td>
+void BiquadBank<N,Tv,Tp,Td>::level(unsigned i, Tp v){ mLevel[i]=v; compute(i); }
+
+template <unsigned N, class Tv, class Tp, class Td>
+void BiquadBank<N,Tv,Tp,Td>::type(unsigned i, FilterType v){ mType[i]=v; compute(i); }
+
+template <unsigned N, class Tv, class Tp, class Td>
+void BiquadBank<N,Tv,Tp,Td>::coef(unsigned i, Tp a0, Tp a1, Tp a2, Tp b1, Tp b2){
+	mA0[i]=a0; mA1[i]=a1; mA2[i]=a2; mB1[i]=b1; mB2[i]=b2;
+}
+
+template <unsigned N, class Tv, class Tp, class Td>
+void BiquadBank<N,Tv,Tp,Td>::zero(){
+	for(unsigned i=0; i<N; ++i) mD1[i] = mD2[i] = Tv(0);
+}
+
+template <unsigned N, class Tv, class Tp, class Td>
+void BiquadBank<N,Tv,Tp,Td>::zero(unsigned i){
+	mD1[i] = mD2[i] = Tv(0);
+}
+
+template <unsigned N, class Tv, class Tp, class Td>
+inline void BiquadBank<N,Tv,Tp,Td>::operator()(const Tv * in, Tv * out){
+	// Direct form II, as Biquad::operator()
+	for(unsigned i=0; i<N; ++i){
+		Tv d1 = mD1[i], d2 = mD2[i];
+		Tv i0 = in[i] - d1*mB1[i] - d2*mB2[i];
+		out[i] = i0*mA0[i] + d1*mA1[i] + d2*mA2[i];
+		mD2[i] = d1; mD1[i] = i0;
+	}
+}
+
+template <unsigned N, class Tv, class Tp, class Td>
+void BiquadBank<N,Tv,Tp,Td>::process(const Tv * in, Tv * out, unsigned numFrames){
+	// Lanes are run four at a time, the width of common vector registers, so
+	// that the state and coefficients of a group of lanes stay in registers.
+	// Local copies of them keep the compiler from assuming the output aliases
+	// them, and each frame is read before any of it is written so that
+	// in-place frames can be vectorized.
+	const unsigned W = N%4 ? N : 4;
+	for(unsigned j=0; j<N; j+=W){
+		Tv d1[W], d2[W];
+		Tp a0[W], a1[W], a2[W], b1[W], b2[W];
+		for(unsigned i=0; i<W; ++i){
+			d1[i]=mD1[j+i]; d2[i]=mD2[j+i];
+			a0[i]=mA0[j+i]; a1[i]=mA1[j+i]; a2[i]=mA2[j+i];
+			b1[i]=mB1[j+i]; b2[i]=mB2[j+i];
+		}
+
+		for(unsigned n=0; n<numFrames; ++n){
+			const Tv * x = in + n*N + j;
+			Tv * y = out + n*N + j;
+			Tv i0[W], o0[W];
+			for(unsigned i=0; i<W; ++i) i0[i] = x[i] - d1[i]*b1[i] - d2[i]*b2[i];
+			for(unsigned i=0; i<W; ++i){
+				o0[i] = i0[i]*a0[i] + d1[i]*a1[i] + d2[i]*a2[i];
+				d2[i] = d1[i]; d1[i] = i0[i];
+			}
+			for(unsigned i=0; i<W; ++i) y[i] = o0[i];
+		}
+
+		for(unsigned i=0; i<W; ++i){ mD1[j+i]=d1[i]; mD2[j+i]=d2[i]; }
+	}
+}
+
+template <unsigned N, class Tv, class Tp, class Td>
+void BiquadBank<N,Tv,Tp,Td>::processBank(const Tv * in, Tv * out, unsigned numFrames){
+	Tv d1[N], d2[N];
+	for(unsigned i=0; i<N; ++i){ d1[i]=mD1[i]; d2[i]=mD2[i]; }
+
+	for(unsigned n=0; n<numFrames; ++n){
+		const Tv x = in[n];
+		Tv * y = out + n*N;
+		for(unsigned i=0; i<N; ++i){
+			Tv i0 = x - d1[i]*mB1[i] - d2[i]*mB2[i];
+			y[i] = i0*mA0[i] + d1[i]*mA1[i] + d2[i]*mA2[i];
+			d2[i] = d1[i]; d1[i] = i0;
+		}
+	}
+
+	for(unsigned i=0; i<N; ++i){ mD1[i]=d1[i]; mD2[i]=d2[i]; }
+}
+
 
 //---- OnePole
 template <class Tv, class Tp, class Td>
 OnePole<Tv,Tp,Td>::OnePole(Tp frq, const Tv& stored)
-:	mType(LOW_PASS), mFreq(frq), mStored(stored), o1(stored)
+:	mType(LOW_PASS), mFreq(frq), mStored(stored), o1(stored), mPrecise(false)
 {
 	onDomainChange(1);
 }
@@ -894,9 +1514,9 @@ inline void OnePole<Tv,Tp,Td>::type(FilterType v){
 
 namespace{
 	template<class T>
-	inline T getReal(T freq){
+	inline T getReal(T freq, bool precise){
 		freq = scl::clip(freq, T(0.5));
-		//return cos(2*M_PI * freq);
+		if(precise) return std::cos(T(M_2PI) * freq);
 		//return 1 - freq*freq*(24 - 32*freq); // cubic apx.
 		return scl::sinFast(T(1) - T(4)*freq);
 	}
@@ -913,7 +1533,7 @@ inline void OnePole<Tv,Tp,Td>::freq(Tp v){
 		// cutoff based on pole at DC (inaccurate with large bandwidth)
 		//mB1 = poleRadius(Tp(2) * v * Td::ups());
 		// b1 found by setting |H(w)| = 0.707
-		Tp re = getReal(v * Td::ups());
+		Tp re = getReal(v * Td::ups(), mPrecise);
 		Tp p1 = re - Tp(2);
 		mB1 = -(p1 + sqrt(p1*p1 - Tp(1)));
 		mA0 = Tp(1) - mB1;
@@ -923,7 +1543,7 @@ inline void OnePole<Tv,Tp,Td>::freq(Tp v){
 		// cutoff based on pole at Nyquist (inaccurate with large bandwidth)
 		//mB1 = -poleRadius(Tp(1) - Tp(2) * v * Td::ups());
 		// b1 found by setting |H(w)| = 0.707
-		Tp re = getReal(v * Td::ups());
+		Tp re = getReal(v * Td::ups(), mPrecise);
 		Tp p1 = -re - Tp(2); // -re flips cutoff
 		mB1 = (p1 + sqrt(p1*p1 - Tp(1)));
 		mA0 = Tp(1) + mB1;
@@ -960,6 +1580,22 @@ inline const Tv& OnePole<Tv,Tp,Td>::operator()(Tv in){
 	return o1;
 }
 
+template <class Tv, class Tp, class Td>
+void OnePole<Tv,Tp,Td>::process(const Tv * in, Tv * out, unsigned n){
+	Tp c[2] = {mA0, mB1}, dc[2];
+	Tv o = o1;
+	if(mRamp.begin(c, dc, n)){
+		for(unsigned i=0; i<n; ++i){
+			c[0] += dc[0]; c[1] += dc[1];
+			out[i] = o = o*c[1] + in[i]*c[0];
+		}
+	}
+	else{
+		for(unsigned i=0; i<n; ++i) out[i] = o = o*c[1] + in[i]*c[0];
+	}
+	o1 = o;
+}
+
 template <class Tv, class Tp, class Td>
 inline void OnePole<Tv,Tp,Td>::operator  = (Tv v){ mStored  = v; }
 
@@ -48,17 +48,24 @@
 
 	// Generators/Filters
 	#include "Gamma/Access.h"
+	#include "Gamma/Convolver.h"
+	#include "Gamma/CQT.h"
 	#include "Gamma/Delay.h"
 	#include "Gamma/DFT.h"
 	#include "Gamma/Domain.h"
 	#include "Gamma/Envelope.h"
 	#include "Gamma/FFT.h"
+	#include "Gamma/FIR.h"
 	#include "Gamma/Filter.h"
 	#include "Gamma/FormantData.h"
+	#include "Gamma/HRFilter.h"
+	#include "Gamma/IIRDesign.h"
 	#include "Gamma/Noise.h"
 	#include "Gamma/Oscillator.h"
+	#include "Gamma/Resampler.h"
 	#include "Gamma/SamplePlayer.h"
 	#include "Gamma/Spatial.h"
+	#include "Gamma/Spectrogram.h"
 	#include "Gamma/Recorder.h"
 	#include "Gamma/SoundFile.h"
 	#include "Gamma/UnitMaps.h"
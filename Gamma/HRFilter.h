@@ -3,6 +3,8 @@
 
 #include <cmath>
 #include <algorithm>
+#include <memory>
+#include <vector>
 #include "Gamma/Filter.h"
 #include "Gamma/Spatial.h"
 #include "Gamma/Types.h"
@@ -210,6 +212,119 @@ private:
 	float mWallAtten = 0.1;
 };
 
+
+/// Scene with a variable number of sources based on HRFilter
+
+/// Sources are added and removed at run time and spatialized a block at a
+/// time. Source slots are packed into groups of laneCount sources whose ear
+/// filters run side by side as the lanes of BiquadBank's, so a group costs
+/// little more than a single source. A new source takes the lowest free slot,
+/// which keeps the groups full.
+///
+/// A source without input, because it is inactive or its input block is null
+/// or all zeros, keeps running until its delay line and filters have rung out
+/// and is then skipped. Groups without running sources are skipped entirely.
+///
+/// Large scenes can be split across worker threads. Each group mixes into its
+/// own buffer and the buffers are summed in group order, so the output does
+/// not depend on the number of threads or how they are scheduled.
+class DynamicHRScene{
+public:
+	typedef HRFilter Source;
+
+	static const unsigned laneCount = 8;	///< Number of sources per group
+
+	/// \param[in] numSources	number of sources to add
+	DynamicHRScene(unsigned numSources=0);
+
+	~DynamicHRScene();
+
+
+	/// Add a source and return its slot index
+	unsigned addSource();
+
+	/// Remove the source in a slot; the slot may be reused by addSource()
+	void removeSource(unsigned slot);
+
+	/// Get number of sources
+	unsigned numSources() const { return mNumSources; }
+
+	/// Get number of slots; input blocks are indexed by slot
+	unsigned slots() const { return mSlots.size(); }
+
+	/// Get whether a slot holds a source
+	bool used(unsigned slot) const { return mSlots[slot].used; }
+
+	/// Get sound source in a slot
+	Source& source(unsigned slot){ return *mSlots[slot].source; }
+
+	/// Set whether a source reads its input
+	DynamicHRScene& active(unsigned slot, bool v){ mSlots[slot].active=v; return *this; }
+
+	/// Get whether a source reads its input
+	bool active(unsigned slot) const { return mSlots[slot].active; }
+
+	/// Set number of threads used by process(), including the calling thread
+	DynamicHRScene& threads(unsigned n);
+
+	/// Get number of threads used by process()
+	unsigned threads() const { return mThreads; }
+
+
+	/// Spatialize a block of source samples
+
+	/// Source parameters must not be changed while this runs.
+	///
+	/// \param[in] in		input blocks, one for each slot; null blocks
+	///						are silent
+	/// \param[out] outL	left output samples
+	/// \param[out] outR	right output samples
+	/// \param[in] n		number of samples
+	void process(const float * const * in, float * outL, float * outR, unsigned n);
+
+
+	DynamicHRScene& far(float v);
+	DynamicHRScene& reverbDecay(float v){ for(auto& r:mReverbs) r.decay(v); return *this; }
+	DynamicHRScene& reverbDamping(float v){ for(auto& r:mReverbs) r.damping(v); return *this; }
+	DynamicHRScene& wallAtten(float v){ mWallAtten=v; return *this; }
+
+private:
+	struct Slot{
+		std::unique_ptr<Source> source;
+		const float * in = nullptr;	// input block, null when silent
+		unsigned quiet = 0;			// samples since last input
+		bool used = false;
+		bool active = true;
+		bool running = false;		// still ringing from past input
+	};
+
+	// Ear filters of a group of sources, one lane per source
+	struct Group{
+		BiquadBank<laneCount, float> filters[2][4];
+		float shadow[2][laneCount];
+	};
+
+	class Workers;
+
+	std::vector<Slot> mSlots;
+	std::vector<std::unique_ptr<Group>> mGroups;
+	std::vector<unsigned> mRunning;	// indices of groups with running sources
+	std::vector<float> mMix;		// left, right and room mix of each group
+	std::vector<float> mRoom, mEcho;
+	ReverbMS<> mReverbs[2]; 		// one reverb for each ear
+	unsigned mNumSources = 0;
+	unsigned mBlock = 0;			// samples in current block
+	unsigned mThreads = 1;
+	float mFar = 0.5;
+	float mWallAtten = 0.1;
+	Workers * mWorkers = nullptr;
+
+	void processGroups(unsigned thread);
+	void processGroup(unsigned group);
+	float * mix(unsigned group, unsigned chan){ return &mMix[(group*3 + chan)*mBlock]; }
+	void silence(unsigned slot);
+};
+
 } // gam::
 
 #endif
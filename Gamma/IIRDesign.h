@@ -0,0 +1,337 @@
+#ifndef GAMMA_IIR_DESIGN_H_INC
+#define GAMMA_IIR_DESIGN_H_INC
+
+/*	Gamma - Generic processing library
+	See COPYRIGHT file for authors and license information
+
+	File Description:
+	Higher-order IIR filter design as cascades of second-order sections.
+*/
+
+#include <vector>
+#include "Gamma/Filter.h"
+#include "Gamma/TransferFunc.h"
+
+namespace gam{
+
+/// Higher-order IIR filter response families
+enum IIRFamily{
+	BUTTERWORTH,		/**< Maximally flat passband */
+	CHEBYSHEV1,			/**< Equiripple passband, monotonic stopband */
+	CHEBYSHEV2,			/**< Monotonic passband, equiripple stopband */
+	ELLIPTIC,			/**< Equiripple passband and stopband */
+	LINKWITZ_RILEY		/**< Squared Butterworth, for crossovers */
+};
+
+
+
+/// Coefficients of a second-order section
+
+/// The section has the transfer function
+///	H(z) = (a0 + a1 z^-1 + a2 z^-2) / (1 + b1 z^-1 + b2 z^-2),
+/// the same as Biquad. A first-order section has a2 and b2 equal to zero.
+/// \ingroup Filter
+struct BiquadCoef{
+	double a0, a1, a2;	///< Feedforward coefficients
+	double b1, b2;		///< Feedback coefficients
+
+	/// Set coefficients of a Biquad
+	template <class Filter>
+	void to(Filter& f) const { f.coef(a0, a1, a2, b1, b2); }
+
+	/// Get transfer function
+	TransferFunc transferFunc() const;
+};
+
+
+
+/// Higher-order IIR filter design
+
+/// This designs Butterworth, Chebyshev type I and II, elliptic and
+/// Linkwitz-Riley filters of arbitrary order as cascades of second-order
+/// sections. An analog prototype is transformed to the requested type and
+/// then to digital by the bilinear transform with prewarped band edges.
+///
+/// Poles are paired with the nearest zeros, starting with the poles closest
+/// to the unit circle, and sections are ordered from the least to the most
+/// resonant. Each section has unit gain at the center of the passband (DC,
+/// Nyquist or the geometric center of the band), which keeps intermediate
+/// signal levels close to those of the input.
+///
+/// The edge frequency is the -3 dB point for Butterworth, the -6 dB point for
+/// Linkwitz-Riley, the end of the passband ripple for Chebyshev type I and
+/// elliptic, and the start of the stopband for Chebyshev type II.
+///
+/// Band-pass and band-reject filters have twice the given order.
+/// Linkwitz-Riley orders are rounded up to the next even number. The
+/// Linkwitz-Riley high-pass has negative gain when the order is not a
+/// multiple of 4, so the low- and high-pass of any order sum to an all-pass.
+///
+/// Frequencies are in domain units. They are converted to cycles per sample
+/// by the sample interval passed to sections(), which is 1 by default.
+/// \ingroup Filter
+class IIRDesign{
+public:
+
+	/// \param[in] family	response family
+	/// \param[in] type		LOW_PASS, HIGH_PASS, BAND_PASS or BAND_REJECT
+	/// \param[in] order	order of analog prototype
+	/// \param[in] freq		edge frequency
+	IIRDesign(IIRFamily family=BUTTERWORTH, FilterType type=LOW_PASS,
+		unsigned order=2, double freq=1000);
+
+
+	/// Set response family
+	IIRDesign& family(IIRFamily v){ mFamily=v; return *this; }
+
+	/// Set type (LOW_PASS, HIGH_PASS, BAND_PASS or BAND_REJECT)
+	IIRDesign& type(FilterType v){ mType=v; return *this; }
+
+	/// Set order of analog prototype
+	IIRDesign& order(unsigned v){ mOrder=v; return *this; }
+
+	/// Set edge frequency of low-pass or high-pass type
+	IIRDesign& freq(double v){ mFreq1=mFreq2=v; return *this; }
+
+	/// Set band edge frequencies of band-pass or band-reject type
+	IIRDesign& freq(double lo, double hi){ mFreq1=lo; mFreq2=hi; return *this; }
+
+	/// Set passband ripple, in dB (CHEBYSHEV1 and ELLIPTIC only)
+	IIRDesign& ripple(double dB){ mRipple=dB; return *this; }
+
+	/// Set minimum stopband attenuation, in dB (CHEBYSHEV2 and ELLIPTIC only)
+	IIRDesign& attenuation(double dB){ mAtten=dB; return *this; }
+
+
+	IIRFamily family() const { return mFamily; }	///< Get response family
+	FilterType type() const { return mType; }		///< Get type
+	unsigned order() const { return mOrder; }		///< Get order of analog prototype
+	double freq() const { return mFreq1; }			///< Get (lower) edge frequency
+	double freqHigh() const { return mFreq2; }		///< Get upper edge frequency
+	double ripple() const { return mRipple; }		///< Get passband ripple, in dB
+	double attenuation() const { return mAtten; }	///< Get stopband attenuation, in dB
+
+
+	/// Compute second-order sections
+
+	/// \param[in] ups	sample interval, in domain units
+	///
+	std::vector<BiquadCoef> sections(double ups=1) const;
+
+	/// Get transfer function of the whole cascade
+
+	/// The section polynomials are multiplied out, which loses precision for
+	/// high orders with poles close to the unit circle. The frequency response
+	/// of IIRCascade is exact.
+	TransferFunc transferFunc(double ups=1) const;
+
+private:
+	IIRFamily mFamily;
+	FilterType mType;
+	unsigned mOrder;
+	double mFreq1, mFreq2;
+	double mRipple, mAtten;
+};
+
+
+
+/// Cascade of second-order sections
+
+/// This runs the sections of an IIRDesign in series. Block processing takes
+/// the sections in groups of four (or two for the remainder) and skews each
+/// group in time: section s of a group filters input sample t-s while its
+/// first section filters sample t. The pipeline is filled and drained within
+/// each block, so there is no added latency.
+///
+/// \tparam Tv	Value (sample) type
+/// \tparam Tp	Parameter type
+/// \tparam Td	Domain observer type
+/// \ingroup Filter
+template <class Tv=gam::real, class Tp=gam::real, class Td=DomainObserver>
+class IIRCascade : public Td{
+public:
+
+	/// \param[in] design	filter design, with frequencies in domain units
+	IIRCascade(const IIRDesign& design = IIRDesign()){ this->design(design); }
+
+
+	/// Set filter design, with frequencies in domain units
+	void design(const IIRDesign& v){ mDesign = v; onDomainChange(1); }
+
+	/// Set sections directly
+	void sections(const std::vector<BiquadCoef>& v);
+
+	/// Zero internal delays
+	void zero();
+
+
+	/// Filter next sample
+	Tv operator()(Tv in);
+
+	/// Filter a block of samples
+
+	/// \param[in]	in		input samples
+	/// \param[out]	out		output samples; may equal in
+	/// \param[in]	n		number of samples
+	void process(const Tv * in, Tv * out, unsigned n);
+
+	/// Filter a block of samples in place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
+
+
+	/// Get filter design
+	const IIRDesign& design() const { return mDesign; }
+
+	/// Get number of sections
+	unsigned numSections() const { return mNumSections; }
+
+	/// Get coefficients of a section
+	BiquadCoef section(unsigned i) const {
+		return BiquadCoef{mA0[i], mA1[i], mA2[i], mB1[i], mB2[i]};
+	}
+
+	/// Get frequency response at a frequency in domain units
+	TransferFunc::Complex response(double freq) const;
+
+	void onDomainChange(double r){ sections(mDesign.sections(Td::ups())); }
+
+protected:
+	IIRDesign mDesign;
+	unsigned mNumSections = 0;
+	std::vector<Tp> mA0, mA1, mA2, mB1, mB2;	// coefficients, by section
+	std::vector<Tv> mD1, mD2;					// inner sample delays, by section
+
+	template <unsigned L>
+	void processGroup(unsigned g, const Tv * in, Tv * out, unsigned n);
+	void processSection(unsigned s, const Tv * in, Tv * out, unsigned n);
+};
+
+
+
+// Implementation_______________________________________________________________
+
+template <class Tv, class Tp, class Td>
+void IIRCascade<Tv,Tp,Td>::sections(const std::vector<BiquadCoef>& v){
+	unsigned S = v.size();
+	mA0.resize(S); mA1.resize(S); mA2.resize(S); mB1.resize(S); mB2.resize(S);
+	for(unsigned i=0; i<S; ++i){
+		mA0[i] = v[i].a0; mA1[i] = v[i].a1; mA2[i] = v[i].a2;
+		mB1[i] = v[i].b1; mB2[i] = v[i].b2;
+	}
+	if(mNumSections != S){
+		mNumSections = S;
+		mD1.resize(S); mD2.resize(S);
+		zero();
+	}
+}
+
+template <class Tv, class Tp, class Td>
+void IIRCascade<Tv,Tp,Td>::zero(){
+	for(auto& v : mD1) v = Tv(0);
+	for(auto& v : mD2) v = Tv(0);
+}
+
+template <class Tv, class Tp, class Td>
+inline Tv IIRCascade<Tv,Tp,Td>::operator()(Tv in){
+	// Direct form II, as Biquad::operator()
+	for(unsigned s=0; s<mNumSections; ++s){
+		Tv i0 = in - mD1[s]*mB1[s] - mD2[s]*mB2[s];
+		in = i0*mA0[s] + mD1[s]*mA1[s] + mD2[s]*mA2[s];
+		mD2[s] = mD1[s]; mD1[s] = i0;
+	}
+	return in;
+}
+
+template <class Tv, class Tp, class Td>
+void IIRCascade<Tv,Tp,Td>::process(const Tv * in, Tv * out, unsigned n){
+	if(0 == mNumSections){
+		if(in != out) for(unsigned i=0; i<n; ++i) out[i] = in[i];
+		return;
+	}
+	// later sections filter the output of earlier ones in place
+	unsigned s = 0;
+	for(; s+4 <= mNumSections; s+=4){
+		processGroup<4>(s, in, out, n);
+		in = out;
+	}
+	if(s+2 <= mNumSections){
+		processGroup<2>(s, in, out, n);
+		in = out;
+		s += 2;
+	}
+	if(s < mNumSections){
+		processSection(s, in, out, n);
+	}
+}
+
+template <class Tv, class Tp, class Td>
+void IIRCascade<Tv,Tp,Td>::processSection(unsigned s, const Tv * in, Tv * out, unsigned n){
+	const Tp a0 = mA0[s], a1 = mA1[s], a2 = mA2[s], b1 = mB1[s], b2 = mB2[s];
+	Tv d1 = mD1[s], d2 = mD2[s];
+	for(unsigned t=0; t<n; ++t){
+		Tv i0 = in[t] - d1*b1 - d2*b2;
+		out[t] = i0*a0 + d1*a1 + d2*a2;
+		d2 = d1; d1 = i0;
+	}
+	mD1[s] = d1; mD2[s] = d2;
+}
+
+template <class Tv, class Tp, class Td>
+template <unsigned L>
+void IIRCascade<Tv,Tp,Td>::processGroup(unsigned g, const Tv * in, Tv * out, unsigned n){
+	Tp a0[L], a1[L], a2[L], b1[L], b2[L];
+	Tv d1[L], d2[L], x[L], y[L];
+	for(unsigned s=0; s<L; ++s){
+		a0[s] = mA0[g+s]; a1[s] = mA1[g+s]; a2[s] = mA2[g+s];
+		b1[s] = mB1[g+s]; b2[s] = mB2[g+s];
+		d1[s] = mD1[g+s]; d2[s] = mD2[g+s];
+		x[s] = y[s] = Tv(0);
+	}
+
+	// At step t, section s filters sample t-s. Only sections [sb, se) have
+	// a sample to filter while the pipeline fills and drains.
+	auto partialStep = [&](unsigned t){
+		if(t < n) x[0] = in[t];
+		unsigned sb = t < n ? 0 : t-n+1;
+		unsigned se = t < L ? t+1 : L;
+		for(unsigned s=sb; s<se; ++s){
+			Tv i0 = x[s] - d1[s]*b1[s] - d2[s]*b2[s];
+			y[s] = i0*a0[s] + d1[s]*a1[s] + d2[s]*a2[s];
+			d2[s] = d1[s]; d1[s] = i0;
+		}
+		for(unsigned s=se-1; s>sb; --s) x[s] = y[s-1];
+		if(sb < se && se < L) x[se] = y[se-1];
+		if(se == L) out[t+1-L] = y[L-1];
+	};
+
+	unsigned t = 0;
+	for(; t<L-1 && t<n; ++t) partialStep(t);
+
+	// All sections busy
+	for(; t<n; ++t){
+		x[0] = in[t];
+		for(unsigned s=0; s<L; ++s){
+			Tv i0 = x[s] - d1[s]*b1[s] - d2[s]*b2[s];
+			y[s] = i0*a0[s] + d1[s]*a1[s] + d2[s]*a2[s];
+			d2[s] = d1[s]; d1[s] = i0;
+		}
+		for(unsigned s=L-1; s>0; --s) x[s] = y[s-1];
+		out[t+1-L] = y[L-1];
+	}
+
+	for(; t<n+L-1; ++t) partialStep(t);
+
+	for(unsigned s=0; s<L; ++s){ mD1[g+s] = d1[s]; mD2[g+s] = d2[s]; }
+}
+
+template <class Tv, class Tp, class Td>
+TransferFunc::Complex IIRCascade<Tv,Tp,Td>::response(double freq) const {
+	TransferFunc::Complex H(1);
+	double f = freq * Td::ups();
+	for(unsigned i=0; i<numSections(); ++i) H *= section(i).transferFunc()(f);
+	return H;
+}
+
+} // gam::
+
+#endif
@@ -0,0 +1,352 @@
+#ifndef GAMMA_RESAMPLER_H_INC
+#define GAMMA_RESAMPLER_H_INC
+
+/*	Gamma - Generic processing library
+	See COPYRIGHT file for authors and license information
+
+	File Description:
+	Arbitrary-ratio sample rate conversion by windowed-sinc interpolation.
+*/
+
+#include <memory>
+#include <vector>
+#include "Gamma/Containers.h"
+#include "Gamma/FIR.h"
+#include "Gamma/Strategy.h"
+
+namespace gam{
+
+/// Polyphase table of a windowed-sinc interpolation kernel
+
+/// The kernel is a sinc function with a Kaiser window that spans taps()
+/// input samples. It is tabulated at phases() fractional offsets between
+/// input samples and linearly interpolated between them. The transition band
+/// is placed a quarter of its width below the Nyquist frequency, so anything
+/// that aliases past the stopband edge only lands above the passband edge.
+///
+/// Tables are immutable and shared between all users of the same parameters.
+/// They are freed when the last user goes away.
+///
+/// \ingroup Filter
+class SincTable{
+public:
+
+	/// Quality presets
+	enum Quality{
+		FAST,		/**< 16 taps, 60 dB, passband to 0.66 Nyquist */
+		MEDIUM,		/**< 32 taps, 80 dB, passband to 0.76 Nyquist */
+		HIGH,		/**< 64 taps, 110 dB, passband to 0.83 Nyquist */
+		BEST		/**< 128 taps, 140 dB, passband to 0.89 Nyquist */
+	};
+
+	/// Get shared table of a quality preset
+	static std::shared_ptr<const SincTable> get(Quality q);
+
+	/// Get shared table
+
+	/// \param[in] taps			number of input samples spanned; rounded up
+	///							to an even number
+	/// \param[in] phases		number of tabulated fractional offsets
+	/// \param[in] attenuation	stopband attenuation, in dB
+	static std::shared_ptr<const SincTable> get(unsigned taps, unsigned phases, double attenuation);
+
+	SincTable(unsigned taps, unsigned phases, double attenuation);
+
+
+	/// Compute kernel coefficients for a fractional position
+
+	/// The coefficients apply to the span(scale) input samples starting
+	/// span(scale)/2 - 1 samples before the integer part of the position.
+	///
+	/// \param[out] dst		span(scale) coefficients
+	/// \param[in] frac		fractional part of position, in [0, 1)
+	/// \param[in] scale	cutoff scale; values below 1 stretch the kernel
+	///						to lower its cutoff for downsampling
+	void coefs(float * dst, double frac, double scale=1) const;
+
+	/// Interpolate at a fractional position with the unit scale kernel
+
+	/// This is the dot product of coefs(frac) with the taps() samples
+	/// starting at x. It is computed from the dot products of x with the two
+	/// neighboring rows so that no coefficients need to be stored.
+	///
+	template <class Tv>
+	Tv interpolate(const Tv * x, double frac) const;
+
+	/// Get number of input samples a kernel with a cutoff scale spans
+	unsigned span(double scale=1) const;
+
+	/// Get kernel value at a time offset, in input samples
+	float at(double t) const;
+
+
+	unsigned taps() const { return mTaps; }				///< Get number of taps at unit scale
+	unsigned phases() const { return mPhases; }			///< Get number of tabulated phases
+	double attenuation() const { return mAttenuation; }	///< Get stopband attenuation, in dB
+	double cutoff() const { return mCutoff; }			///< Get cutoff, as a fraction of the sample rate
+	double passband() const { return mPassband; }		///< Get passband edge, as a fraction of the sample rate
+
+	/// Get coefficients at fractional offset p/phases(), for p in [0, phases()]
+	const float * row(unsigned p) const { return &mTable[p*mTaps]; }
+
+private:
+	std::vector<float> mTable;
+	std::vector<float> mDense;	// kernel ordered by time, for stretching
+	unsigned mTaps, mPhases;
+	double mAttenuation, mCutoff, mPassband;
+};
+
+
+
+/// Streaming arbitrary-ratio resampler
+
+/// Output sample m interpolates the input at position t_m = t_{m-1} + ratio,
+/// with t_0 = 0 at the first input after a reset, so the output is aligned
+/// in time with the input. An output is produced once latency() inputs
+/// past its position have arrived.
+///
+/// For ratios above 1 (downsampling) the kernel is stretched to lower its
+/// cutoff, so the cost per output grows with the ratio. The ratio may be
+/// changed between calls to process() for pitch bends or Doppler shifts.
+///
+/// \tparam Tv	value type
+/// \ingroup Filter
+template <class Tv=float>
+class Resampler{
+public:
+
+	/// \param[in] ratio	input samples per output sample, i.e. the input
+	///						rate divided by the output rate
+	/// \param[in] q		kernel quality
+	Resampler(double ratio=1, SincTable::Quality q=SincTable::HIGH)
+	:	mTable(SincTable::get(q)), mRatio(ratio), mMaxRatio(ratio)
+	{
+		this->ratio(ratio);
+		reset();
+	}
+
+
+	/// Set input samples per output sample
+
+	/// Input history is kept for the largest ratio set so far. Raising the
+	/// ratio above that reads zeros in place of the missing history for the
+	/// next few outputs; use maxRatio() beforehand to avoid this.
+	///
+	Resampler& ratio(double v){
+		mRatio = v;
+		mMaxRatio = scl::max(mMaxRatio, v);
+		mCoef.resize(span());
+		return *this;
+	}
+
+	/// Keep enough input history for ratios up to a maximum
+	Resampler& maxRatio(double v){
+		mMaxRatio = scl::max(mMaxRatio, v);
+		return *this;
+	}
+
+	/// Set ratio from input and output sample rates
+	Resampler& rates(double srcRate, double dstRate){ return ratio(srcRate/dstRate); }
+
+	/// Set kernel quality
+	Resampler& quality(SincTable::Quality q){ return table(SincTable::get(q)); }
+
+	/// Set kernel table
+	Resampler& table(const std::shared_ptr<const SincTable>& v){
+		mTable = v;
+		return ratio(mRatio);
+	}
+
+	/// Resample a block
+
+	/// All inputs are consumed. Outputs beyond maxOut are held back until
+	/// the next call.
+	///
+	/// \param[in] in		input samples
+	/// \param[in] numIn	number of input samples
+	/// \param[out] out		output samples
+	/// \param[in] maxOut	maximum number of output samples to write;
+	///						numIn/ratio() + 1 are enough to produce all
+	///						available outputs
+	/// \returns number of output samples written
+	unsigned process(const Tv * in, unsigned numIn, Tv * out, unsigned maxOut);
+
+	/// Clear input history and restart output position at next input
+	void reset();
+
+
+	double ratio() const { return mRatio; }		///< Get input samples per output sample
+	const SincTable& table() const { return *mTable; }	///< Get kernel table
+
+	/// Get number of inputs needed beyond an output's position
+	unsigned latency() const { return span()/2; }
+
+	/// Get number of inputs read per output
+	unsigned span() const { return mTable->span(scale(mRatio)); }
+
+private:
+	std::shared_ptr<const SincTable> mTable;
+	std::vector<Tv> mBuf;		// input history
+	std::vector<float> mCoef;
+	double mPos;				// position of next output in mBuf
+	double mRatio, mMaxRatio;
+
+	static double scale(double ratio){ return ratio > 1. ? 1./ratio : 1.; }
+};
+
+
+
+namespace ipl{
+
+/// Type reported by Sinc; Switchable cannot switch to it
+const Type SINC = Type(ALLPASS + 1);
+
+/// Windowed-sinc random-access interpolation strategy
+
+/// This uses a shared SincTable and is much cleaner than cubic interpolation
+/// at the cost of reading taps() neighbors. By default the kernel suits
+/// reading at up to one element per output. To read faster without aliasing,
+/// set the read ratio, e.g. for a SamplePlayer
+///
+///		player.ipol().ratio(player.rate() * player.frameRate() / player.spu());
+///
+/// \ingroup Strategy, ipl
+template <class T>
+struct Sinc{
+
+	Sinc(SincTable::Quality q=SincTable::MEDIUM)
+	:	mTable(SincTable::get(q)), mScale(1){ ratio(1); }
+
+	ipl::Type type() const { return SINC; }
+	void type(ipl::Type v){}
+
+	/// Set kernel quality
+	void quality(SincTable::Quality q){ mTable = SincTable::get(q); ratio(1./mScale); }
+
+	/// Set elements read per output; values above 1 stretch the kernel
+	void ratio(double v){
+		mScale = v > 1. ? 1./v : 1.;
+		unsigned n = mTable->span(mScale);
+		mCoef.resize(n);
+		mTmp.resize(n);
+	}
+
+	/// Return interpolated element from power-of-2 array
+	T operator()(const ArrayPow2<T>& a, uint32_t phase) const{
+		unsigned n = mCoef.size();
+		uint32_t one = a.oneIndex();
+		uint32_t p = phase - (n/2-1)*one;
+		for(unsigned k=0; k<n; ++k){ mTmp[k] = a.atPhase(p); p += one; }
+		return interpolate(&mTmp[0], a.fraction(phase));
+	}
+
+	/// Return interpolated element from array
+
+	/// \tparam AccessStrategy	access strategy type (\sa access)
+	///
+	/// \param[in] acc			access strategy
+	/// \param[in] src			source array
+	/// \param[in] iInt			integer part of index
+	/// \param[in] iFrac		fractional part of index, in [0, 1)
+	/// \param[in] max			maximum index for accessing
+	/// \param[in] min			minimum index for accessing
+	template <class AccessStrategy>
+	T operator()(const AccessStrategy& acc, const T * src, index_t iInt, double iFrac, index_t max, index_t min=0) const{
+		index_t n = mCoef.size();
+		index_t i0 = iInt - (n/2-1);
+		if(i0 >= min && i0+n-1 <= max){
+			return interpolate(src + i0, iFrac);
+		}
+		// Neighbors cross an end, so map them one at a time. The mapping
+		// only handles one crossing, so the source should be longer than
+		// the kernel.
+		for(index_t k=0; k<n; ++k) mTmp[k] = src[acc.map(i0+k, max, min)];
+		return interpolate(&mTmp[0], iFrac);
+	}
+
+	T operator()(const T * src, index_t iInt, double iFrac, index_t max, index_t min=0) const{
+		return (*this)(acc::Wrap(), src, iInt, iFrac, max, min);
+	}
+
+private:
+	std::shared_ptr<const SincTable> mTable;
+	double mScale;
+
+	T interpolate(const T * x, double frac) const {
+		if(mScale >= 1.) return mTable->interpolate(x, frac);
+		mTable->coefs(&mCoef[0], frac, mScale);
+		return firDot(&mCoef[0], x, mCoef.size());
+	}
+
+	mutable std::vector<float> mCoef;
+	mutable std::vector<T> mTmp;
+};
+
+} // ipl::
+
+
+
+
+// Implementation_______________________________________________________________
+
+template <class Tv>
+Tv SincTable::interpolate(const Tv * x, double frac) const {
+	double q = frac*mPhases;
+	unsigned p = unsigned(q);
+	if(p >= mPhases) p = mPhases-1;
+	const float * r0 = row(p);
+	Tv y0 = firDot(r0, x, mTaps);
+	Tv y1 = firDot(r0 + mTaps, x, mTaps);
+	return y0 + Tv(q - p)*(y1 - y0);
+}
+
+template <class Tv>
+void Resampler<Tv>::reset(){
+	// Zeros before the first input let the first output be centered on it
+	unsigned left = span()/2 - 1;
+	mBuf.assign(left, Tv(0));
+	mPos = left;
+}
+
+template <class Tv>
+unsigned Resampler<Tv>::process(const Tv * in, unsigned numIn, Tv * out, unsigned maxOut){
+	mBuf.insert(mBuf.end(), in, in+numIn);
+
+	const double s = scale(mRatio);
+	const unsigned n = span();
+	unsigned no = 0;
+
+	while(no < maxOut){
+		long i = long(mPos);
+		long i0 = i - long(n/2) + 1;
+		if(i0 < 0){
+			// The ratio grew before enough history was kept; pad with zeros
+			mBuf.insert(mBuf.begin(), -i0, Tv(0));
+			mPos -= i0;
+			continue;
+		}
+		if(size_t(i0) + n > mBuf.size()) break;
+		if(s >= 1.){
+			out[no++] = mTable->interpolate(&mBuf[i0], mPos - i);
+		}
+		else{
+			mTable->coefs(&mCoef[0], mPos - i, s);
+			out[no++] = firDot(&mCoef[0], &mBuf[i0], n);
+		}
+		mPos += mRatio;
+	}
+
+	// Keep enough history for the largest ratio used so far
+	long drop = long(mPos) - long(mTable->span(scale(mMaxRatio))/2) + 1;
+	if(drop > 0){
+		if(drop > long(mBuf.size())) drop = mBuf.size();
+		mBuf.erase(mBuf.begin(), mBuf.begin() + drop);
+		mPos -= drop;
+	}
+
+	return no;
+}
+
+} // gam::
+
+#endif
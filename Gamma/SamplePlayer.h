@@ -124,6 +124,8 @@ public:
 	double posInInterval(double frac) const;///< Get position from fraction within interval
 	double rate() const { return mRate; }	///< Get playback rate
 
+	Si<T>& ipol(){ return mIpol; }			///< Get interpolation strategy
+
 
 	void onDomainChange(double r){ frameRate(mFrameRate); }
 
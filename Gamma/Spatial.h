@@ -229,6 +229,9 @@ enum ReverbFlavor{
 /// very metallic sounding responses due to the fixed resonances of the comb 
 /// filters.
 ///
+/// Comb lines share one DelayPool; delays are whole samples. The
+/// interpolation strategy applies to the allpasses.
+///
 /// \tparam Tv			Value (sample) type
 /// \tparam LoopFilter	Filter to insert in comb feedback loop
 /// \tparam Si			Interpolation strategy
@@ -243,7 +246,6 @@ template<
 class ReverbMS : public Td {
 public:
 
-	typedef std::vector<Echo<Tv, Si, LoopFilter, Domain1>> Combs;
 	typedef std::vector<Comb<Tv, Si, float, Domain1>> Allpasses;
 
 	ReverbMS();
@@ -279,6 +281,16 @@ public:
 	/// Filter next sample
 	Tv operator()(Tv in);
 
+	/// Filter a block of samples
+
+	/// \param[in]	in		input samples
+	/// \param[out]	out		output samples; may equal in
+	/// \param[in]	n		number of samples
+	void process(const Tv * in, Tv * out, unsigned n);
+
+	/// Filter a block of samples in place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
+
 	/// Get sum of comb delay taps
 	Tv read(std::initializer_list<unsigned> delays) const;
 
@@ -286,14 +298,25 @@ public:
 	/// Get decay length
 	float decay() const { return mDecay; }
 
-	Combs& combs(){ return mCombs; }
+	/// Get number of combs
+	unsigned combs() const { return mCombDelays.size(); }
+
+	/// Get delay length of a comb, in samples
+	unsigned combDelay(unsigned i) const { return mCombDelays[i]; }
+
+	/// Get loop filter of a comb
+	LoopFilter<Tv>& loopFilter(unsigned i){ return mCombFilters[i]; }
+
 	Allpasses& allpasses(){ return mAllpasses; }
 
 	void print() const;
 
 private:
 	float mDecay;
-	Combs mCombs;
+	DelayPool<Tv> mCombLines;
+	std::vector<unsigned> mCombDelays;
+	std::vector<LoopFilter<Tv>> mCombFilters;
+	std::vector<Tv *> mCombPtrs;	// read and write pointers of block spans
 	Allpasses mAllpasses;
 
 	virtual void onDomainChange(double r){
@@ -303,6 +326,109 @@ private:
 
 
 
+/// Feedback matrices of a feedback delay network
+enum FeedbackMatrix{
+	HADAMARD,	/**< Hadamard, mixes every line with every other */
+	HOUSEHOLDER	/**< Householder reflection, I - 2/N */
+};
+
+
+/// Feedback delay network reverberator
+
+/// N delay lines feed back into each other through an orthogonal matrix, so
+/// each echo is spread to every line on its next pass and the echo density
+/// grows much faster than with parallel combs. The Hadamard matrix is applied
+/// with a fast Walsh-Hadamard transform in N log N additions and the
+/// Householder reflection with N additions and N multiplies. Each line has a
+/// one-pole damping filter, as Loop1P, whose gain sets the decay length.
+/// The lengths of the lines can be modulated by sinusoids at spread phases to
+/// smear the resonances of the network.
+///
+/// Lines are stored in one DelayPool.
+///
+/// \tparam N	number of delay lines: 4, 8 or 16
+/// \tparam Tv	Value (sample) type
+/// \tparam Td	Domain type
+/// \ingroup Spatial
+template <unsigned N = 8, typename Tv = gam::real, class Td = DomainObserver>
+class FDNReverb : public Td {
+public:
+
+	/// \param[in] decay		decay length, in domain units
+	/// \param[in] damping		damping amount, in [0, 1)
+	FDNReverb(float decay=1, float damping=0.2);
+
+
+	/// Set delay line lengths, in samples
+
+	/// The lengths should be mutually prime. The default lengths are spread
+	/// between 1031 and 4813 samples.
+	FDNReverb& resize(std::initializer_list<unsigned> delays);
+
+	/// Set delay line lengths, in samples
+	FDNReverb& resize(const unsigned * delays);
+
+	/// Set decay length, in domain units
+	FDNReverb& decay(float v);
+
+	/// Set damping amount, in [0, 1)
+	FDNReverb& damping(float v);
+
+	/// Set feedback matrix
+	FDNReverb& matrix(FeedbackMatrix v){ mMatrix = v; return *this; }
+
+	/// Set modulation of line lengths
+
+	/// The depth is limited to one sample less than the shortest line.
+	/// Raising it past the room allocated so far reallocates and zeros the
+	/// lines.
+	///
+	/// \param[in] depth		peak deviation of line lengths, in samples
+	/// \param[in] freq		modulation frequency, in domain units
+	FDNReverb& modulate(float depth, float freq=0.5);
+
+	/// Zero delay lines and filter states
+	void zero();
+
+
+	/// Filter next sample
+	Tv operator()(Tv in);
+
+	/// Filter a block of samples
+
+	/// \param[in]	in		input samples
+	/// \param[out]	out		output samples; may equal in
+	/// \param[in]	n		number of samples
+	void process(const Tv * in, Tv * out, unsigned n){
+		for(unsigned i=0; i<n; ++i) out[i] = (*this)(in[i]);
+	}
+
+	/// Filter a block of samples in place
+	void process(Tv * io, unsigned n){ process(io, io, n); }
+
+
+	float decay() const { return mDecay; }			///< Get decay length
+	float damping() const { return mB1; }			///< Get damping amount
+	FeedbackMatrix matrix() const { return mMatrix; }	///< Get feedback matrix
+	unsigned delay(unsigned line) const { return mDelay[line]; }	///< Get a line's length, in samples
+	static unsigned size(){ return N; }				///< Get number of lines
+
+	void onDomainChange(double r);
+
+private:
+	static_assert(N==4 || N==8 || N==16, "FDNReverb must have 4, 8 or 16 lines");
+
+	DelayPool<Tv> mPool;
+	unsigned mDelay[N];
+	float mA0[N];		// loop filter gains
+	Tv mO1[N];			// loop filter states
+	float mPhase[N];	// modulator phases, in [-1, 1)
+	float mB1, mDecay, mDepth, mModFreq, mModInc;
+	FeedbackMatrix mMatrix;
+};
+
+
+
 /// Spatializes a source at one or more destinations
 
 /// This effectively samples the wave field produced by a single source at
@@ -349,6 +475,15 @@ public:
 	/// Filter source sound
 	Vec<Ndest, T> operator()(T in);
 
+	/// Filter a block of source sound
+
+	/// This gives the same output as calling operator()(T) on each sample.
+	///
+	/// \param[in] in		source samples
+	/// \param[out] out		Ndest arrays of n samples, one for each destination
+	/// \param[in] n		number of samples
+	void process(const T * in, T * const * out, unsigned n);
+
 	/// Get delay line
 	const Delay<T>& delayLine() const { return mDelay; }
 
@@ -484,14 +619,10 @@ ReverbMS<TARG>::ReverbMS(){
 
 template<TDEC>
 ReverbMS<TARG>& ReverbMS<TARG>::resizeComb(std::initializer_list<unsigned> delays){
-	if(delays.size() != mCombs.size()){
-		mCombs.resize(delays.size());
-	}
-	for(unsigned i=0; i<mCombs.size(); ++i){
-		unsigned d = delays.begin()[i];
-		mCombs[i].maxDelay(d);
-		mCombs[i].delay(d);
-	}
+	mCombDelays.assign(delays.begin(), delays.end());
+	mCombFilters.resize(delays.size());
+	mCombPtrs.resize(2*delays.size());
+	mCombLines.resize(delays);
 	decay(decay());
 	return *this;
 }
@@ -540,13 +671,15 @@ template<TDEC>
 ReverbMS<TARG>& ReverbMS<TARG>::decay(float v){
 	mDecay = v;
 	float decaySamples = v * Td::spu();
-	for(unsigned i=0; i<mCombs.size(); ++i) mCombs[i].decay(decaySamples);
+	for(unsigned i=0; i<combs(); ++i){
+		mCombFilters[i].gain(decayToFbk(decaySamples, float(mCombDelays[i])));
+	}
 	return *this;
 }
 
 template<TDEC>
 ReverbMS<TARG>& ReverbMS<TARG>::damping(float v){
-	for(unsigned i=0; i<mCombs.size(); ++i) mCombs[i].damping(v);
+	for(auto& f : mCombFilters) f.damping(v);
 	return *this;
 }
 
@@ -558,31 +691,92 @@ inline Tv ReverbMS<TARG>::operator()(Tv in){
 		in = mAllpasses[i](in);
 	}
 
-	// Parallel combs
+	// Parallel combs, as lanes
+	const unsigned Nc = combs();
+	LoopFilter<Tv> * filters = mCombFilters.data();
+	const unsigned * off = mCombLines.offsets();
+	const uint32_t * mask = mCombLines.masks();
+	const uint32_t pos = mCombLines.pos();
+	Tv * buf = mCombLines.data(0);
 	Tv res = Tv(0);
-	for(unsigned i=0; i<mCombs.size(); ++i){
-		res += mCombs[i](in);
+	for(unsigned i=0; i<Nc; ++i){
+		Tv * line = buf + off[i];
+		Tv y = line[(pos - mCombDelays[i]) & mask[i]];
+		res += y;
+		line[pos & mask[i]] = in + filters[i](y);
 	}
+	mCombLines.advance();
 
 	return res;
 }
 
+template<TDEC>
+void ReverbMS<TARG>::process(const Tv * in, Tv * out, unsigned n){
+	const unsigned Nc = combs();
+	if(0 == Nc){
+		for(unsigned i=0; i<n; ++i) out[i] = (*this)(in[i]);
+		return;
+	}
+
+	// Series allpasses, over whole block
+	if(in != out) for(unsigned i=0; i<n; ++i) out[i] = in[i];
+	for(auto& ap : mAllpasses) ap.process(out, n);
+
+	// A comb reads no sample written within a span no longer than its delay
+	unsigned shortest = mCombDelays[0];
+	for(unsigned c=1; c<Nc; ++c) shortest = scl::min(shortest, mCombDelays[c]);
+
+	LoopFilter<Tv> * filters = mCombFilters.data();
+	Tv ** rd = mCombPtrs.data();
+	Tv ** wr = rd + Nc;
+
+	while(n){
+		// Find span that does not wrap around in any line
+		const uint32_t pos = mCombLines.pos();
+		unsigned m = n < shortest ? n : shortest;
+		for(unsigned c=0; c<Nc; ++c){
+			const uint32_t mask = mCombLines.masks()[c];
+			unsigned r = (pos - mCombDelays[c]) & mask;
+			unsigned w = pos & mask;
+			m = scl::min(m, mask + 1 - r);
+			m = scl::min(m, mask + 1 - w);
+			rd[c] = mCombLines.data(c) + r;
+			wr[c] = mCombLines.data(c) + w;
+		}
+
+		// Each sample is a loop across comb lanes
+		for(unsigned i=0; i<m; ++i){
+			const Tv x = out[i];
+			Tv res = Tv(0);
+			for(unsigned c=0; c<Nc; ++c){
+				Tv y = rd[c][i];
+				res += y;
+				wr[c][i] = x + filters[c](y);
+			}
+			out[i] = res;
+		}
+
+		mCombLines.advance(m);
+		out += m; n -= m;
+	}
+}
+
 template<TDEC>
 inline Tv ReverbMS<TARG>::read(std::initializer_list<unsigned> delays) const {
 	Tv res = Tv(0);
-	for(unsigned i=0; i<mCombs.size(); ++i){
-		res += mCombs[i].read(delays.begin()[i]);
+	for(unsigned i=0; i<combs(); ++i){
+		res += mCombLines.read(i, delays.begin()[i]);
 	}
 	return res;
 }
 
 template<TDEC>
 void ReverbMS<TARG>::print() const {
-	unsigned Nc = mCombs.size();
+	unsigned Nc = combs();
 	unsigned Na = mAllpasses.size();
 	printf("comb delays = {");
 	for(unsigned i=0; i<Nc; ++i)
-		printf("%u%s", mCombs[i].delaySamples(), i!=(Nc-1)?", ":"");
+		printf("%u%s", mCombDelays[i], i!=(Nc-1)?", ":"");
 	printf("} samples\n");
 	printf("allpass delays = {");
 	for(unsigned i=0; i<Na; ++i)
@@ -593,6 +787,141 @@ void ReverbMS<TARG>::print() const {
 #undef TDEC
 #undef TARG
 
+template <unsigned N, typename Tv, class Td>
+FDNReverb<N,Tv,Td>::FDNReverb(float decay, float damping)
+:	mB1(0), mDecay(decay), mDepth(0), mModFreq(0), mModInc(0), mMatrix(HADAMARD)
+{
+	static const unsigned lengths[16] = {
+		1031, 1327, 1523, 1801, 2017, 2309, 2609, 2801,
+		3037, 3271, 3491, 3761, 4007, 4271, 4507, 4813
+	};
+	unsigned d[N];
+	for(unsigned l=0; l<N; ++l) d[l] = lengths[l*(16/N)];
+	for(unsigned l=0; l<N; ++l) mPhase[l] = 2.f*l/N - 1.f;
+	resize(d);
+	mB1 = damping;
+	this->decay(decay);
+}
+
+template <unsigned N, typename Tv, class Td>
+FDNReverb<N,Tv,Td>& FDNReverb<N,Tv,Td>::resize(std::initializer_list<unsigned> delays){
+	unsigned d[N];
+	for(unsigned l=0; l<N; ++l) d[l] = delays.begin()[l % delays.size()];
+	return resize(d);
+}
+
+template <unsigned N, typename Tv, class Td>
+FDNReverb<N,Tv,Td>& FDNReverb<N,Tv,Td>::resize(const unsigned * delays){
+	unsigned maxDelays[N];
+	for(unsigned l=0; l<N; ++l){
+		mDelay[l] = delays[l];
+		// Room for modulation and the sample after the read position
+		maxDelays[l] = delays[l] + unsigned(mDepth) + 2;
+	}
+	mPool.resize(maxDelays, N);
+	zero();
+	return decay(mDecay);
+}
+
+template <unsigned N, typename Tv, class Td>
+FDNReverb<N,Tv,Td>& FDNReverb<N,Tv,Td>::decay(float v){
+	mDecay = v;
+	float decaySamples = v * Td::spu();
+	for(unsigned l=0; l<N; ++l){
+		mA0[l] = (1.f - scl::abs(mB1)) * decayToFbk(decaySamples, float(mDelay[l]));
+	}
+	return *this;
+}
+
+template <unsigned N, typename Tv, class Td>
+FDNReverb<N,Tv,Td>& FDNReverb<N,Tv,Td>::damping(float v){
+	mB1 = v;
+	return decay(mDecay);
+}
+
+template <unsigned N, typename Tv, class Td>
+FDNReverb<N,Tv,Td>& FDNReverb<N,Tv,Td>::modulate(float depth, float freq){
+	unsigned shortest = mDelay[0];
+	for(unsigned l=1; l<N; ++l) shortest = scl::min(shortest, mDelay[l]);
+	depth = scl::clip(depth, float(shortest) - 1.f);
+	bool grow = unsigned(depth) > unsigned(mDepth);
+	mDepth = depth;
+	mModFreq = freq;
+	mModInc = 2.f * freq * Td::ups();
+	if(grow) resize(mDelay);
+	return *this;
+}
+
+template <unsigned N, typename Tv, class Td>
+void FDNReverb<N,Tv,Td>::zero(){
+	mPool.zero();
+	for(unsigned l=0; l<N; ++l) mO1[l] = Tv(0);
+}
+
+template <unsigned N, typename Tv, class Td>
+void FDNReverb<N,Tv,Td>::onDomainChange(double r){
+	decay(mDecay);
+	mModInc = 2.f * mModFreq * Td::ups();
+}
+
+template <unsigned N, typename Tv, class Td>
+Tv FDNReverb<N,Tv,Td>::operator()(Tv in){
+	Tv y[N];
+
+	// Read lines
+	if(mDepth > 0.f){
+		for(unsigned l=0; l<N; ++l){
+			float p = mPhase[l] + mModInc;
+			mPhase[l] = p >= 1.f ? p - 2.f : p;
+		}
+		for(unsigned l=0; l<N; ++l){
+			y[l] = mPool.read(l, float(mDelay[l]) + mDepth * scl::sinP7(mPhase[l]));
+		}
+	}
+	else{
+		mPool.read(y, mDelay);
+	}
+
+	// Damp and attenuate
+	Tv out = Tv(0);
+	for(unsigned l=0; l<N; ++l){
+		y[l] = mO1[l] = y[l]*mA0[l] + mO1[l]*mB1;
+		out += y[l];
+	}
+
+	// Mix through orthogonal feedback matrix
+	if(HADAMARD == mMatrix){
+		// Fast Walsh-Hadamard transform with the same butterflies in every
+		// pass, so each pass is one loop across lines
+		Tv t[N];
+		Tv * a = y, * b = t;
+		for(unsigned h=1; h<N; h<<=1){
+			for(unsigned k=0; k<N/2; ++k){
+				b[k]       = a[2*k] + a[2*k+1];
+				b[k + N/2] = a[2*k] - a[2*k+1];
+			}
+			Tv * c = a; a = b; b = c;
+		}
+		const Tv norm = Tv(N==4 ? 0.5 : N==16 ? 0.25 : 0.35355339059327373);
+		for(unsigned l=0; l<N; ++l) y[l] = a[l] * norm;
+	}
+	else{
+		Tv sum = Tv(0);
+		for(unsigned l=0; l<N; ++l) sum += y[l];
+		sum *= 2.f/N;
+		for(unsigned l=0; l<N; ++l) y[l] -= sum;
+	}
+
+	// Feed input with alternating signs to decorrelate the lines
+	for(unsigned l=0; l<N; ++l) y[l] += (l & 1) ? -in : in;
+	mPool.write(y);
+	mPool.advance();
+
+	return out * Tv(1.f/N);
+}
+
+
+
 #define TDEC int Ndest, class T
 #define TARG Ndest, T
 
@@ -639,6 +968,33 @@ inline Vec<Ndest, T> Dist<TARG>::operator()(T in){
 	return res;
 }
 
+template<TDEC>
+void Dist<TARG>::process(const T * in, T * const * out, unsigned n){
+	// A block can be written ahead of reading it as long as it does not
+	// overwrite what the longest delay reads. Delays under one sample read
+	// the element after the newest, so those go one sample at a time.
+	float lo = mDly[0], hi = mDly[0];
+	for(int j=1; j<Ndest; ++j){
+		lo = scl::min(lo, mDly[j]);
+		hi = scl::max(hi, mDly[j]);
+	}
+	const float spu = mDelay.spu();
+	const unsigned size = mDelay.size();
+	unsigned ahead = 1;
+	if(lo*spu >= 1.f && hi*spu + 2.f < float(size)) ahead = size - unsigned(hi*spu) - 2;
+
+	for(unsigned i=0; i<n;){
+		unsigned m = scl::min(ahead, n-i);
+		for(unsigned k=0; k<m; ++k) mDelay.write(in[i+k]);
+		for(int j=0; j<Ndest; ++j) mDelay.readBlock(out[j] + i, m, mDly[j]);
+		// Destinations are interleaved so their filters overlap
+		for(unsigned k=i; k<i+m; ++k){
+			for(int j=0; j<Ndest; ++j) out[j][k] = mLPF[j](out[j][k]) * mAmp[j];
+		}
+		i += m;
+	}
+}
+
 template<TDEC>
 void Dist<TARG>::setRollOff(){
 	mRollOff = (mNear/0.25 - mNear) / (mFar - mNear);
@@ -0,0 +1,195 @@
+#ifndef GAMMA_SPECTROGRAM_H_INC
+#define GAMMA_SPECTROGRAM_H_INC
+
+/*	Gamma - Generic processing library
+	See COPYRIGHT file for authors and license information
+
+	File Description:
+	Offline STFT analysis into a memory-mapped spectrogram file.
+*/
+
+#include "Gamma/DFT.h"
+
+namespace gam{
+
+/// Memory-mapped spectrogram file
+
+/// A spectrogram file holds the successive spectral frames of an STFT
+/// analysis of one signal along with the settings used to produce them. It is
+/// written by SpectrogramAnalyzer and opened here by mapping it into memory,
+/// so that frames can be accessed randomly by index without reading the whole
+/// file.
+///
+/// The file consists of a fixed-size header followed by the frames. Each frame
+/// holds numBins() pairs of values in the STFT's spectral format (real and
+/// imaginary parts, magnitude and phase or magnitude and frequency in Hz)
+/// stored as 32-bit or 16-bit floats in native byte order. The header records
+/// a format version and a byte order mark; files with a newer version or
+/// different byte order are rejected by open().
+///
+/// \ingroup Spectral
+class SpectrogramFile{
+public:
+
+	/// Storage format of frame values
+	enum SampleFormat{
+		FLOAT32,	/**< 32-bit IEEE float */
+		FLOAT16		/**< 16-bit IEEE half float */
+	};
+
+	/// Current format version written by SpectrogramAnalyzer
+	static const uint32_t version = 1;
+
+	SpectrogramFile();
+
+	/// \param[in] path		path of file to open
+	SpectrogramFile(const char * path);
+
+	~SpectrogramFile();
+
+
+	/// Open and map a spectrogram file
+
+	/// \returns whether the file was opened and has a valid header
+	///
+	bool open(const char * path);
+
+	/// Unmap and close file
+	void close();
+
+	/// Get whether a file is open
+	bool opened() const;
+
+
+	/// Decode frame into an array of numBins() complex values
+
+	/// The components of each bin are in the spectral format of the file.
+	///
+	/// \returns whether the file is open and the frame exists
+	bool frame(Complex<float> * dst, uint64_t index) const;
+
+	/// Decode frame into the bins of an STFT
+
+	/// The STFT should have the same number of bins and spectral format as
+	/// the file. For the MAG_FREQ format, it should also have the same sample
+	/// rate as the analysis. This makes it possible to resynthesize a cached
+	/// analysis by calling STFT::inverse() after each frame.
+	///
+	/// \returns whether the number of bins matches and the frame exists
+	bool frame(STFT& dst, uint64_t index) const;
+
+	/// Get pointer to raw frame data
+
+	/// The data consist of 2*numBins() values in the file's sample format.
+	///
+	/// \returns frame data or NULL if no file is open or the index is not
+	///		less than numFrames()
+	const void * frameData(uint64_t index) const;
+
+
+	uint64_t numFrames() const;		///< Get number of frames
+	uint64_t numSamples() const;	///< Get number of samples analyzed
+	unsigned numBins() const;		///< Get number of bins per frame
+	unsigned sizeWin() const;		///< Get window size, in samples
+	unsigned sizeHop() const;		///< Get hop size, in samples
+	unsigned sizePad() const;		///< Get zero-padding size, in samples
+	unsigned sizeDFT() const;		///< Get DFT size, in samples
+	unsigned sizeFrame() const;		///< Get size of a frame, in bytes
+	double sampleRate() const;		///< Get sample rate of analyzed signal
+	bool rotateForward() const;		///< Get whether window was zero-phase rotated
+	WindowType windowType() const;	///< Get analysis window type
+	SpectralType spectralType() const;	///< Get spectral format of frames
+	SampleFormat sampleFormat() const;	///< Get storage format of frame values
+
+private:
+	class Impl; Impl * mImpl;
+
+	SpectrogramFile(const SpectrogramFile&);
+	SpectrogramFile& operator= (const SpectrogramFile&);
+};
+
+
+
+/// Offline multithreaded STFT analysis into a spectrogram file
+
+/// The analyzer runs an STFT over a complete signal and writes the frames to
+/// a SpectrogramFile. The frames are split into contiguous time ranges that
+/// are analyzed in parallel, each by its own STFT. A range's first window
+/// reaches back into the previous range's samples and, for the MAG_FREQ
+/// format, the preceding frame is analyzed first so that its phase
+/// differences are correct. The result is identical to that of a single STFT
+/// fed the whole signal followed by zeros.
+///
+/// Frame i covers the input samples [(i+1)*hop - win, (i+1)*hop), treating
+/// samples outside the signal as zero. This is the same framing as feeding
+/// the samples one at a time into STFT::operator()(float). Frames continue
+/// until the window has completely passed the end of the signal.
+///
+/// \ingroup Spectral
+class SpectrogramAnalyzer{
+public:
+
+	/// \param[in]	winSize		Number of samples to window
+	/// \param[in]	hopSize		Number of samples between successive windows
+	/// \param[in]	padSize		Number of zeros to append to window
+	/// \param[in]	winType		Type of forward transform window
+	/// \param[in]	specType	Format of spectrum data
+	SpectrogramAnalyzer(
+		unsigned winSize=1024, unsigned hopSize=256, unsigned padSize=0,
+		WindowType winType = HANN,
+		SpectralType specType = MAG_PHASE
+	);
+
+
+	/// Analyze a signal and write its spectrogram to a file
+
+	/// An existing file at the path is replaced, so any SpectrogramFile that
+	/// has it open must be closed first.
+	///
+	/// \param[in]	path		path of file to write
+	/// \param[in]	src			input samples
+	/// \param[in]	numSamples	number of input samples
+	/// \param[in]	sampleRate	sample rate of input
+	/// \param[in]	stride		stride between samples, e.g. to analyze one
+	///							channel of interleaved data
+	/// \returns whether the file was written successfully
+	bool analyze(
+		const char * path, const float * src, uint64_t numSamples,
+		double sampleRate, unsigned stride=1
+	) const;
+
+	/// Get number of frames produced from a signal
+	uint64_t numFrames(uint64_t numSamples) const;
+
+
+	/// Set storage format of frame values
+	SpectrogramAnalyzer& sampleFormat(SpectrogramFile::SampleFormat v){ mSampleFormat=v; return *this; }
+
+	/// Set whether to use precise (but slower) polar conversion
+	SpectrogramAnalyzer& precise(bool v){ mPrecise=v; return *this; }
+
+	/// Set whether to rotate input samples by half
+	SpectrogramAnalyzer& rotateForward(bool v){ mRotateForward=v; return *this; }
+
+	/// Set number of analysis threads; 0 uses one per hardware thread
+	SpectrogramAnalyzer& threads(unsigned v){ mThreads=v; return *this; }
+
+
+	unsigned sizeWin() const { return mWinSize; }
+	unsigned sizeHop() const { return mHopSize; }
+	unsigned sizePad() const { return mPadSize; }
+	unsigned threads() const { return mThreads; }
+	SpectrogramFile::SampleFormat sampleFormat() const { return mSampleFormat; }
+
+private:
+	unsigned mWinSize, mHopSize, mPadSize;
+	WindowType mWinType;
+	SpectralType mSpecType;
+	SpectrogramFile::SampleFormat mSampleFormat;
+	unsigned mThreads;
+	bool mPrecise, mRotateForward;
+};
+
+} // gam::
+
+#endif
@@ -0,0 +1,571 @@
+/*	Gamma - Generic processing library
+	See COPYRIGHT file for authors and license information */
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include "Gamma/CQT.h"
+#include "Gamma/FFT.h"
+#include "Gamma/scl.h"
+
+namespace gam{
+
+namespace{
+
+// Halfband filters have 4M-1 taps and a delay of 2M-1 samples
+const int M = 16;
+
+// Spectral kernel coefficients below this fraction of a bin's peak are dropped
+const float SPARSITY = 0.0054f;
+
+// Even-indexed taps g[m] = h[2m] of a Blackman-windowed halfband lowpass h.
+// The center tap, h[2M-1], is 1/2 and all other odd-indexed taps are zero.
+struct Halfband{
+	Halfband(){
+		const int L = 4*M-1;
+		double sum = 0;
+		for(int m=0; m<2*M; ++m){
+			int i = 2*m;
+			double x = 0.5*(i - (2*M-1));
+			double w = 0.42 - 0.5*cos(M_2PI*i/(L-1)) + 0.08*cos(2*M_2PI*i/(L-1));
+			g[m] = 0.5*sin(M_PI*x)/(M_PI*x) * w;
+			sum += g[m];
+		}
+		// even taps sum to 1/2 for unity gain at DC
+		for(auto& v : g) v *= 0.5/sum;
+	}
+
+	static const Halfband& get(){ static Halfband h; return h; }
+
+	float g[2*M];
+};
+
+
+// History of the last 2M samples, stored twice so that they can be read
+// contiguously from newest to oldest
+struct History{
+	History(){ reset(); }
+
+	void reset(){
+		for(auto& v : buf) v = 0.f;
+		pos = 0;
+	}
+
+	void write(float v){
+		pos = (0 == pos ? 2*M : pos) - 1;
+		buf[pos] = buf[pos + 2*M] = v;
+	}
+
+	// Get i-th newest sample
+	float operator[](int i) const { return buf[pos + i]; }
+
+	// Dot product of halfband even taps with history
+	float dotEven() const {
+		const float * g = Halfband::get().g;
+		const float * b = buf + pos;
+		float s = 0.f;
+		for(int m=0; m<2*M; ++m) s += g[m] * b[m];
+		return s;
+	}
+
+	float buf[4*M];
+	int pos;
+};
+
+
+// Halfband decimate by two. Output p is centered on input 2p-2M+2.
+struct Decimator{
+	Decimator(){ reset(); }
+
+	void reset(){
+		odd.reset(); even.reset();
+		phase = false;
+	}
+
+	// Returns whether an output was produced
+	bool operator()(float& out, float in){
+		if(!phase){
+			even.write(in);
+			phase = true;
+			return false;
+		}
+		odd.write(in);
+		phase = false;
+		out = 0.5f * even[M-1] + odd.dotEven();
+		return true;
+	}
+
+	History odd, even;	// odd- and even-indexed inputs
+	bool phase;
+};
+
+
+// Halfband interpolate by two. Input q is centered on output 2q+2M-1.
+struct Interpolator{
+	void reset(){ hist.reset(); }
+
+	void operator()(float& out0, float& out1, float in){
+		hist.write(in);
+		out0 = 2.f * hist.dotEven();
+		out1 = hist[M-1];
+	}
+
+	History hist;
+};
+
+// Offset from interpolator output index to time of the coarser octave
+const int INTERP_DELAY = 4*M-3;
+
+// Offset, in samples of the finer octave, of a decimated sample's center
+const int DECIM_OFFSET = 2*M-2;
+
+
+// Sparse spectral kernel of one octave. The coefficients of bin b span FFT
+// bins [beg[b], beg[b]+len[b]) and are stored from index off[b].
+struct CQKernel{
+
+	// \param[in] N		FFT size
+	// \param[in] B		bins per octave
+	// \param[in] f0	lowest center frequency, normalized by sample rate
+	// \param[in] q		bandwidth scale
+	// \param[in] g		bandwidth offset, normalized by sample rate
+	CQKernel(unsigned N, unsigned B, double f0, double q, double g)
+	:	beg(B), len(B), off(B), power(N/2+1, 0.)
+	{
+		const unsigned nb = N/2+1;
+		const double alpha = pow(2., 1./B) - 1.;
+		CFFT<float> fft(N);
+		std::vector<Complex<float>> atom(N);
+
+		for(unsigned b=0; b<B; ++b){
+			double f = f0 * pow(2., double(b)/B);
+			unsigned L = scl::clip<unsigned>(q / (alpha*f + g) + 0.5, N, 2);
+			unsigned start = N/2 - L/2;
+
+			for(auto& a : atom) a = 0.f;
+			double sumw = 0;
+			for(unsigned n=0; n<L; ++n) sumw += 0.5 - 0.5*cos(M_2PI*(n+0.5)/L);
+			for(unsigned n=0; n<L; ++n){
+				double w = (0.5 - 0.5*cos(M_2PI*(n+0.5)/L)) / sumw;
+				// phase is referenced to the frame center
+				double p = M_2PI * f * (double(start + n) - N/2);
+				atom[start+n](w*cos(p), w*sin(p));
+			}
+
+			fft.forward(&atom[0], false);
+
+			// S = conj(A)/N so that X_b = sum_j X[j] S[j] = <x, atom>
+			float peak = 0.f;
+			for(unsigned j=0; j<nb; ++j) peak = scl::max(peak, atom[j].mag());
+			float thresh = peak * SPARSITY;
+			unsigned j0 = 0, j1 = nb;
+			while(j0 < nb-1 && atom[j0].mag() < thresh) ++j0;
+			while(j1 > j0+1 && atom[j1-1].mag() < thresh) --j1;
+
+			beg[b] = j0;
+			len[b] = j1 - j0;
+			off[b] = re.size();
+			for(unsigned j=j0; j<j1; ++j){
+				re.push_back( atom[j].r / N);
+				im.push_back(-atom[j].i / N);
+				power[j] += atom[j].magSqr();
+			}
+		}
+
+	}
+
+	// Get power response at fractional FFT bin
+	double powerAt(double j) const {
+		unsigned j0 = unsigned(j);
+		if(j0+1 >= power.size()) return 0;
+		double f = j - j0;
+		return (1.-f)*power[j0] + f*power[j0+1];
+	}
+
+	std::vector<unsigned> beg, len, off;
+	std::vector<float> re, im;
+	std::vector<double> power;	// sum of squared atom spectra
+};
+
+// Process-wide registry of kernels. Entries are weak so a kernel is freed
+// when the last CQT using it goes away.
+std::shared_ptr<const CQKernel> cqKernel(
+	unsigned N, unsigned B, double f0, double q, double g
+){
+	typedef std::tuple<unsigned,unsigned,double,double,double> Key;
+	static std::mutex mutex;
+	static std::map<Key, std::weak_ptr<const CQKernel>> kernels;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto& entry = kernels[Key(N,B,f0,q,g)];
+	auto kernel = entry.lock();
+	if(!kernel){
+		for(auto it = kernels.begin(); it != kernels.end();){
+			if(it->second.expired() && &it->second != &entry) it = kernels.erase(it);
+			else ++it;
+		}
+		kernel = std::make_shared<const CQKernel>(N, B, f0, q, g);
+		entry = kernel;
+	}
+	return kernel;
+}
+
+int64_t floorDiv(int64_t n, int64_t d){
+	return n >= 0 ? n/d : -((-n + d - 1)/d);
+}
+
+} // anonymous::
+
+
+
+class CQT::Impl{
+public:
+
+	// Samples of octave o are at rate fs/2^o. Sample m of octave o is
+	// centered on input time 2^o m - DECIM_OFFSET (2^o - 1).
+	struct Octave{
+		std::shared_ptr<const CQKernel> kernel;
+		std::vector<float> gain;	// inverse gain of each FFT bin
+		Decimator dec;				// from next higher octave
+		Interpolator interp;		// from next lower octave
+		std::vector<float> anRing;	// analysis input, by sample index
+		std::vector<float> synRing;	// synthesis output, by sample index
+		int64_t anMask, synMask;
+		int64_t count;				// samples input
+		int64_t delay;				// analysis delay aligning frame centers
+		int64_t interpCount;		// samples taken from next lower octave
+		int64_t final;				// samples with complete synthesis output
+	};
+
+	Impl(): fs(44100), fmin(55), O(1), B(12), H(1), hopReq(0), q(1), gam(0), N(2){}
+
+	void setup(double minFreq, unsigned numOct, unsigned bpo, unsigned hop, double qScale, double gamma){
+		fmin = minFreq;
+		O = scl::max(numOct, 1u);
+		B = scl::max(bpo, 1u);
+		hopReq = hop;
+		q = qScale;
+		gam = gamma;
+
+		const double alpha = pow(2., 1./B) - 1.;
+		const double fTop = fmin * pow(2., O-1);	// lowest bin of top octave
+
+		// longest atom is the lowest bin of the top octave
+		N = scl::ceilPow2(unsigned(q*fs / (alpha*fTop + gam) + 0.5));
+		if(N < 4) N = 4;
+
+		// Default to a quarter of the shortest atom, in samples of its octave.
+		// This is at the highest bin of the top octave, unless variable-Q
+		// makes the lowest octave's atoms shorter.
+		if(0 == hop){
+			double fHi = fTop * pow(2., double(B-1)/B);
+			double len = q*fs / (alpha*fHi + gam);
+			len = scl::min(len, q*fs / (alpha*fHi + gam*(1<<(O-1))));
+			hop = scl::max(unsigned(0.25 * len), 1u);
+		}
+		H = scl::clip(hop, N, 1u);
+
+		fft.resize(N);
+		buf.assign(N+2, 0.f);
+		Xre.assign(N/2+1, 0.f); Xim.assign(N/2+1, 0.f);
+		Yre.assign(N/2+1, 0.f); Yim.assign(N/2+1, 0.f);
+		bins.assign(O*B, Complex<float>(0.f));
+		out.assign(H, 0.f);
+
+		// Align frame centers of all octaves with that of the lowest
+		const int64_t K = DECIM_OFFSET;
+		const int64_t P = int64_t(1) << (O-1);
+		lat = P*(N/2) + K*(P-1);
+
+		octs.clear();
+		octs.resize(O);
+		for(unsigned o=0; o<O; ++o){
+			Octave& oc = octs[o];
+			oc.kernel = cqKernel(N, B, fTop/fs, q, gam*(1<<o)/fs);
+			oc.delay = (P>>o)*(N/2 + K) - K - N/2;
+		}
+
+		// Overlap-adding the conjugate kernels at a hop of H gives a sinusoid
+		// a gain of 1/H times the sum of the atoms' power responses at its
+		// frequency. Every octave divides its output by the sum over all
+		// octaves, so that the octaves add up to unity gain. Outside the
+		// analyzed range the output is attenuated instead of amplified.
+		for(unsigned o=0; o<O; ++o){
+			Octave& oc = octs[o];
+			const unsigned nb = N/2+1;
+			std::vector<double> T(nb, 0.);
+			for(unsigned j=0; j<nb; ++j){
+				for(unsigned p=0; p<O; ++p){
+					// same frequency in octave p is at bin j*2^(p-o)
+					T[j] += octs[p].kernel->powerAt(ldexp(double(j), int(p)-int(o)));
+				}
+			}
+
+			unsigned ja = scl::min(unsigned(fTop/fs*N + 0.5), nb-1);
+			unsigned jb = scl::clip(unsigned(2*fTop/fs*N + 0.5), nb, ja+1);
+			double meanT = 0;
+			for(unsigned j=ja; j<jb; ++j) meanT += T[j];
+			meanT /= jb - ja;
+
+			oc.gain.resize(nb);
+			for(unsigned j=0; j<nb; ++j) oc.gain[j] = H / scl::max(T[j], 0.5*meanT);
+		}
+
+		latOut = outputDelay();
+
+		for(unsigned o=0; o<O; ++o){
+			Octave& oc = octs[o];
+			int64_t an = scl::ceilPow2(unsigned(N + oc.delay + 1));
+			int64_t syn = scl::ceilPow2(unsigned(
+				((latOut + H) >> o) + N + H + oc.delay + 4*M + 4));
+			oc.anRing.assign(an, 0.f);
+			oc.synRing.assign(syn, 0.f);
+			oc.anMask = an-1;
+			oc.synMask = syn-1;
+		}
+
+		reset();
+	}
+
+	// Smallest delay of inverse output behind the input such that every
+	// octave's synthesis is complete when it is needed
+	int64_t outputDelay() const {
+		const int64_t P = int64_t(1) << (O-1);
+		int64_t lo = 0, hi = 4*P*(N + H + 4*M);
+		int64_t base = (hi/(P*H) + 2) * P*H;
+
+		auto feasible = [&](int64_t d){
+			for(int64_t ph=0; ph<P; ++ph){
+				int64_t n0 = base + ph*H;
+				int64_t need = n0 - d;
+				for(unsigned o=0; o<O; ++o){
+					int64_t period = int64_t(H) << o;
+					int64_t last = (n0/period)*period >> o;
+					if(need > last + H - octs[o].delay - N) return false;
+					need = floorDiv(need + INTERP_DELAY + 1, 2);
+				}
+			}
+			return true;
+		};
+
+		while(lo < hi){
+			int64_t mid = (lo+hi)/2;
+			if(feasible(mid)) hi = mid;
+			else lo = mid+1;
+		}
+		return lo;
+	}
+
+	void reset(){
+		for(auto& oc : octs){
+			oc.dec.reset();
+			oc.interp.reset();
+			for(auto& v : oc.anRing) v = 0.f;
+			for(auto& v : oc.synRing) v = 0.f;
+			oc.count = 0;
+			oc.interpCount = 0;
+			oc.final = 0;
+		}
+		for(auto& v : bins) v = 0.f;
+		for(auto& v : out) v = 0.f;
+		outPos = H;
+		frame = 0;
+		updated = 0;
+	}
+
+	bool input(float x){
+		float v = x;
+		for(unsigned o=0; o<O; ++o){
+			Octave& oc = octs[o];
+			if(o && !oc.dec(v, v)) break;
+			oc.anRing[oc.count & oc.anMask] = v;
+			++oc.count;
+		}
+
+		if(octs[0].count % H) return false;
+
+		++frame;
+		updated = 1;
+		while(updated < O && 0 == (frame & ((int64_t(1)<<updated)-1))) ++updated;
+
+		for(unsigned o=0; o<updated; ++o) analyze(o);
+		return true;
+	}
+
+	void analyze(unsigned o){
+		Octave& oc = octs[o];
+		const CQKernel& k = *oc.kernel;
+		const unsigned nb = N/2+1;
+
+		int64_t s = oc.count - oc.delay - N;
+		for(unsigned i=0; i<N; ++i) buf[i+1] = oc.anRing[(s+i) & oc.anMask];
+		fft.forward(&buf[0], true, false);
+
+		for(unsigned j=0; j<nb; ++j){
+			Xre[j] = buf[2*j  ];
+			Xim[j] = buf[2*j+1];
+		}
+
+		Complex<float> * dst = &bins[(O-1-o)*B];
+		for(unsigned b=0; b<B; ++b){
+			const float * xr = &Xre[k.beg[b]];
+			const float * xi = &Xim[k.beg[b]];
+			const float * sr = &k.re[k.off[b]];
+			const float * si = &k.im[k.off[b]];
+			float r = 0.f, i = 0.f;
+			for(unsigned j=0; j<k.len[b]; ++j){
+				r += xr[j]*sr[j] - xi[j]*si[j];
+				i += xr[j]*si[j] + xi[j]*sr[j];
+			}
+			dst[b](r, i);
+		}
+	}
+
+	void synthesize(unsigned o){
+		Octave& oc = octs[o];
+		const CQKernel& k = *oc.kernel;
+		const unsigned nb = N/2+1;
+
+		for(unsigned j=0; j<nb; ++j) Yre[j] = Yim[j] = 0.f;
+
+		const Complex<float> * src = &bins[(O-1-o)*B];
+		for(unsigned b=0; b<B; ++b){
+			float * yr = &Yre[k.beg[b]];
+			float * yi = &Yim[k.beg[b]];
+			const float * sr = &k.re[k.off[b]];
+			const float * si = &k.im[k.off[b]];
+			const float xr = src[b].r;
+			const float xi = src[b].i;
+			// multiply by conjugate kernel
+			for(unsigned j=0; j<k.len[b]; ++j){
+				yr[j] += xr*sr[j] + xi*si[j];
+				yi[j] += xi*sr[j] - xr*si[j];
+			}
+		}
+
+		const float * g = &oc.gain[0];
+		for(unsigned j=0; j<nb; ++j){
+			buf[2*j  ] = Yre[j] * g[j];
+			buf[2*j+1] = Yim[j] * g[j];
+		}
+		fft.inverse(&buf[0], true);
+
+		// zero the hop not touched by earlier frames, then overlap-add
+		int64_t end = oc.count - oc.delay;
+		for(int64_t i=end-H; i<end; ++i) oc.synRing[i & oc.synMask] = 0.f;
+		int64_t s = end - N;
+		for(unsigned i=0; i<N; ++i) oc.synRing[(s+i) & oc.synMask] += buf[i+1];
+	}
+
+	// Complete synthesis of octave o for samples before 'need' by adding the
+	// upsampled output of the lower octaves
+	void finalize(unsigned o, int64_t need){
+		Octave& oc = octs[o];
+		if(need <= oc.final) return;
+
+		if(o+1 < O){
+			Octave& lo = octs[o+1];
+			int64_t lowNeed = floorDiv(need + INTERP_DELAY + 1, 2);
+			finalize(o+1, lowNeed);
+			for(; oc.interpCount < lowNeed; ++oc.interpCount){
+				float v0, v1;
+				float z = lo.synRing[oc.interpCount & lo.synMask];
+				oc.interp(v0, v1, z);
+				int64_t t = 2*oc.interpCount - INTERP_DELAY;
+				oc.synRing[ t    & oc.synMask] += v0;
+				oc.synRing[(t+1) & oc.synMask] += v1;
+			}
+		}
+		oc.final = need;
+	}
+
+	void inverse(float * dst){
+		for(unsigned o=0; o<updated; ++o) synthesize(o);
+
+		Octave& top = octs[0];
+		int64_t need = top.count - latOut;
+		finalize(0, need);
+		for(unsigned i=0; i<H; ++i) out[i] = top.synRing[(need-H+i) & top.synMask];
+		outPos = 0;
+		if(dst) for(unsigned i=0; i<H; ++i) dst[i] = out[i];
+	}
+
+	double fs, fmin;
+	unsigned O, B, H;
+	unsigned hopReq;		// requested hop size; 0 for automatic
+	double q, gam;
+	unsigned N;
+	int64_t lat, latOut;
+	RFFT<float> fft;
+	std::vector<float> buf, Xre, Xim, Yre, Yim;
+	std::vector<Octave> octs;
+	std::vector<Complex<float>> bins;
+	std::vector<float> out;
+	unsigned outPos;
+	int64_t frame;
+	unsigned updated;
+};
+
+
+
+CQT::CQT(double minFreq, unsigned numOctaves, unsigned binsPerOctave,
+	unsigned hopSize, double qScale, double gamma)
+:	mImpl(new Impl)
+{
+	mImpl->fs = spu();
+	resize(minFreq, numOctaves, binsPerOctave, hopSize, qScale, gamma);
+}
+
+CQT::~CQT(){
+	if(mImpl){ delete mImpl; mImpl=0; }
+}
+
+void CQT::resize(double minFreq, unsigned numOctaves, unsigned binsPerOctave,
+	unsigned hopSize, double qScale, double gamma
+){
+	mImpl->setup(minFreq, numOctaves, binsPerOctave, hopSize, qScale, gamma);
+}
+
+void CQT::onDomainChange(double r){
+	mImpl->fs = spu();
+	mImpl->setup(mImpl->fmin, mImpl->O, mImpl->B, mImpl->hopReq, mImpl->q, mImpl->gam);
+}
+
+bool CQT::operator()(float input){ return mImpl->input(input); }
+
+void CQT::inverse(float * dst){ mImpl->inverse(dst); }
+
+float CQT::operator()(){
+	Impl& m = *mImpl;
+	return m.outPos < m.H ? m.out[m.outPos++] : 0.f;
+}
+
+void CQT::reset(){ mImpl->reset(); }
+
+Complex<float> * CQT::bins(){ return &mImpl->bins[0]; }
+const Complex<float> * CQT::bins() const { return &mImpl->bins[0]; }
+
+double CQT::binFreq(unsigned k) const {
+	return mImpl->fmin * pow(2., double(k)/mImpl->B);
+}
+
+double CQT::binWidth(unsigned k) const {
+	return (pow(2., 1./mImpl->B) - 1.) / mImpl->q * binFreq(k) + mImpl->gam / mImpl->q;
+}
+
+unsigned CQT::octavesUpdated() const { return mImpl->updated; }
+unsigned CQT::binsUpdatedFrom() const { return (mImpl->O - mImpl->updated) * mImpl->B; }
+unsigned CQT::numBins() const { return mImpl->O * mImpl->B; }
+unsigned CQT::numOctaves() const { return mImpl->O; }
+unsigned CQT::binsPerOctave() const { return mImpl->B; }
+unsigned CQT::sizeHop() const { return mImpl->H; }
+unsigned CQT::sizeFFT() const { return mImpl->N; }
+double CQT::minFreq() const { return mImpl->fmin; }
+double CQT::qScale() const { return mImpl->q; }
+double CQT::gamma() const { return mImpl->gam; }
+unsigned CQT::latency() const { return mImpl->lat; }
+unsigned CQT::latencyInverse() const { return mImpl->latOut + mImpl->H - 1; }
+
+} // gam::
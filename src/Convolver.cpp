@@ -0,0 +1,372 @@
+/*	Gamma - Generic processing library
+	See COPYRIGHT file for authors and license information */
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "Gamma/Convolver.h"
+#include "Gamma/FFT.h"
+#include "Gamma/scl.h"
+#include "Gamma/Thread.h"
+
+namespace gam{
+
+namespace{
+
+int ceilPow2(int v){
+	int r = 1;
+	while(r < v) r <<= 1;
+	return r;
+}
+
+int ceilDiv(int n, int d){ return (n + d - 1) / d; }
+
+// Complex multiply-accumulate of split (real/imaginary) arrays:
+// y += a * b
+void cmac(
+	float * yr, float * yi,
+	const float * ar, const float * ai,
+	const float * br, const float * bi, int n
+){
+	for(int i=0; i<n; ++i){
+		yr[i] += ar[i]*br[i] - ai[i]*bi[i];
+		yi[i] += ar[i]*bi[i] + ai[i]*br[i];
+	}
+}
+
+} // anonymous::
+
+
+
+class Convolver::Impl{
+public:
+
+	// A uniformly partitioned overlap-save convolver covering the impulse
+	// response segment [offset, offset + numParts * size)
+	struct Level{
+		Level(int P, int off, int K)
+		:	size(P), offset(off), numParts(K), fft(2*P),
+			buf(2*P+2), Hre(K*(P+1)), Him(K*(P+1)), Xre(K*(P+1)), Xim(K*(P+1)),
+			Yre(P+1), Yim(P+1), pos(0),
+			pending(false), running(false), jobTime(0)
+		{}
+
+		int numBins() const { return size+1; }
+
+		int size, offset, numParts;
+		RFFT<float> fft;			// transform of size 2*size
+		std::vector<float> buf;		// transform buffer (complex format)
+		std::vector<float> Hre, Him;// impulse response partition spectra
+		std::vector<float> Xre, Xim;// frequency-domain delay line of input spectra
+		std::vector<float> Yre, Yim;// accumulated output spectrum
+		std::vector<float> out;		// output ring, indexed by absolute sample time
+		int pos;					// delay line position of newest spectrum
+
+		// background job state, guarded by Impl::mutex
+		bool pending, running;
+		long jobTime;
+	};
+
+
+	Impl(): B(0), L(0), inMask(0), outMask(0), time(0),
+		isThreaded(false), quit(false), workerActive(false), missed(0)
+	{}
+
+	~Impl(){ stopWorker(); }
+
+
+	void setup(int blockSize, const float * ir, int irSize, int maxPartition){
+		stopWorker();
+
+		B = blockSize < 1 ? 1 : blockSize;
+		L = irSize < 0 ? 0 : irSize;
+
+		int Pmax = B;
+		while(Pmax*2 <= maxPartition) Pmax *= 2;
+
+		levels.clear();
+
+		if(Pmax == B){
+			addLevel(B, 0, ceilDiv(L,B), ir);
+		}
+		else{
+			addLevel(B, 0, scl::min(4, ceilDiv(L,B)), ir);
+
+			// Each later level starts at twice its partition size, leaving
+			// one partition period between scheduling and first use.
+			int off = 4*B;
+			for(int P = 2*B; off < L; P *= 2){
+				int K = ceilDiv(L-off, P);
+				if(P < Pmax && K > 2) K = 2;
+				addLevel(P, off, K, ir);
+				off += K*P;
+			}
+		}
+
+		// Each level accumulates into its own output ring so that a level
+		// computed by the audio thread never adds to the same samples as
+		// one running on the worker
+		int ringSize = ceilPow2(4*Pmax);
+		inRing.assign(ringSize, 0.f);
+		for(auto& lv : levels) lv->out.assign(ringSize, 0.f);
+		inMask = outMask = ringSize-1;
+		time = 0;
+
+		startWorker();
+	}
+
+	void addLevel(int P, int off, int K, const float * ir){
+		if(K < 1) K = 1;
+		levels.emplace_back(new Level(P, off, K));
+		Level& lv = *levels.back();
+
+		for(int k=0; k<K; ++k){
+			float * b = &lv.buf[1];
+			for(int i=0; i<P; ++i){
+				int j = off + k*P + i;
+				b[i] = j < L ? ir[j] : 0.f;
+			}
+			for(int i=P; i<2*P; ++i) b[i] = 0.f;
+
+			// normalize here so the inverse transform needs no scaling
+			lv.fft.forward(&lv.buf[0], true, true);
+
+			float * hr = &lv.Hre[k*lv.numBins()];
+			float * hi = &lv.Him[k*lv.numBins()];
+			for(int i=0; i<lv.numBins(); ++i){
+				hr[i] = lv.buf[2*i  ];
+				hi[i] = lv.buf[2*i+1];
+			}
+		}
+	}
+
+	// Convolve input [T - 2P, T) and add the valid half to the output at
+	// [T - P + offset, T + offset)
+	void compute(Level& lv, long T){
+		const int P = lv.size;
+		const int N = 2*P;
+		const int nb = lv.numBins();
+
+		float * b = &lv.buf[1];
+		for(int i=0; i<N; ++i) b[i] = inRing[(T-N+i) & inMask];
+
+		lv.fft.forward(&lv.buf[0], true, false);
+
+		float * xr = &lv.Xre[lv.pos*nb];
+		float * xi = &lv.Xim[lv.pos*nb];
+		for(int i=0; i<nb; ++i){
+			xr[i] = lv.buf[2*i  ];
+			xi[i] = lv.buf[2*i+1];
+		}
+
+		float * yr = &lv.Yre[0];
+		float * yi = &lv.Yim[0];
+		for(int i=0; i<nb; ++i) yr[i] = yi[i] = 0.f;
+
+		for(int k=0; k<lv.numParts; ++k){
+			int s = lv.pos - k;
+			if(s < 0) s += lv.numParts;
+			cmac(yr, yi,
+				&lv.Xre[s*nb], &lv.Xim[s*nb],
+				&lv.Hre[k*nb], &lv.Him[k*nb], nb
+			);
+		}
+
+		for(int i=0; i<nb; ++i){
+			lv.buf[2*i  ] = yr[i];
+			lv.buf[2*i+1] = yi[i];
+		}
+
+		lv.fft.inverse(&lv.buf[0], true);
+
+		long t0 = T - P + lv.offset;
+		float * o = &lv.out[0];
+		for(int i=0; i<P; ++i) o[(t0+i) & outMask] += b[P+i];
+
+		if(++lv.pos >= lv.numParts) lv.pos = 0;
+	}
+
+	void process(const float * in, float * out){
+		for(int i=0; i<B; ++i) inRing[(time+i) & inMask] = in[i];
+
+		long T = time + B;
+
+		compute(*levels[0], T);
+
+		for(unsigned l=1; l<levels.size(); ++l){
+			Level& lv = *levels[l];
+			if(T % lv.size) continue;
+
+			if(workerActive)	schedule(lv, T);
+			else				compute(lv, T);
+		}
+
+		for(int i=0; i<B; ++i) out[i] = 0.f;
+		for(auto& lv : levels){
+			float * o = &lv->out[0];
+			for(int i=0; i<B; ++i){
+				float& v = o[(time+i) & outMask];
+				out[i] += v;
+				v = 0.f;
+			}
+		}
+
+		time = T;
+	}
+
+	// Hand a level to the worker, first making sure its previous job is done
+	void schedule(Level& lv, long T){
+		std::unique_lock<std::mutex> lock(mutex);
+
+		if(lv.pending){ // never started; steal it
+			lv.pending = false;
+			++missed;
+			lock.unlock();
+			compute(lv, lv.jobTime);
+			lock.lock();
+		}
+		else if(lv.running){
+			++missed;
+			cond.wait(lock, [&lv]{ return !lv.running; });
+		}
+
+		lv.jobTime = T;
+		lv.pending = true;
+		cond.notify_all();
+	}
+
+	void work(){
+		std::unique_lock<std::mutex> lock(mutex);
+		while(!quit){
+			// shortest partitions have the earliest deadlines
+			Level * job = NULL;
+			for(unsigned l=1; l<levels.size(); ++l){
+				if(levels[l]->pending){ job = levels[l].get(); break; }
+			}
+
+			if(!job){
+				cond.wait(lock);
+				continue;
+			}
+
+			job->pending = false;
+			job->running = true;
+			lock.unlock();
+			compute(*job, job->jobTime);
+			lock.lock();
+			job->running = false;
+			cond.notify_all();
+		}
+	}
+
+	static void * workFunc(void * user){
+		static_cast<Impl*>(user)->work();
+		return NULL;
+	}
+
+	void startWorker(){
+		if(!isThreaded || levels.size() < 2 || workerActive) return;
+		quit = false;
+		workerActive = worker.start(workFunc, this);
+	}
+
+	// Stop worker and complete any jobs it did not start
+	void stopWorker(){
+		if(!workerActive) return;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			quit = true;
+			cond.notify_all();
+		}
+		worker.join();
+		workerActive = false;
+
+		for(auto& lv : levels){
+			if(lv->pending){
+				lv->pending = false;
+				compute(*lv, lv->jobTime);
+			}
+		}
+	}
+
+	void reset(){
+		stopWorker();
+		for(auto& lv : levels){
+			for(auto& v : lv->Xre) v = 0.f;
+			for(auto& v : lv->Xim) v = 0.f;
+			for(auto& v : lv->out) v = 0.f;
+			lv->pos = 0;
+		}
+		for(auto& v : inRing) v = 0.f;
+		time = 0;
+		startWorker();
+	}
+
+
+	int B, L;
+	std::vector<std::unique_ptr<Level>> levels;
+	std::vector<float> inRing;			// indexed by absolute sample time
+	long inMask, outMask;
+	long time;							// samples processed
+
+	bool isThreaded;
+	bool quit;
+	bool workerActive;
+	std::atomic<unsigned> missed;
+	std::mutex mutex;
+	std::condition_variable cond;
+	Thread worker;
+};
+
+
+
+Convolver::Convolver()
+:	mImpl(new Impl)
+{
+	float zero = 0.f;
+	setup(64, &zero, 1);
+}
+
+Convolver::Convolver(int blockSize, const float * ir, int irSize, int maxPartition)
+:	mImpl(new Impl)
+{
+	setup(blockSize, ir, irSize, maxPartition);
+}
+
+Convolver::~Convolver(){
+	if(mImpl){ delete mImpl; mImpl=0; }
+}
+
+void Convolver::setup(int blockSize, const float * ir, int irSize, int maxPartition){
+	mImpl->setup(blockSize, ir, irSize, maxPartition);
+}
+
+void Convolver::threaded(bool v){
+	if(v != mImpl->isThreaded){
+		mImpl->isThreaded = v;
+		if(v)	mImpl->startWorker();
+		else	mImpl->stopWorker();
+	}
+}
+
+void Convolver::process(const float * in, float * out){ mImpl->process(in, out); }
+
+void Convolver::reset(){ mImpl->reset(); }
+
+int Convolver::blockSize() const { return mImpl->B; }
+
+int Convolver::irSize() const { return mImpl->L; }
+
+int Convolver::numLevels() const { return mImpl->levels.size(); }
+
+int Convolver::partitionSize(int l) const { return mImpl->levels[l]->size; }
+
+int Convolver::numPartitions(int l) const { return mImpl->levels[l]->numParts; }
+
+bool Convolver::threaded() const { return mImpl->isThreaded; }
+
+unsigned Convolver::missedDeadlines() const { return mImpl->missed; }
+
+} // gam::
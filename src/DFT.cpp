@@ -5,43 +5,186 @@
 #include "Gamma/arr.h"
 #include "Gamma/scl.h"
 
-#define CART_TO_POL(bins)\
-	if(mPrecise){\
-		for(unsigned i=1; i<numBins()-1; ++i){\
-			Complex<float> &c = bins[i];\
-			c(c.mag(), c.phase());\
-		}\
-	}\
-	else{\
-		for(unsigned i=1; i<numBins()-1; ++i){\
-			Complex<float> &c = bins[i];\
-			float m = c.normSqr();\
-			float p = scl::atan2Fast(c.i,c.r);\
-			c(scl::sqrt<1>(m), p);\
-		}\
-	}
-
-#define POL_TO_CART(bins)\
-	if(mPrecise){\
-		for(unsigned i=1; i<numBins()-1; ++i){\
-			Complex<float> &c = bins[i];\
-			c(c[0]*cos(c[1]), c[0]*sin(c[1]));\
-		}\
-	}\
-	else{\
-		for(unsigned i=1; i<numBins()-1; ++i){\
-			Complex<float> &c = bins[i];\
-			float p = scl::wrapPhase(c[1]);\
-			c(c[0]*scl::cosT8(p), c[0]*scl::sinT9(p));\
-		}\
-	}\
-
 namespace gam{
 
+// Spectrum format conversion kernels__________________________________________
+//
+// These operate on interleaved bins and leave the DC and Nyquist bins in their
+// real/imaginary format. In precise mode, they use the standard library math
+// functions. Otherwise they use polynomial approximations written with
+// selects rather than branches so that the bin loops vectorize:
+//	magnitude	relative error < 2e-6
+//	phase		absolute error < 2e-5 radians
+//	sin/cos		absolute error < 4e-6
+namespace{
+
+const float pi_f = M_PI;
+const float pi_2_f = M_PI_2;
+const float twoPi_f = M_2PI;
+const float invTwoPi_f = M_1_2PI;
+
+// Round to nearest integer; valid for |v| < 2^31
+inline float roundFast(float v){ return float(int(v + (v < 0.f ? -0.5f : 0.5f))); }
+
+// Wrap phase into [-pi, pi]
+inline double wrapPhaseRound(double p){
+	double n = p * M_1_2PI;
+	return p - M_2PI * double(long(n + (n < 0. ? -0.5 : 0.5)));
+}
+
+// atan2 from octant-reduced 9th order polynomial (Abramowitz & Stegun 4.4.48)
+inline float atan2Poly(float y, float x){
+	float ax = scl::abs(x), ay = scl::abs(y);
+	float mx = ax > ay ? ax : ay;
+	float mn = ax > ay ? ay : ax;
+	float t = mn / (mx + 1e-30f);
+	float s = t*t;
+	float r = t*(0.9998660f + s*(-0.3302995f + s*(0.1801410f + s*(-0.0851330f + s*0.0208351f))));
+	r = ay > ax ? pi_2_f - r : r;
+	r = x < 0.f ? pi_f - r : r;
+	return y < 0.f ? -r : r;
+}
+
+// sin and cos of phase in [-pi, pi] from Taylor polynomials on [-pi/2, pi/2]
+inline void sinCosPoly(float p, float& sn, float& cs){
+	bool refl = p > pi_2_f || p < -pi_2_f;
+	float q = refl ? (p > 0.f ? pi_f : -pi_f) - p : p;
+	float qq = q*q;
+	sn = q*(1.f + qq*(-1.f/6 + qq*(1.f/120 + qq*(-1.f/5040 + qq*(1.f/362880)))));
+	cs = 1.f + qq*(-0.5f + qq*(1.f/24 + qq*(-1.f/720 + qq*(1.f/40320 + qq*(-1.f/3628800)))));
+	cs = refl ? -cs : cs;
+}
+
+// Convert bins 1 to n-2 from real/imaginary to magnitude/phase
+void cartToPolar(float * b, unsigned n, bool precise){
+	if(precise){
+		for(unsigned k=1; k<n-1; ++k){
+			float re = b[2*k], im = b[2*k+1];
+			b[2*k  ] = std::sqrt(re*re + im*im);
+			b[2*k+1] = std::atan2(im, re);
+		}
+	}
+	else{
+		for(unsigned k=1; k<n-1; ++k){
+			float re = b[2*k], im = b[2*k+1];
+			b[2*k  ] = scl::sqrt<2>(re*re + im*im);
+			b[2*k+1] = atan2Poly(im, re);
+		}
+	}
+}
+
+// Convert bins 1 to n-2 from magnitude/phase to real/imaginary
+void polarToCart(float * b, unsigned n, bool precise){
+	if(precise){
+		for(unsigned k=1; k<n-1; ++k){
+			float m = b[2*k], p = b[2*k+1];
+			b[2*k  ] = m*std::cos(p);
+			b[2*k+1] = m*std::sin(p);
+		}
+	}
+	else{
+		for(unsigned k=1; k<n-1; ++k){
+			float m = b[2*k], sn, cs;
+			sinCosPoly(float(wrapPhaseRound(b[2*k+1])), sn, cs);
+			b[2*k  ] = m*cs;
+			b[2*k+1] = m*sn;
+		}
+	}
+}
+
+// Convert bins from real/imaginary to magnitude/frequency in a single pass.
+// The frequency is estimated from the phase difference to the previous frame,
+// 'phases', minus the advance expected from the hop.
+// \param[in] hopRatio	hop size over window size
+// \param[in] factor	converts phase difference in radians to frequency deviation
+// \param[in] fund		frequency of first bin
+void cartToMagFreq(
+	float * b, float * phases, unsigned n, bool precise,
+	double hopRatio, double factor, double fund, double nyq
+){
+	b[1] = 0.;
+	b[2*(n-1)+1] = nyq;
+
+	if(precise){
+		const double expdp1 = hopRatio * M_2PI;
+		for(unsigned k=1; k<n-1; ++k){
+			float re = b[2*k], im = b[2*k+1];
+			float ph = std::atan2(im, re);	// current phase
+			double t = ph - phases[k];		// compute phase diff
+			phases[k] = ph;					// save current phase
+			t -= k*expdp1;					// subtract expected phase diff due to overlap
+			t = scl::wrapPhase(t);			// wrap back into [-pi, pi)
+			t *= factor;					// convert phase diff to freq deviation
+			t += k*fund;					// freq deviation to freq
+			b[2*k  ] = std::sqrt(re*re + im*im);
+			b[2*k+1] = t;
+		}
+	}
+	else{
+		const float factorCyc = factor * M_2PI;
+		const float fundf = fund;
+		for(unsigned k=1; k<n-1; ++k){
+			float re = b[2*k], im = b[2*k+1];
+			float ph = atan2Poly(im, re);
+			// expected phase advance in cycles, reduced to [0,1) in double
+			// to keep precision at high bins
+			double e = k*hopRatio;
+			float ef = float(e - double(long(e)));
+			float cyc = (ph - phases[k]) * invTwoPi_f - ef;
+			phases[k] = ph;
+			cyc -= roundFast(cyc);
+			b[2*k  ] = scl::sqrt<2>(re*re + im*im);
+			b[2*k+1] = cyc*factorCyc + float(k)*fundf;
+		}
+	}
+}
+
+// Convert bins from magnitude/frequency to real/imaginary in a single pass,
+// accumulating the phase advance of each bin into 'accums'. Accumulated
+// phases are kept wrapped in [-pi, pi].
+// \param[in] factor	converts frequency deviation to phase difference in radians
+void magFreqToCart(
+	float * dst, const float * b, double * accums, unsigned n, bool precise,
+	double hopRatio, double factor, double fund
+){
+	const double expdp1 = hopRatio * M_2PI;
+
+	for(unsigned k=1; k<n-1; ++k){
+		double t = b[2*k+1];		// freq
+		t -= k*fund;				// freq to freq deviation
+		t *= factor;				// freq deviation to phase diff
+		t += k*expdp1;				// add expected phase diff due to overlap
+		accums[k] = wrapPhaseRound(accums[k] + t);	// accumulate phase diff
+	}
+
+	if(precise){
+		for(unsigned k=1; k<n-1; ++k){
+			float m = b[2*k];
+			dst[2*k  ] = m*std::cos(accums[k]);
+			dst[2*k+1] = m*std::sin(accums[k]);
+		}
+	}
+	else{
+		for(unsigned k=1; k<n-1; ++k){
+			float m = b[2*k], sn, cs;
+			sinCosPoly(float(accums[k]), sn, cs);
+			dst[2*k  ] = m*cs;
+			dst[2*k+1] = m*sn;
+		}
+	}
+
+	dst[0] = b[0];
+	dst[2*(n-1)] = b[2*(n-1)];
+}
+
+} // anonymous::
+
+
+
 DFT::DFT(unsigned winSize, unsigned padSize, SpectralType specT, unsigned numAuxA)
 :	mSizeWin(0), mSizeHop(0),
 	mFFT(0),
-	mPadOA(0), mTapW(0), mTapR(0), mPrecise(false)
+	mPadOA(0), mInvPos(0), mTapW(0), mTapR(0), mPrecise(false)
 {
 	//printf("DFT::DFT\n");
 	resize(winSize, padSize);
@@ -76,7 +219,7 @@ void DFT::resize(unsigned newWinSize, unsigned newPadSize){ //printf("DFT::resiz
 	mSizeWin = newWinSize;
 	mSizeHop = mSizeWin;
 	
-	mTapW = mTapR = 0;
+	mTapW = mTapR = mInvPos = 0;
 
 	onDomainChange(1);
 }
@@ -92,13 +235,18 @@ void DFT::forward(const float * src){ //printf("DFT::forward(const float *)\n");
 	if(src) mem::deepCopy(bufFwdPos(), src, sizeWin());
 	mem::deepZero(bufFwdPos() + sizeWin(), sizePad());	// zero pad
 
+	forwardTransform();
+}
+
+void DFT::forwardTransform(){
+
 	mFFT.forward(bufFwdFrq(), true, true); // complex buffer and normalize
 
 	switch(mSpctFormat){
 	case COMPLEX: break;
 	case MAG_PHASE:
 	case MAG_FREQ:
-		CART_TO_POL(mBins)
+		cartToPolar(mBuf, numBins(), mPrecise);
 		break;
 	default:;
 	}
@@ -107,22 +255,7 @@ void DFT::forward(const float * src){ //printf("DFT::forward(const float *)\n");
 void DFT::inverse(float * dst){
 	//printf("DFT::inverse(float *)\n");
 
-	// operate on copy of bins
-	if(MAG_FREQ != mSpctFormat){
-		mem::deepCopy(bufInvFrq(), bufFwdFrq(), sizeDFT()+2);
-	}
-
-	switch(mSpctFormat){
-	case COMPLEX: break;
-	case MAG_PHASE:
-	case MAG_FREQ:
-		{	Complex<float> * bins = mBins+numBins();
-			POL_TO_CART(bins)
-		}
-		break;
-	}
-
-	mFFT.inverse(bufInvFrq(), true);
+	inverseTransform();
 
 	// overlap-add inverse window with prev spill
 	if(sizePad() > 0){
@@ -146,9 +279,27 @@ void DFT::inverse(float * dst){
 	if(dst) mem::deepCopy(dst, bufInvPos(), sizeWin());
 }
 
+void DFT::inverseTransform(){
+
+	// operate on copy of bins
+	if(MAG_FREQ != mSpctFormat){
+		mem::deepCopy(bufInvFrq(), bufFwdFrq(), sizeDFT()+2);
+	}
+
+	switch(mSpctFormat){
+	case COMPLEX: break;
+	case MAG_PHASE:
+	case MAG_FREQ:
+		polarToCart(bufInvFrq(), numBins(), mPrecise);
+		break;
+	}
+
+	mFFT.inverse(bufInvFrq(), true);
+}
+
 void DFT::spctToRect(){
 	switch(mSpctFormat){
-	case MAG_PHASE: POL_TO_CART(mBins) break;
+	case MAG_PHASE: polarToCart(mBuf, numBins(), mPrecise); break;
 	default:;
 	}
 	mSpctFormat = COMPLEX;
@@ -156,7 +307,7 @@ void DFT::spctToRect(){
 
 void DFT::spctToPolar(){
 	switch(mSpctFormat){
-	case COMPLEX:	CART_TO_POL(mBins) break;
+	case COMPLEX:	cartToPolar(mBuf, numBins(), mPrecise); break;
 	default:;
 	}
 	mSpctFormat = MAG_PHASE;
@@ -189,7 +340,8 @@ void DFT::print(FILE * f, const char * a){
 
 STFT::STFT(unsigned winSize, unsigned hopSize, unsigned padSize, WindowType winType, SpectralType specType, unsigned numAuxA)
 :	DFT(0, 0, specType, numAuxA),
-	mSlide(winSize, hopSize), mFwdWin(0), mPhases(0), mAccums(0),
+	mSlide(winSize, hopSize), mFwdWin(0), mInvWin(0), mSizeInvRing(0),
+	mPhases(0), mAccums(0),
 	mWinType(winType),
 	mWindowInverse(true), mRotateForward(false)
 {
@@ -201,6 +353,7 @@ STFT::STFT(unsigned winSize, unsigned hopSize, unsigned padSize, WindowType winT
 STFT::~STFT(){ //printf("~STFT\n");
 	mem::free(mBufInv);
 	mem::free(mFwdWin);
+	mem::free(mInvWin);
 	mem::free(mPhases);
 	mem::free(mAccums);
 }
@@ -224,6 +377,19 @@ void STFT::computeInvWinMul(){
 	}
 	//printf("mFwdWinMul: %f\n", mFwdWinMul);
 	//printf("mInvWinMul: %f\n", mInvWinMul);
+
+	// fold normalization into inverse window
+	for(unsigned i=0; i<sizeWin(); ++i) mInvWin[i] = mInvWinMul;
+	if(mWindowInverse) arr::mulBartlett(mInvWin, sizeWin());
+}
+
+
+void STFT::resizeInvRing(){
+	unsigned size = (sizeDFT() + sizeHop() - 1) / sizeHop() * sizeHop();
+	mem::resize(mBufInv, mSizeInvRing, size);
+	mSizeInvRing = size;
+	mem::deepZero(mBufInv, mSizeInvRing);
+	mInvPos = 0;
 }
 
 
@@ -255,12 +421,13 @@ void STFT::resize(unsigned winSize, unsigned padSize){
 	
 	// resize STFT-specific buffers
 	mSlide.sizeWin(winSize);
+	mSizeHop = mSlide.sizeHop();	// may have been clipped to new window size
 	mem::resize(mFwdWin, oldWinSize, winSize);
-	mem::resize(mBufInv, oldWinSize, winSize);
+	mem::resize(mInvWin, oldWinSize, winSize);
 	mem::resize(mPhases, oldNumBins, numBins());
 	mem::resize(mAccums, oldNumBins, numBins());
+	resizeInvRing();
 
-	mem::deepZero(mBufInv, winSize);
 	mem::deepZero(mPhases, numBins());
 	mem::deepZero(mAccums, numBins());
 
@@ -270,9 +437,11 @@ void STFT::resize(unsigned winSize, unsigned padSize){
 
 
 STFT& STFT::sizeHop(unsigned size){
-	// Note that this call will not trigger any memory reallocation
 	mSlide.sizeHop(size); // sets member var only
-	mSizeHop = mSlide.sizeHop();
+	if(mSlide.sizeHop() != mSizeHop){
+		mSizeHop = mSlide.sizeHop();
+		resizeInvRing();
+	}
 	computeInvWinMul();
 	onDomainChange(1);
 	return *this;
@@ -312,39 +481,60 @@ STFT& STFT::resetPhases(){
 // input is sizeWin
 void STFT::forward(const float * src){ //printf("STFT::forward(float *)\n");
 
-	if(src) mem::deepCopy(bufFwdPos(), src, sizeWin());
+	if(!src){
+		src = bufFwdPos();
 
-	// apply forward window
-	arr::mul(bufFwdPos(), mFwdWin, sizeWin());
-	
-	// do zero-phase windowing rotation?
-	if(mRotateForward) mem::rotateLeft(sizeWin()/2, bufFwdPos(), sizeDFT());
+		// rotating copy cannot be done in-place
+		if(mRotateForward){
+			mem::deepCopy(bufInvPos(), bufFwdPos(), sizeWin());
+			src = bufInvPos();
+		}
+	}
 
-	DFT::forward();
-	
-	// compute frequency estimates?
-	if(MAG_FREQ == mSpctFormat){
+	window(src, 0);
+	analyze();
+}
 
-		// hopRate / 2pi: converts phase diff from radians to Hz
-		double factor = 1. / (M_2PI * unitsHop());
-		
-		// 2pi / overlap: expected phase diff of fundamental due to overlap
-		double expdp1 = double(sizeHop())/sizeWin() * M_2PI;
-		double fund = binFreq();
 
-		bin(0)[1] = 0.;
-		bin(numBins()-1)[1] = spu() * 0.5;
+// Multiply 'len' samples from ring, starting at 'start', by 'win' into 'dst'
+static void mulFromRing(float * dst, const float * ring, unsigned ringSize, unsigned start, const float * win, unsigned len){
+	unsigned n1 = scl::min(len, ringSize - start);
+	for(unsigned i=0; i<n1; ++i) dst[i] = ring[start+i] * win[i];
+	for(unsigned i=n1; i<len; ++i) dst[i] = ring[i-n1] * win[i];
+}
 
-		for(unsigned k=1; k<numBins()-1; ++k){
-			float ph = bin(k)[1];		// current phase
-			double t = ph - mPhases[k];	// compute phase diff
-			mPhases[k] = ph;			// save current phase
-			t -= k*expdp1;				// subtract expected phase diff due to overlap
-			t = scl::wrapPhase(t);		// wrap back into [-pi, pi)
-			t *= factor;				// convert phase diff to freq deviation
-			t += k*fund;				// freq deviation to freq
-			bin(k)[1] = t;
-		}
+void STFT::window(const float * src, unsigned start){
+
+	// With zero-phase rotation, the window center goes to index 0 and the
+	// first half wraps to the end of the DFT buffer, after the zero-padding.
+	const unsigned W = sizeWin();
+	const unsigned D = sizeDFT();
+	const unsigned h = mRotateForward ? W/2 : 0;
+	float * dst = bufFwdPos();
+
+	unsigned mid = start + h;
+	if(mid >= W) mid -= W;
+
+	mulFromRing(dst, src, W, mid, mFwdWin + h, W - h);
+	mem::deepZero(dst + W - h, D - W);
+	mulFromRing(dst + D - h, src, W, start, mFwdWin, h);
+}
+
+void STFT::analyze(){
+
+	// compute frequency estimates?
+	if(MAG_FREQ == mSpctFormat){
+		mFFT.forward(bufFwdFrq(), true, true); // complex buffer and normalize
+
+		cartToMagFreq(
+			mBuf, mPhases, numBins(), mPrecise,
+			double(sizeHop())/sizeWin(),	// expected phase diff of fundamental is 2pi times this
+			1. / (M_2PI * unitsHop()),		// hopRate / 2pi: converts phase diff from radians to Hz
+			binFreq(), spu() * 0.5
+		);
+	}
+	else{
+		DFT::forwardTransform();
 	}
 }
 
@@ -352,67 +542,228 @@ void STFT::forward(const float * src){ //printf("STFT::forward(float *)\n");
 void STFT::inverse(float * dst){
 	//printf("STFT::inverse(float *)\n");
 	if(MAG_FREQ == mSpctFormat){
-		// 2pi / hopRate: converts Hz to phase diff in radians
-		double factor = M_2PI * unitsHop();
-
-		// 2pi / overlap: expected phase diff of fundamental due to overlap
-		double expdp1 = double(sizeHop())/sizeWin() * M_2PI;
-		double fund = binFreq();
+		magFreqToCart(
+			bufInvFrq(), mBuf, mAccums, numBins(), mPrecise,
+			double(sizeHop())/sizeWin(),	// expected phase diff of fundamental is 2pi times this
+			M_2PI * unitsHop(),				// 2pi / hopRate: converts Hz to phase diff in radians
+			binFreq()
+		);
+		mFFT.inverse(bufInvFrq(), true);	// result goes into bufInvPos()
+	}
+	else{
+		DFT::inverseTransform();	// result goes into bufInvPos()
+	}
 
-		for(unsigned k=1; k<numBins()-1; ++k){
-			double t = bin(k)[1];		// freq
-			t -= k*fund;				// freq to freq deviation
-			t *= factor;				// freq deviation to phase diff
-			t += k*expdp1;				// add expected phase diff due to overlap
-			mAccums[k] += t;			// accumulate phase diff
-			//bin(k)[1] = mAccums[k];		// copy accum phase for inverse xfm
-			bufInvFrq()[2*k] = bin(k)[0];
-			bufInvFrq()[2*k+1] = mAccums[k];
-		}
+	const unsigned W = sizeWin();
+	const unsigned D = sizeDFT();
+	const unsigned H = sizeHop();
+	const unsigned R = mSizeInvRing;
+
+	// retire the hop that has been read out and advance to the next one
+	mem::deepZero(mBufInv + mInvPos, H);
+	mInvPos += H;
+	if(mInvPos >= R) mInvPos = 0;
+
+	// overlap-add new output into ring, undoing zero-phase rotation (if any)
+	// and applying the inverse window; zero-padded samples are only scaled
+	const float * src = bufInvPos();
+	unsigned is = (D - (mRotateForward ? W/2 : 0)) % D;
+	unsigned io = mInvPos;
+	for(unsigned j=0; j<D; ++j){
+		float m = j<W ? mInvWin[j] : mInvWinMul;
+		mBufInv[io] += src[is] * m;
+		if(++is == D) is = 0;
+		if(++io == R) io = 0;
+	}
 
-		bufInvFrq()[0] = bin(0)[0];
-		bufInvFrq()[2*(numBins()-1)] = bin(numBins()-1)[0];
+	// copy output if external buffer provided
+	if(dst){
+		unsigned n1 = scl::min(W, R - mInvPos);
+		mem::deepCopy(dst, mBufInv + mInvPos, n1);
+		mem::deepCopy(dst + n1, mBufInv, W - n1);
 	}
+}
+
+
+void STFT::print(FILE * f, const char * a){
+	DFT::print(f, "");
+	fprintf(f, "Window type:   %s\n", toString(mWinType));
+	fprintf(f, "Inv. window:   %s\n", mWindowInverse ? "true" : "false");
+	fprintf(f, "%s", a);
+}
+
+
+
+//---- MultiSTFT
+
+MultiSTFT::MultiSTFT(
+	unsigned numChans, unsigned winSize, unsigned hopSize, unsigned padSize,
+	WindowType winType, SpectralType specType
+)
+:	mNumChans(0), mSizeWin(0), mSizeHop(0), mSizeDFT(0),
+	mSpctFormat(specType), mWinType(winType), mInvWinMul(1),
+	mTapW(0), mHopCnt(0), mTapR(0), mOutCnt(0),
+	mWindowInverse(true), mPrecise(false)
+{
+	resize(numChans, winSize, hopSize, padSize);
+}
+
+
+void MultiSTFT::resize(unsigned numChans, unsigned winSize, unsigned hopSize, unsigned padSize){
+	mNumChans = numChans;
+	mSizeWin = winSize;
+	mSizeHop = scl::clip<unsigned>(hopSize, winSize, 1);
+	mSizeDFT = winSize + padSize;
+
+	mFFT.resize(mSizeDFT);
+
+	mFwdWin.assign(mSizeWin, 0.f);
+	mInvWin.assign(mSizeWin, 0.f);
+	mBufIn.assign(mNumChans * mSizeWin, 0.f);
+	mBufFwd.assign(mNumChans * stride(), 0.f);
+	mBufInv.assign(mNumChans * stride(), 0.f);
+	mBufOut.assign(mNumChans * mSizeDFT, 0.f);
+	mPhases.assign(mNumChans * numBins(), 0.f);
+	mAccums.assign(mNumChans * numBins(), 0.);
+
+	mTapW = mHopCnt = mTapR = mOutCnt = 0;
+
+	windowType(mWinType);
+}
+
+
+MultiSTFT& MultiSTFT::windowType(WindowType v){
+	mWinType = v;
+	tbl::window(&mFwdWin[0], sizeWin(), mWinType);
+	computeInvWin();
+	return *this;
+}
+
+
+MultiSTFT& MultiSTFT::inverseWindowing(bool v){
+	mWindowInverse = v;
+	computeInvWin();
+	return *this;
+}
 
-	DFT::inverse();	// result goes into bufInvPos()
 
-	// undo zero-phase windowing rotation?
-	if(mRotateForward) mem::rotateRight(sizeWin()/2, bufInvPos(), sizeDFT());
+// Same normalization as STFT::computeInvWinMul, folded into one window
+void MultiSTFT::computeInvWin(){
+	mInvWinMul = 1.f;
 
-	// apply secondary window to smooth ends?
-	if(mWindowInverse){
-		arr::mulBartlett(bufInvPos(), sizeWin());
+	if(overlapping()){
+		float sum = 0.f;
+		for(unsigned i=0; i<sizeWin(); i+=sizeHop()){
+			float invWin =  mWindowInverse ? scl::bartlett(2*i/(float)sizeWin() - 1.f) : 1.f;
+			sum += mFwdWin[i] * invWin;
+		}
+		mInvWinMul = 1.f/sum;
 	}
 
-	if(overlapping()){	//inverse windows overlap?
+	for(auto& v : mInvWin) v = mInvWinMul;
+	if(mWindowInverse) arr::mulBartlett(&mInvWin[0], sizeWin());
+}
 
-		// scale inverse so overlap-add is normalized
-		for(unsigned i=0; i<sizeWin(); ++i){
-			bufInvPos()[i] *= mInvWinMul;
+
+MultiSTFT& MultiSTFT::resetPhases(){
+	mem::deepZero(&mAccums[0], mAccums.size());
+
+	double factor = 1. / (M_2PI * unitsHop());
+	double expdp1 = double(sizeHop())/sizeWin() * M_2PI;
+	double fund = binFreq();
+
+	for(unsigned c=0; c<numChannels(); ++c){
+		Complex<float> * bins = this->bins(c);
+		float * phases = this->phases(c);
+		bins[0][1] = 0.;
+		bins[numBins()-1][1] = spu() * 0.5;
+
+		for(unsigned k=1; k<numBins()-1; ++k){
+			double t = phases[k];
+			t -= k*expdp1;
+			t = scl::wrapPhase(t);
+			t *= factor;
+			t += k*fund;
+			bins[k][1] = t;
 		}
+	}
+	return *this;
+}
+
+
+void MultiSTFT::forward(){
 
-		// shift old output left while adding new output
-		arr::add(mBufInv, bufInvPos(), mBufInv + sizeHop(), sizeWin() - sizeHop());
+	// copy windowed input rings, oldest sample first, and zero-pad
+	for(unsigned c=0; c<numChannels(); ++c){
+		const float * ring = &mBufIn[c*sizeWin()];
+		float * dst = &mBufFwd[c*stride()] + 1;
+		const float * win = &mFwdWin[0];
+		unsigned n1 = sizeWin() - mTapW;
+		for(unsigned i=0; i<n1; ++i) dst[i] = ring[mTapW+i] * win[i];
+		for(unsigned i=n1; i<sizeWin(); ++i) dst[i] = ring[i-n1] * win[i];
+		for(unsigned i=sizeWin(); i<sizeDFT(); ++i) dst[i] = 0.f;
 	}
 
-	// copy remaining non-overlapped portion of new output
-	unsigned sizeOverlap = sizeWin() - sizeHop();
-	mem::deepCopy(mBufInv + sizeOverlap, bufInvPos() + sizeOverlap, sizeHop());
+	mFFT.forwardBatch(&mBufFwd[0], numChannels(), stride(), true, true);
 
-	// copy output if external buffer provided
-	if(dst) mem::deepCopy(dst, mBufInv, sizeWin());	
+	if(MAG_PHASE == mSpctFormat){
+		for(unsigned c=0; c<numChannels(); ++c){
+			cartToPolar(&mBufFwd[c*stride()], numBins(), mPrecise);
+		}
+	}
+	else if(MAG_FREQ == mSpctFormat){
+		for(unsigned c=0; c<numChannels(); ++c){
+			cartToMagFreq(
+				&mBufFwd[c*stride()], phases(c), numBins(), mPrecise,
+				double(sizeHop())/sizeWin(), 1. / (M_2PI * unitsHop()),
+				binFreq(), spu() * 0.5
+			);
+		}
+	}
 }
 
 
-void STFT::print(FILE * f, const char * a){
-	DFT::print(f, "");
-	fprintf(f, "Window type:   %s\n", toString(mWinType));
-	fprintf(f, "Inv. window:   %s\n", mWindowInverse ? "true" : "false");
-	fprintf(f, "%s", a);
+void MultiSTFT::inverse(){
+
+	if(MAG_FREQ == mSpctFormat){
+		for(unsigned c=0; c<numChannels(); ++c){
+			magFreqToCart(
+				&mBufInv[c*stride()], &mBufFwd[c*stride()], accumPhases(c),
+				numBins(), mPrecise,
+				double(sizeHop())/sizeWin(), M_2PI * unitsHop(), binFreq()
+			);
+		}
+	}
+	else{
+		mem::deepCopy(&mBufInv[0], &mBufFwd[0], mBufFwd.size());
+
+		if(MAG_PHASE == mSpctFormat){
+			for(unsigned c=0; c<numChannels(); ++c){
+				polarToCart(&mBufInv[c*stride()], numBins(), mPrecise);
+			}
+		}
+	}
+
+	mFFT.inverseBatch(&mBufInv[0], numChannels(), stride(), true);
+
+	// window and overlap-add into output rings at read tap
+	const float * win = &mInvWin[0];
+	for(unsigned c=0; c<numChannels(); ++c){
+		const float * src = &mBufInv[c*stride()] + 1;
+		float * ring = &mBufOut[c*sizeDFT()];
+		unsigned j = mTapR;
+		for(unsigned i=0; i<sizeWin(); ++i){
+			ring[j] += src[i] * win[i];
+			if(++j == sizeDFT()) j = 0;
+		}
+		for(unsigned i=sizeWin(); i<sizeDFT(); ++i){
+			ring[j] += src[i] * mInvWinMul;
+			if(++j == sizeDFT()) j = 0;
+		}
+	}
 }
 
 } // gam::
 
-#undef CART_TO_POL
-#undef POL_TO_CART
+
 
@@ -1,32 +1,253 @@
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
 #include "Gamma/FFT.h"
+#include "Gamma/Thread.h"
 #include "fftpack++.h"
 
 namespace gam{
 
+namespace{
+
+// Immutable twiddle factors and factorization for one transform size.
+// Plans are shared by all transforms of the same size, type and precision;
+// each transform keeps only its own scratch memory.
+template <class T>
+struct FFTPlan{
+	FFTPlan(int size, bool cmplx)
+	:	n(size), wa(cmplx ? 2*size : size)
+	{
+		for(auto& f : ifac) f = 0;
+		if(n > 0){
+			if(cmplx)	fftpack::cfftiw(&n, &wa[0], ifac);
+			else		fftpack::rfftiw(&n, &wa[0], ifac);
+		}
+	}
+
+	T * twiddles() const { return const_cast<T*>(wa.data()); }
+	int * factors() const { return const_cast<int*>(ifac); }
+
+	int n;
+	int ifac[sizeof(int) /*bytes/int*/ * 8 /*bits/byte*/ - 1];
+	std::vector<T> wa;
+};
+
+// Process-wide registry of plans keyed by (size, complex?). Entries are
+// weak so a plan is freed when the last transform using it goes away.
+template <class T>
+std::shared_ptr<const FFTPlan<T>> fftPlan(int n, bool cmplx){
+	typedef std::pair<int,bool> Key;
+	static std::mutex mutex;
+	static std::map<Key, std::weak_ptr<const FFTPlan<T>>> plans;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto& entry = plans[Key(n,cmplx)];
+	auto plan = entry.lock();
+	if(!plan){
+		// drop any other stale entries while we are here
+		for(auto it = plans.begin(); it != plans.end();){
+			if(it->second.expired() && &it->second != &entry) it = plans.erase(it);
+			else ++it;
+		}
+		plan = std::make_shared<const FFTPlan<T>>(n, cmplx);
+		entry = plan;
+	}
+	return plan;
+}
+
+// Persistent threads that help transform batches. Each worker keeps its own
+// scratch memory, so running a batch neither creates threads nor allocates.
+template <class T>
+class BatchWorkers{
+public:
+
+	BatchWorkers(int numWorkers, int scratchSize)
+	:	mArgs(numWorkers)
+	{
+		for(int k=0; k<numWorkers; ++k){
+			Arg& a = mArgs[k];
+			a.workers = this;
+			a.index = k+1;
+			a.scratch.assign(scratchSize, T(0));
+			a.started = a.thread.start(workFunc, &a);
+		}
+	}
+
+	~BatchWorkers(){
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mQuit = true;
+			mCond.notify_all();
+		}
+		for(auto& a : mArgs){
+			if(a.started) a.thread.join();
+		}
+	}
+
+	int size() const { return mArgs.size(); }
+
+	// Resize worker scratch; only called between batches
+	void scratchSize(int n){
+		for(auto& a : mArgs) a.scratch.assign(n, T(0));
+	}
+
+	// Apply op(buffer, scratch) to each buffer of a batch. Buffers are split
+	// into contiguous runs, one per thread; the caller's thread does the
+	// first run using its own scratch.
+	template <class Bufs, class Op>
+	void run(int count, T * scratch, const Bufs& bufs, const Op& op){
+		struct Ctx{
+			const Bufs * bufs;
+			const Op * op;
+			static void call(const void * ctx, int beg, int end, T * scr){
+				const Ctx& c = *static_cast<const Ctx*>(ctx);
+				for(int i=beg; i<end; ++i) (*c.op)((*c.bufs)(i), scr);
+			}
+		} ctx = {&bufs, &op};
+
+		std::unique_lock<std::mutex> lock(mMutex);
+		mCall = Ctx::call;
+		mCtx = &ctx;
+		mCount = count;
+		mPending = 0;
+		for(auto& a : mArgs) mPending += a.started;
+		++mJob;
+		mCond.notify_all();
+		lock.unlock();
+
+		Ctx::call(&ctx, 0, end(0), scratch);
+		// Runs of workers that failed to start
+		for(auto& a : mArgs){
+			if(!a.started) Ctx::call(&ctx, begin(a.index), end(a.index), scratch);
+		}
+
+		lock.lock();
+		mDone.wait(lock, [this]{ return mPending == 0; });
+	}
+
+private:
+	struct Arg{
+		BatchWorkers * workers;
+		int index;
+		std::vector<T> scratch;
+		Thread thread;
+		bool started;
+	};
+
+	std::vector<Arg> mArgs;
+	std::mutex mMutex;
+	std::condition_variable mCond, mDone;
+	void (*mCall)(const void *, int, int, T *) = nullptr;
+	const void * mCtx = nullptr;
+	int mCount = 0;
+	int mPending = 0;
+	unsigned mJob = 0;
+	bool mQuit = false;
+
+	int begin(int k) const { return int(long(mCount)*k/(size()+1)); }
+	int end(int k) const { return begin(k+1); }
+
+	void work(Arg& a){
+		unsigned job = 0;
+		std::unique_lock<std::mutex> lock(mMutex);
+		while(true){
+			mCond.wait(lock, [&]{ return mQuit || mJob != job; });
+			if(mQuit) break;
+			job = mJob;
+			int beg = begin(a.index), fin = end(a.index);
+			lock.unlock();
+			mCall(mCtx, beg, fin, &a.scratch[0]);
+			lock.lock();
+			if(--mPending == 0) mDone.notify_one();
+		}
+	}
+
+	static void * workFunc(void * user){
+		Arg * a = static_cast<Arg*>(user);
+		a->workers->work(*a);
+		return NULL;
+	}
+};
+
+// Apply op(buffer, scratch) to each buffer of a batch, on the workers if
+// there are any
+template <class T, class Bufs, class Op>
+void runBatch(
+	int count, BatchWorkers<T> * workers, T * scratch,
+	const Bufs& bufs, const Op& op
+){
+	if(!workers || count < 2){
+		for(int i=0; i<count; ++i) op(bufs(i), scratch);
+		return;
+	}
+	workers->run(count, scratch, bufs, op);
+}
+
+} // anonymous::
+
 
 template <class T>
 class CFFT<T>::Impl{
 public:
-	Impl(int sz): n(0), wsave(0){
+	Impl(int sz): n(-1){
 		resize(sz);
 	}
-	
-	~Impl(){ freeMem(); }
-	
+
 	void resize(int size){
 		if(size != n){
 			n = size;
-			freeMem();
-			wsave = new T[4*n+15];
-			fftpack::cffti(&n, wsave, ifac);
+			plan = fftPlan<T>(n, true);
+			scratch.assign(scratchSize(), T(0));
+			if(workers) workers->scratchSize(scratchSize());
 		}
 	}
 
-	void freeMem(){ if(wsave){ delete[] wsave; wsave=0;} }
+	void batchThreads(int num){
+		if(num < 1) num = 1;
+		if(num == batchThreads()) return;
+		workers.reset(num > 1 ? new BatchWorkers<T>(num-1, scratchSize()) : nullptr);
+	}
+
+	int batchThreads() const { return workers ? workers->size()+1 : 1; }
+
+	int scratchSize() const { return 2*n + 1; }
+
+	void forward(T * buf, T * scr, bool normalize, T nrmGain){
+		fftpack::cfftf(&n, buf, scr, plan->twiddles(), plan->factors());
+
+		if(normalize){
+			T m = nrmGain/n;
+			for(int i=0; i<n*2; ++i) buf[i] *= m;
+		}
+	}
+
+	void inverse(T * buf, T * scr){
+		fftpack::cfftb(&n, buf, scr, plan->twiddles(), plan->factors());
+	}
+
+	template <class Bufs>
+	void forwardBatch(const Bufs& bufs, int count, bool normalize, T nrmGain){
+		runBatch(count, workers.get(), &scratch[0], bufs,
+			[this,normalize,nrmGain](T * buf, T * scr){
+				forward(buf, scr, normalize, nrmGain);
+			}
+		);
+	}
+
+	template <class Bufs>
+	void inverseBatch(const Bufs& bufs, int count){
+		runBatch(count, workers.get(), &scratch[0], bufs,
+			[this](T * buf, T * scr){ inverse(buf, scr); }
+		);
+	}
 
 	int n;
-	int ifac[sizeof(int) /*bytes/int*/ * 8 /*bits/byte*/ - 1];
-	T * wsave;				// work array
+	std::shared_ptr<const FFTPlan<T>> plan;	// shared twiddles and factors
+	std::vector<T> scratch;					// work array
+	std::unique_ptr<BatchWorkers<T>> workers;	// helpers for batches
 };
 
 
@@ -43,19 +264,40 @@ CFFT<T>::~CFFT(){
 
 template <class T>
 void CFFT<T>::forward(T * buf, bool normalize, T nrmGain){
-	fftpack::cfftf(&mImpl->n, buf, mImpl->wsave, mImpl->ifac);
-	
-	if(normalize){
-		T m = nrmGain/size();
-		for(int i=0; i<size()*2; ++i) buf[i] *= m;
-	}
+	mImpl->forward(buf, &mImpl->scratch[0], normalize, nrmGain);
 }
 	
 template <class T>
 void CFFT<T>::inverse(T * buf){
-	fftpack::cfftb(&mImpl->n, buf, mImpl->wsave, mImpl->ifac);
+	mImpl->inverse(buf, &mImpl->scratch[0]);
 }
 
+template <class T>
+void CFFT<T>::forwardBatch(T * const * bufs, int count, bool normalize, T nrmGain){
+	mImpl->forwardBatch([bufs](int i){ return bufs[i]; }, count, normalize, nrmGain);
+}
+
+template <class T>
+void CFFT<T>::forwardBatch(T * block, int count, int stride, bool normalize, T nrmGain){
+	mImpl->forwardBatch([block,stride](int i){ return block + long(i)*stride; }, count, normalize, nrmGain);
+}
+
+template <class T>
+void CFFT<T>::inverseBatch(T * const * bufs, int count){
+	mImpl->inverseBatch([bufs](int i){ return bufs[i]; }, count);
+}
+
+template <class T>
+void CFFT<T>::inverseBatch(T * block, int count, int stride){
+	mImpl->inverseBatch([block,stride](int i){ return block + long(i)*stride; }, count);
+}
+
+template <class T>
+void CFFT<T>::batchThreads(int n){ mImpl->batchThreads(n); }
+
+template <class T>
+int CFFT<T>::batchThreads() const { return mImpl->batchThreads(); }
+
 template <class T>
 void CFFT<T>::resize(int n){ mImpl->resize(n); }
 
@@ -68,26 +310,79 @@ int CFFT<T>::size() const{ return mImpl->n; }
 template <class T>
 class RFFT<T>::Impl{
 public:
-	Impl(int sz): n(0), wsave(0){
+	Impl(int sz): n(-1){
 		resize(sz);
 	}
-	
-	~Impl(){ freeMem(); }
-	
+
 	void resize(int size){
 		if(size != n){
 			n = size;
-			freeMem();
-			wsave = new T[2*n+15];
-			fftpack::rffti(&n, wsave, ifac);
+			plan = fftPlan<T>(n, false);
+			scratch.assign(scratchSize(), T(0));
+			if(workers) workers->scratchSize(scratchSize());
 		}
 	}
 
-	void freeMem(){ if(wsave){ delete[] wsave; wsave=0;} }
+	void batchThreads(int num){
+		if(num < 1) num = 1;
+		if(num == batchThreads()) return;
+		workers.reset(num > 1 ? new BatchWorkers<T>(num-1, scratchSize()) : nullptr);
+	}
+
+	int batchThreads() const { return workers ? workers->size()+1 : 1; }
+
+	int scratchSize() const { return n + 1; }
+
+	void forward(T * iobuf, T * scr, bool complexBuf, bool normalize, T nrmGain){
+
+		T * buf = complexBuf ? iobuf+1 : iobuf;
+
+		fftpack::rfftf(&n, buf, scr, plan->twiddles(), plan->factors());
+
+		if(normalize){
+			const T m = nrmGain/n;
+			for(int i=0; i<n; ++i) buf[i] *= m;
+		}
+
+		if(complexBuf){
+			iobuf[  0] = buf[0];
+			iobuf[  1] = T(0);
+			iobuf[n+1] = T(0);
+		}
+	}
+
+	void inverse(T * iobuf, T * scr, bool complexBuf){
+
+		T * buf = iobuf;
+
+		if(complexBuf){
+			buf++;
+			buf[0] = iobuf[0];
+		}
+
+		fftpack::rfftb(&n, buf, scr, plan->twiddles(), plan->factors());
+	}
+
+	template <class Bufs>
+	void forwardBatch(const Bufs& bufs, int count, bool complexBuf, bool normalize, T nrmGain){
+		runBatch(count, workers.get(), &scratch[0], bufs,
+			[this,complexBuf,normalize,nrmGain](T * buf, T * scr){
+				forward(buf, scr, complexBuf, normalize, nrmGain);
+			}
+		);
+	}
+
+	template <class Bufs>
+	void inverseBatch(const Bufs& bufs, int count, bool complexBuf){
+		runBatch(count, workers.get(), &scratch[0], bufs,
+			[this,complexBuf](T * buf, T * scr){ inverse(buf, scr, complexBuf); }
+		);
+	}
 
 	int n;
-	int ifac[sizeof(int) /*bytes/int*/ * 8 /*bits/byte*/ - 1];
-	T * wsave;				// work array
+	std::shared_ptr<const FFTPlan<T>> plan;	// shared twiddles and factors
+	std::vector<T> scratch;					// work array
+	std::unique_ptr<BatchWorkers<T>> workers;	// helpers for batches
 };
 
 
@@ -104,36 +399,40 @@ RFFT<T>::~RFFT(){
 
 template <class T>
 void RFFT<T>::forward(T * iobuf, bool complexBuf, bool normalize, T nrmGain){
-
-	T * buf = complexBuf ? iobuf+1 : iobuf;
-
-	fftpack::rfftf(&mImpl->n, buf, mImpl->wsave, mImpl->ifac);
-
-	if(normalize){
-		const T m = nrmGain/size();
-		for(int i=0; i<size(); ++i) buf[i] *= m;
-	}
-
-	if(complexBuf){
-		iobuf[       0] = buf[0];
-		iobuf[       1] = T(0);
-		iobuf[size()+1] = T(0);
-	}
+	mImpl->forward(iobuf, &mImpl->scratch[0], complexBuf, normalize, nrmGain);
 }
 	
 template <class T>
 void RFFT<T>::inverse(T * iobuf, bool complexBuf){
+	mImpl->inverse(iobuf, &mImpl->scratch[0], complexBuf);
+}
 
-	T * buf = iobuf;
+template <class T>
+void RFFT<T>::forwardBatch(T * const * bufs, int count, bool complexBuf, bool normalize, T nrmGain){
+	mImpl->forwardBatch([bufs](int i){ return bufs[i]; }, count, complexBuf, normalize, nrmGain);
+}
 
-	if(complexBuf){
-		buf++;
-		buf[0] = iobuf[0];
-	}
+template <class T>
+void RFFT<T>::forwardBatch(T * block, int count, int stride, bool complexBuf, bool normalize, T nrmGain){
+	mImpl->forwardBatch([block,stride](int i){ return block + long(i)*stride; }, count, complexBuf, normalize, nrmGain);
+}
 
-	fftpack::rfftb(&mImpl->n, buf, mImpl->wsave, mImpl->ifac);
+template <class T>
+void RFFT<T>::inverseBatch(T * const * bufs, int count, bool complexBuf){
+	mImpl->inverseBatch([bufs](int i){ return bufs[i]; }, count, complexBuf);
 }
 
+template <class T>
+void RFFT<T>::inverseBatch(T * block, int count, int stride, bool complexBuf){
+	mImpl->inverseBatch([block,stride](int i){ return block + long(i)*stride; }, count, complexBuf);
+}
+
+template <class T>
+void RFFT<T>::batchThreads(int n){ mImpl->batchThreads(n); }
+
+template <class T>
+int RFFT<T>::batchThreads() const { return mImpl->batchThreads(); }
+
 template <class T>
 void RFFT<T>::resize(int n){ mImpl->resize(n); }
 
@@ -155,4 +454,3 @@ template class CFFT<double>;
 
 } // gam::
 
-
@@ -0,0 +1,306 @@
+/*	Gamma - Generic processing library
+	See COPYRIGHT file for authors and license information */
+
+#include <condition_variable>
+#include <mutex>
+#include "Gamma/HRFilter.h"
+#include "Gamma/Thread.h"
+
+namespace gam{
+
+namespace{
+
+// Samples a source keeps running after its delay line has flushed, enough
+// for the sharpest pinna notch to decay by well over 60 dB
+const unsigned ringSamples = 2048;
+
+// Frames of lane samples filtered at a time, small enough to stay in cache
+const unsigned chunkSize = 64;
+
+// Get number of samples a source rings for after its input stops
+unsigned tailLength(const HRFilter& s){
+	const auto& d = s.mDist;
+	float far = 0.f;
+	for(int i=0; i<3; ++i) far = scl::max(far, d.dist()[i]);
+	return unsigned(far / d.speedOfSound() * d.delayLine().spu()) + 2 + ringSamples;
+}
+
+} // anonymous::
+
+
+// Pool of threads that each run a share of the groups of a block
+class DynamicHRScene::Workers{
+public:
+
+	Workers(DynamicHRScene& scene, unsigned numThreads)
+	:	mScene(scene), mArgs(numThreads)
+	{
+		for(unsigned i=0; i<numThreads; ++i){
+			mArgs[i].workers = this;
+			mArgs[i].thread = i+1;
+			mArgs[i].worker.start(workFunc, &mArgs[i]);
+		}
+	}
+
+	~Workers(){
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mQuit = true;
+			mCond.notify_all();
+		}
+		for(auto& a : mArgs) a.worker.join();
+	}
+
+	// Run share 0 in the calling thread and wait for the others
+	void run(){
+		std::unique_lock<std::mutex> lock(mMutex);
+		++mJob;
+		mPending = mArgs.size();
+		mCond.notify_all();
+		lock.unlock();
+
+		mScene.processGroups(0);
+
+		lock.lock();
+		mDone.wait(lock, [this]{ return mPending == 0; });
+	}
+
+private:
+	struct Arg{
+		Workers * workers;
+		unsigned thread;
+		Thread worker;
+	};
+
+	DynamicHRScene& mScene;
+	std::vector<Arg> mArgs;
+	std::mutex mMutex;
+	std::condition_variable mCond, mDone;
+	unsigned mJob = 0;
+	unsigned mPending = 0;
+	bool mQuit = false;
+
+	void work(unsigned thread){
+		unsigned job = 0;
+		std::unique_lock<std::mutex> lock(mMutex);
+		while(true){
+			mCond.wait(lock, [&]{ return mQuit || mJob != job; });
+			if(mQuit) break;
+			job = mJob;
+			lock.unlock();
+			mScene.processGroups(thread);
+			lock.lock();
+			if(--mPending == 0) mDone.notify_one();
+		}
+	}
+
+	static void * workFunc(void * user){
+		Arg * a = static_cast<Arg*>(user);
+		a->workers->work(a->thread);
+		return NULL;
+	}
+};
+
+
+
+DynamicHRScene::DynamicHRScene(unsigned numSources){
+	for(int i=0; i<2; ++i){
+		mReverbs[i].resize(gam::JCREVERB, i*2);
+		mReverbs[i].decay(4);
+		mReverbs[i].damping(0.25);
+	}
+	for(unsigned i=0; i<numSources; ++i) addSource();
+}
+
+DynamicHRScene::~DynamicHRScene(){
+	delete mWorkers;
+}
+
+unsigned DynamicHRScene::addSource(){
+	unsigned i = 0;
+	while(i < mSlots.size() && mSlots[i].used) ++i;
+	if(i == mSlots.size()){
+		mSlots.emplace_back();
+		if(i % laneCount == 0) mGroups.emplace_back(new Group);
+	}
+	Slot& s = mSlots[i];
+	s.source.reset(new Source);
+	s.source->dist().far(mFar);
+	s.used = true;
+	s.active = true;
+	silence(i);
+	++mNumSources;
+	return i;
+}
+
+void DynamicHRScene::removeSource(unsigned i){
+	Slot& s = mSlots[i];
+	if(!s.used) return;
+	s.used = false;
+	s.source.reset();
+	silence(i);
+	--mNumSources;
+}
+
+// Stop a source and clear its filter lanes
+void DynamicHRScene::silence(unsigned i){
+	Slot& s = mSlots[i];
+	s.in = nullptr;
+	s.quiet = 0;
+	s.running = false;
+	Group& g = *mGroups[i / laneCount];
+	for(auto& ear : g.filters){
+		for(auto& f : ear) f.zero(i % laneCount);
+	}
+	for(auto& sh : g.shadow) sh[i % laneCount] = 0.f;
+}
+
+DynamicHRScene& DynamicHRScene::threads(unsigned n){
+	if(n < 1) n = 1;
+	if(n != mThreads){
+		delete mWorkers;
+		mWorkers = n > 1 ? new Workers(*this, n-1) : nullptr;
+		mThreads = n;
+	}
+	return *this;
+}
+
+DynamicHRScene& DynamicHRScene::far(float v){
+	mFar = v;
+	for(auto& s : mSlots){
+		if(s.used) s.source->dist().far(v);
+	}
+	return *this;
+}
+
+void DynamicHRScene::process(const float * const * in, float * outL, float * outR, unsigned n){
+	if(!n) return;
+
+	// Find which sources have input and which are still ringing
+	mRunning.clear();
+	for(unsigned i=0; i<mSlots.size(); ++i){
+		Slot& s = mSlots[i];
+		s.in = nullptr;
+		if(!s.used) continue;
+		const float * x = s.active ? in[i] : nullptr;
+		if(x){
+			unsigned k = 0;
+			while(k < n && x[k] == 0.f) ++k;
+			if(k < n) s.in = x;
+		}
+		if(s.in){
+			s.quiet = 0;
+			s.running = true;
+		}
+		else if(s.running){
+			if(s.quiet >= tailLength(*s.source)){
+				silence(i);
+				continue;
+			}
+			s.quiet += n;
+		}
+		if(s.running){
+			unsigned g = i / laneCount;
+			if(mRunning.empty() || mRunning.back() != g) mRunning.push_back(g);
+		}
+	}
+
+	mBlock = n;
+	if(mMix.size() < mGroups.size()*3*n) mMix.resize(mGroups.size()*3*n);
+	if(mRoom.size() < n){ mRoom.resize(n); mEcho.resize(n); }
+
+	if(mWorkers && mRunning.size() > 1) mWorkers->run();
+	else for(unsigned g : mRunning) processGroup(g);
+
+	// Sum group mixes in a fixed order
+	float * room = &mRoom[0];
+	for(unsigned i=0; i<n; ++i) outL[i] = outR[i] = room[i] = 0.f;
+	for(unsigned g : mRunning){
+		const float * l = mix(g,0), * r = mix(g,1), * m = mix(g,2);
+		for(unsigned i=0; i<n; ++i){
+			outL[i] += l[i];
+			outR[i] += r[i];
+			room[i] += m[i];
+		}
+	}
+
+	for(unsigned i=0; i<n; ++i) room[i] *= mWallAtten;
+
+	float * echo = &mEcho[0];
+	mReverbs[0].process(room, echo, n);
+	for(unsigned i=0; i<n; ++i) outL[i] += echo[i];
+	mReverbs[1].process(room, echo, n);
+	for(unsigned i=0; i<n; ++i) outR[i] += echo[i];
+}
+
+// Run one thread's share of the running groups
+void DynamicHRScene::processGroups(unsigned thread){
+	unsigned N = mRunning.size();
+	unsigned beg = thread*N / mThreads;
+	unsigned end = (thread+1)*N / mThreads;
+	for(unsigned k=beg; k<end; ++k) processGroup(mRunning[k]);
+}
+
+void DynamicHRScene::processGroup(unsigned g){
+	static const unsigned L = laneCount;
+	Group& G = *mGroups[g];
+	Slot * slots = &mSlots[g*L];
+	unsigned numLanes = scl::min(L, unsigned(mSlots.size() - g*L));
+
+	// Copy ear filter coefficients of running sources to their lanes
+	for(unsigned l=0; l<numLanes; ++l){
+		if(!slots[l].running) continue;
+		for(int e=0; e<2; ++e){
+			const auto& ef = slots[l].source->mEarFilters[e];
+			const Biquad<> * stages[4] = {
+				&ef.backShelf, &ef.pinnaNotch1, &ef.pinnaNotch2, &ef.pinnaPeak2
+			};
+			for(int k=0; k<4; ++k){
+				const float * a = stages[k]->a(), * b = stages[k]->b();
+				G.filters[e][k].coef(l, a[0], a[1], a[2], b[1], b[2]);
+			}
+			G.shadow[e][l] = ef.shadow;
+		}
+	}
+
+	float * mixL = mix(g,0), * mixR = mix(g,1), * mixRoom = mix(g,2);
+	float frames[2][chunkSize*L];
+	float dists[3][chunkSize];
+	float * distOut[3] = {dists[0], dists[1], dists[2]};
+	const float zeros[chunkSize] = {0.f};
+
+	for(unsigned i0=0; i0<mBlock; i0+=chunkSize){
+		unsigned m = scl::min(chunkSize, mBlock-i0);
+
+		// Delay and attenuate each source into its lane
+		for(unsigned i=0; i<m; ++i) mixRoom[i0+i] = 0.f;
+		for(unsigned l=0; l<L; ++l){
+			if(l >= numLanes || !slots[l].running){
+				for(unsigned i=0; i<m; ++i) frames[0][i*L+l] = frames[1][i*L+l] = 0.f;
+				continue;
+			}
+			const float * x = slots[l].in;
+			slots[l].source->dist().process(x ? x+i0 : zeros, distOut, m);
+			for(unsigned i=0; i<m; ++i){
+				frames[0][i*L+l] = dists[0][i];
+				frames[1][i*L+l] = dists[1][i];
+				mixRoom[i0+i] += dists[2][i];
+			}
+		}
+
+		// Ear filters, all lanes at once
+		float * mixes[2] = {mixL + i0, mixR + i0};
+		for(int e=0; e<2; ++e){
+			float * f = frames[e];
+			for(auto& stage : G.filters[e]) stage.process(f, f, m);
+			const float * sh = G.shadow[e];
+			for(unsigned i=0; i<m; ++i){
+				float s = 0.f;
+				for(unsigned l=0; l<L; ++l) s += f[i*L+l] * sh[l];
+				mixes[e][i] = s;
+			}
+		}
+	}
+}
+
+} // gam::
@@ -0,0 +1,407 @@
+/*	Gamma - Generic processing library
+	See COPYRIGHT file for authors and license information */
+
+#include <cmath>
+#include <complex>
+#include <vector>
+#include "Gamma/IIRDesign.h"
+
+namespace gam{
+
+namespace{
+
+typedef std::complex<double> Cpx;
+
+const Cpx J(0,1);
+
+// Imaginary parts below this are treated as zero when pairing roots
+const double REAL_TOL = 1e-10;
+
+
+// Analog filter as poles, finite zeros and a number of zeros at infinity
+struct ZPK{
+	std::vector<Cpx> poles, zeros;
+	int numInf() const { return int(poles.size()) - int(zeros.size()); }
+};
+
+
+// Elliptic functions with normalized argument u, where u=1 is a quarter
+// period K. These use descending Landen transformations as in
+// S. J. Orfanidis, "Lecture Notes on Elliptic Filter Design", 2006.
+
+std::vector<double> landen(double k){
+	std::vector<double> v;
+	while(k > 1e-15 && v.size() < 16){
+		k = k / (1. + std::sqrt(1. - k*k));
+		k *= k;
+		v.push_back(k);
+	}
+	return v;
+}
+
+// Jacobi cd(uK, k)
+Cpx cde(Cpx u, double k){
+	std::vector<double> v = landen(k);
+	Cpx w = std::cos(u * M_PI_2);
+	for(int n=v.size()-1; n>=0; --n) w = (1. + v[n]) * w / (1. + v[n] * w*w);
+	return w;
+}
+
+// Jacobi sn(uK, k)
+Cpx sne(Cpx u, double k){
+	std::vector<double> v = landen(k);
+	Cpx w = std::sin(u * M_PI_2);
+	for(int n=v.size()-1; n>=0; --n) w = (1. + v[n]) * w / (1. + v[n] * w*w);
+	return w;
+}
+
+// Inverse of sne
+Cpx asne(Cpx w, double k){
+	std::vector<double> v = landen(k);
+	for(unsigned n=0; n<v.size(); ++n){
+		double vp = n ? v[n-1] : k;
+		w = w / (1. + std::sqrt(1. - w*w*vp*vp)) * 2. / (1. + v[n]);
+	}
+	return 1. - std::acos(w) / M_PI_2;
+}
+
+// Solve the degree equation for the elliptic modulus k given k1 and order N
+double ellipdeg(int N, double k1){
+	double k1p = std::sqrt(1. - k1*k1);
+	double prod = 1;
+	for(int i=1; i<=N/2; ++i) prod *= sne(double(2*i-1)/N, k1p).real();
+	double kp = std::pow(k1p, N) * std::pow(prod, 4);
+	return std::sqrt(1. - kp*kp);
+}
+
+
+// Analog low-pass prototypes with edge frequency 1 rad/s. Only the upper
+// half-plane member of each conjugate pair is listed, followed by its
+// conjugate.
+
+void addConj(std::vector<Cpx>& v, Cpx x){
+	if(std::abs(x.imag()) > REAL_TOL){
+		v.push_back(x);
+		v.push_back(std::conj(x));
+	}
+	else{
+		v.push_back(x.real());
+	}
+}
+
+ZPK butterworth(int N){
+	ZPK f;
+	for(int k=0; k<(N+1)/2; ++k){
+		double t = M_PI * (2*k + 1) / (2*N);
+		addConj(f.poles, Cpx(-std::sin(t), std::cos(t)));
+	}
+	return f;
+}
+
+ZPK chebyshev1(int N, double ripple){
+	ZPK f;
+	double eps = std::sqrt(std::pow(10., 0.1*ripple) - 1.);
+	double mu = std::asinh(1./eps) / N;
+	for(int k=0; k<(N+1)/2; ++k){
+		double t = M_PI * (2*k + 1) / (2*N);
+		addConj(f.poles, Cpx(-std::sinh(mu)*std::sin(t), std::cosh(mu)*std::cos(t)));
+	}
+	return f;
+}
+
+ZPK chebyshev2(int N, double atten){
+	ZPK f;
+	double eps = 1. / std::sqrt(std::pow(10., 0.1*atten) - 1.);
+	double mu = std::asinh(1./eps) / N;
+	for(int k=0; k<(N+1)/2; ++k){
+		double t = M_PI * (2*k + 1) / (2*N);
+		addConj(f.poles, 1. / Cpx(-std::sinh(mu)*std::sin(t), std::cosh(mu)*std::cos(t)));
+		if(2*k+1 != N) addConj(f.zeros, Cpx(0, 1./std::cos(t)));
+	}
+	return f;
+}
+
+ZPK elliptic(int N, double ripple, double atten){
+	ZPK f;
+	double ep = std::sqrt(std::pow(10., 0.1*ripple) - 1.);
+	double es = std::sqrt(std::pow(10., 0.1*atten) - 1.);
+	double k1 = ep / es;
+	double k = ellipdeg(N, k1);
+	double v0 = (-J * asne(J/ep, k1) / double(N)).real();
+
+	for(int i=1; i<=N/2; ++i){
+		double u = double(2*i-1) / N;
+		addConj(f.zeros, J / (k * cde(u, k)));
+		addConj(f.poles, J * cde(Cpx(u, -v0), k));
+	}
+	if(N & 1) f.poles.push_back((J * sne(J*v0, k)).real());
+	return f;
+}
+
+
+// Roots of s^2 - b s + c
+void quadRoots(Cpx b, double c, Cpx& r1, Cpx& r2){
+	Cpx d = std::sqrt(b*b - 4.*c);
+	r1 = 0.5*(b + d);
+	r2 = 0.5*(b - d);
+}
+
+// Map a root under a band transform s -> (s^2 + w0^2)/(bw s) or its inverse
+void bandMap(std::vector<Cpx>& dst, Cpx r, double bw, double w0, bool reject){
+	Cpx b = reject ? bw / r : r * bw;
+	Cpx r1, r2;
+	quadRoots(b, w0*w0, r1, r2);
+	dst.push_back(r1);
+	dst.push_back(r2);
+}
+
+// Bilinear transform with unit time constant, z = (1 + s) / (1 - s)
+Cpx bilinear(Cpx s){ return (1. + s) / (1. - s); }
+
+
+// Evaluate a section's response at a point on the z-plane
+Cpx evalSection(const BiquadCoef& c, Cpx z){
+	Cpx zi = 1. / z;
+	return (c.a0 + zi*(c.a1 + zi*c.a2)) / (1. + zi*(c.b1 + zi*c.b2));
+}
+
+
+// A root and its conjugate, or one or two real roots
+struct RootPair{
+	Cpx r1, r2;
+	int count;
+};
+
+// Remove and return the root nearest to x from a list
+Cpx takeNearest(std::vector<Cpx>& v, Cpx x){
+	unsigned best = 0;
+	for(unsigned i=1; i<v.size(); ++i){
+		if(std::abs(v[i] - x) < std::abs(v[best] - x)) best = i;
+	}
+	Cpx r = v[best];
+	v.erase(v.begin() + best);
+	return r;
+}
+
+// Pair poles with zeros, starting with the poles closest to the unit circle.
+// Sections are returned in order of increasing pole radius.
+std::vector<BiquadCoef> pairSections(const std::vector<Cpx>& poles, const std::vector<Cpx>& zeros){
+
+	// Split roots into upper half-plane complex ones and real ones
+	std::vector<Cpx> pc, pr, zc, zr;
+	for(auto p : poles){
+		if(p.imag() > REAL_TOL) pc.push_back(p);
+		else if(p.imag() >= -REAL_TOL) pr.push_back(p.real());
+	}
+	for(auto z : zeros){
+		if(z.imag() > REAL_TOL) zc.push_back(z);
+		else if(z.imag() >= -REAL_TOL) zr.push_back(z.real());
+	}
+
+	std::vector<BiquadCoef> secs;
+
+	while(pc.size() || pr.size()){
+
+		// Find pole closest to unit circle
+		bool complex = false;
+		unsigned best = 0;
+		double rad = -1;
+		for(unsigned i=0; i<pc.size(); ++i){
+			if(std::abs(pc[i]) > rad){ rad = std::abs(pc[i]); best = i; complex = true; }
+		}
+		for(unsigned i=0; i<pr.size(); ++i){
+			if(std::abs(pr[i]) > rad){ rad = std::abs(pr[i]); best = i; complex = false; }
+		}
+
+		RootPair P, Z;
+		if(complex){
+			P.r1 = pc[best]; P.r2 = std::conj(P.r1); P.count = 2;
+			pc.erase(pc.begin() + best);
+		}
+		else{
+			P.r1 = pr[best]; P.count = 1;
+			pr.erase(pr.begin() + best);
+			// pair with the real pole nearest to it
+			if(pr.size()){ P.r2 = takeNearest(pr, P.r1); P.count = 2; }
+		}
+
+		// Choose zeros nearest to the first pole
+		if(P.count == 2 && zc.size() && (complex || zr.size() < 2)){
+			Z.r1 = takeNearest(zc, P.r1); Z.r2 = std::conj(Z.r1); Z.count = 2;
+		}
+		else if(zr.size()){
+			Z.r1 = takeNearest(zr, P.r1); Z.count = 1;
+			if(P.count == 2 && zr.size()){ Z.r2 = takeNearest(zr, P.r1); Z.count = 2; }
+		}
+		else if(zc.size()){
+			Z.r1 = takeNearest(zc, P.r1); Z.r2 = std::conj(Z.r1); Z.count = 2;
+		}
+		else{
+			Z.count = 0;
+		}
+
+		BiquadCoef c;
+		if(P.count == 2){
+			c.b1 = -(P.r1 + P.r2).real();
+			c.b2 = (P.r1 * P.r2).real();
+		}
+		else{
+			c.b1 = -P.r1.real();
+			c.b2 = 0;
+		}
+		if(Z.count == 2){
+			c.a0 = 1;
+			c.a1 = -(Z.r1 + Z.r2).real();
+			c.a2 = (Z.r1 * Z.r2).real();
+		}
+		else if(Z.count == 1){
+			c.a0 = 1; c.a1 = -Z.r1.real(); c.a2 = 0;
+		}
+		else{
+			c.a0 = 1; c.a1 = 0; c.a2 = 0;
+		}
+		secs.push_back(c);
+	}
+
+	// least resonant first
+	return std::vector<BiquadCoef>(secs.rbegin(), secs.rend());
+}
+
+} // anonymous::
+
+
+
+TransferFunc BiquadCoef::transferFunc() const {
+	TransferFunc H;
+	H.addX(a0, 0).addX(a1, 1).addX(a2, 2);
+	H.addY(-b1, 1).addY(-b2, 2);
+	return H;
+}
+
+
+
+IIRDesign::IIRDesign(IIRFamily family, FilterType type, unsigned order, double freq)
+:	mFamily(family), mType(type), mOrder(order), mFreq1(freq), mFreq2(freq),
+	mRipple(1), mAtten(60)
+{}
+
+std::vector<BiquadCoef> IIRDesign::sections(double ups) const {
+	int N = mOrder;
+	if(LINKWITZ_RILEY == mFamily) N = (N+1)/2;
+	if(N < 1) return std::vector<BiquadCoef>();
+
+	// Analog prototype
+	ZPK proto;
+	switch(mFamily){
+	case CHEBYSHEV1:	proto = chebyshev1(N, mRipple); break;
+	case CHEBYSHEV2:	proto = chebyshev2(N, mAtten); break;
+	case ELLIPTIC:		proto = elliptic(N, mRipple, mAtten); break;
+	default:			proto = butterworth(N);
+	}
+
+	// Linkwitz-Riley is a Butterworth squared
+	if(LINKWITZ_RILEY == mFamily){
+		std::vector<Cpx> p = proto.poles;
+		proto.poles.insert(proto.poles.end(), p.begin(), p.end());
+	}
+
+	// Prewarped analog edge frequencies for a bilinear transform with unit
+	// time constant
+	auto warp = [ups](double f){
+		f = f * ups;
+		f = f < 1e-9 ? 1e-9 : (f > 0.4999 ? 0.4999 : f);
+		return std::tan(M_PI * f);
+	};
+	double K1 = warp(mFreq1), K2 = warp(mFreq2);
+	if(K2 < K1) std::swap(K1, K2);
+	double w0 = std::sqrt(K1*K2), bw = K2 - K1;
+
+	// Transform prototype to type, then to digital
+	std::vector<Cpx> poles, zeros;
+	int numInf = proto.numInf();
+	Cpx zRef;		// digital frequency of unit gain
+
+	switch(mType){
+	case HIGH_PASS:
+		for(auto p : proto.poles) poles.push_back(K1 / p);
+		for(auto z : proto.zeros) zeros.push_back(K1 / z);
+		for(int i=0; i<numInf; ++i) zeros.push_back(0.);
+		zRef = -1;
+		break;
+	case BAND_PASS:
+		for(auto p : proto.poles) bandMap(poles, p, bw, w0, false);
+		for(auto z : proto.zeros) bandMap(zeros, z, bw, w0, false);
+		for(int i=0; i<numInf; ++i) zeros.push_back(0.);
+		zRef = bilinear(Cpx(0, w0));
+		break;
+	case BAND_REJECT:
+		for(auto p : proto.poles) bandMap(poles, p, bw, w0, true);
+		for(auto z : proto.zeros) bandMap(zeros, z, bw, w0, true);
+		for(int i=0; i<numInf; ++i){
+			zeros.push_back(Cpx(0, w0));
+			zeros.push_back(Cpx(0,-w0));
+		}
+		zRef = 1;
+		break;
+	default: // LOW_PASS
+		for(auto p : proto.poles) poles.push_back(K1 * p);
+		for(auto z : proto.zeros) zeros.push_back(K1 * z);
+		zRef = 1;
+	}
+
+	for(auto& p : poles) p = bilinear(p);
+	for(auto& z : zeros) z = bilinear(z);
+
+	// remaining zeros at infinity map to Nyquist
+	while(zeros.size() < poles.size()) zeros.push_back(-1.);
+
+	std::vector<BiquadCoef> secs = pairSections(poles, zeros);
+
+	// Normalize each section to unit gain at the reference frequency, except
+	// for the passband ripple of even-order equiripple designs
+	for(auto& c : secs){
+		Cpx H = evalSection(c, zRef);
+		double g = 1. / std::abs(H);
+		if(H.real() < 0 && BAND_PASS != mType) g = -g;
+		c.a0 *= g; c.a1 *= g; c.a2 *= g;
+	}
+
+	if(secs.size() && !(N & 1) && (CHEBYSHEV1 == mFamily || ELLIPTIC == mFamily)){
+		double g = std::pow(10., -mRipple/20.);
+		secs[0].a0 *= g; secs[0].a1 *= g; secs[0].a2 *= g;
+	}
+
+	// Linkwitz-Riley high-pass of order 2, 6, 10, ... is inverted so that it
+	// sums with the low-pass to an all-pass rather than nulling at the edge
+	if(secs.size() && (N & 1) && LINKWITZ_RILEY == mFamily && HIGH_PASS == mType){
+		secs[0].a0 = -secs[0].a0; secs[0].a1 = -secs[0].a1; secs[0].a2 = -secs[0].a2;
+	}
+
+	return secs;
+}
+
+TransferFunc IIRDesign::transferFunc(double ups) const {
+	std::vector<double> num(1, 1.), den(1, 1.);
+
+	auto mul = [](std::vector<double>& p, double c0, double c1, double c2){
+		std::vector<double> r(p.size() + 2, 0.);
+		for(unsigned i=0; i<p.size(); ++i){
+			r[i  ] += p[i]*c0;
+			r[i+1] += p[i]*c1;
+			r[i+2] += p[i]*c2;
+		}
+		p.swap(r);
+	};
+
+	for(const auto& c : sections(ups)){
+		mul(num, c.a0, c.a1, c.a2);
+		mul(den, 1., c.b1, c.b2);
+	}
+
+	TransferFunc H;
+	for(unsigned i=0; i<num.size(); ++i) H.addX(num[i], i);
+	for(unsigned i=1; i<den.size(); ++i) H.addY(-den[i], i);
+	return H;
+}
+
+} // gam::
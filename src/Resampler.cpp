@@ -0,0 +1,157 @@
+/*	Gamma - Generic processing library
+	See COPYRIGHT file for authors and license information */
+
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include "Gamma/Resampler.h"
+
+namespace gam{
+
+namespace{
+
+// Zeroth-order modified Bessel function of the first kind
+double besselI0(double x){
+	double sum = 1, term = 1;
+	double q = 0.25*x*x;
+	for(int k=1; k<200; ++k){
+		term *= q/(double(k)*k);
+		sum += term;
+		if(term < 1e-17*sum) break;
+	}
+	return sum;
+}
+
+// Kaiser window shape parameter for a stopband attenuation in dB
+double kaiserBeta(double A){
+	if(A > 50) return 0.1102*(A - 8.7);
+	if(A > 21) return 0.5842*std::pow(A - 21, 0.4) + 0.07886*(A - 21);
+	return 0;
+}
+
+} // anonymous::
+
+
+SincTable::SincTable(unsigned taps, unsigned phases, double attenuation)
+:	mTaps((taps+1) & ~1u), mPhases(phases), mAttenuation(attenuation)
+{
+	if(mTaps < 2) mTaps = 2;
+	if(mPhases < 1) mPhases = 1;
+
+	// Kaiser's estimate of the transition width, as a fraction of the rate
+	double width = (attenuation - 7.95) / (14.36 * mTaps);
+	if(width > 0.5) width = 0.5;
+	mCutoff = 0.5 - 0.25*width;
+	mPassband = mCutoff - 0.5*width;
+
+	const double beta = kaiserBeta(attenuation);
+	const double norm = 1./besselI0(beta);
+	const double half = 0.5*mTaps;
+	const int c = mTaps/2 - 1;
+
+	mTable.resize((mPhases+1)*mTaps);
+	for(unsigned p=0; p<=mPhases; ++p){
+		float * r = &mTable[p*mTaps];
+		double sum = 0;
+		std::vector<double> h(mTaps);
+		for(unsigned k=0; k<mTaps; ++k){
+			double t = double(int(k) - c) - double(p)/mPhases;
+			double u = t / half;
+			double w = u*u < 1. ? besselI0(beta*std::sqrt(1. - u*u))*norm : 0.;
+			double x = 2.*mCutoff*t;
+			double s = x != 0. ? std::sin(M_PI*x)/(M_PI*x) : 1.;
+			h[k] = 2.*mCutoff*s*w;
+			sum += h[k];
+		}
+		// Exact unit DC gain at every phase
+		for(unsigned k=0; k<mTaps; ++k) r[k] = float(h[k]/sum);
+	}
+
+	// Kernel at t = g/phases - taps/2 is row (k+1)*phases - g, column k
+	mDense.resize(mTaps*mPhases + 1);
+	for(unsigned g=0; g<mDense.size(); ++g){
+		unsigned k = (g + mPhases - 1)/mPhases;
+		mDense[g] = k ? row(k*mPhases - g)[k-1] : 0.f;
+	}
+}
+
+unsigned SincTable::span(double scale) const {
+	if(scale >= 1.) return mTaps;
+	return 2*unsigned(std::ceil(0.5*mTaps/scale));
+}
+
+float SincTable::at(double t) const {
+	double g = (t + 0.5*mTaps)*mPhases;
+	if(g < 0. || g >= double(mTaps*mPhases)) return 0.f;
+	unsigned i = unsigned(g);
+	float a = float(g - i);
+	return mDense[i] + a*(mDense[i+1] - mDense[i]);
+}
+
+void SincTable::coefs(float * dst, double frac, double scale) const {
+	if(scale >= 1.){
+		double q = frac*mPhases;
+		unsigned p = unsigned(q);
+		if(p >= mPhases) p = mPhases-1;
+		float a = float(q - p);
+		const float * r0 = row(p);
+		const float * r1 = r0 + mTaps;
+		for(unsigned k=0; k<mTaps; ++k) dst[k] = r0[k] + a*(r1[k] - r0[k]);
+	}
+	else{
+		unsigned n = span(scale);
+		const double end = double(mTaps*mPhases);
+		const double dg = scale*mPhases;
+		double g = (0.5*mTaps - (double(n/2 - 1) + frac)*scale)*mPhases;
+		const float * d = &mDense[0];
+		double sum = 0;
+		for(unsigned k=0; k<n; ++k){
+			float v = 0.f;
+			if(g >= 0. && g < end){
+				unsigned i = unsigned(g);
+				float a = float(g - i);
+				v = d[i] + a*(d[i+1] - d[i]);
+			}
+			dst[k] = v;
+			sum += v;
+			g += dg;
+		}
+		// Stretched taps fall between tabulated phases, so normalize here
+		float gain = float(1./sum);
+		for(unsigned k=0; k<n; ++k) dst[k] *= gain;
+	}
+}
+
+
+std::shared_ptr<const SincTable> SincTable::get(Quality q){
+	switch(q){
+	case FAST:		return get( 16,   64,  60);
+	case MEDIUM:	return get( 32,  256,  80);
+	case BEST:		return get(128, 4096, 140);
+	default:		return get( 64, 1024, 110);
+	}
+}
+
+// Process-wide registry of tables. Entries are weak so a table is freed when
+// the last user goes away.
+std::shared_ptr<const SincTable> SincTable::get(unsigned taps, unsigned phases, double attenuation){
+	typedef std::tuple<unsigned,unsigned,double> Key;
+	static std::mutex mutex;
+	static std::map<Key, std::weak_ptr<const SincTable>> tables;
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto& entry = tables[Key(taps,phases,attenuation)];
+	auto table = entry.lock();
+	if(!table){
+		for(auto it = tables.begin(); it != tables.end();){
+			if(it->second.expired() && &it->second != &entry) it = tables.erase(it);
+			else ++it;
+		}
+		table = std::make_shared<const SincTable>(taps, phases, attenuation);
+		entry = table;
+	}
+	return table;
+}
+
+} // gam::
@@ -0,0 +1,455 @@
+/*	Gamma - Generic processing library
+	See COPYRIGHT file for authors and license information */
+
+#include <string.h>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "Gamma/Config.h"
+#include "Gamma/Conversion.h"
+#include "Gamma/Spectrogram.h"
+#include "Gamma/Thread.h"
+
+#if GAM_WINDOWS
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+	#ifdef far
+	#undef far
+	#endif
+	#ifdef near
+	#undef near
+	#endif
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace gam{
+
+namespace{
+
+const uint32_t BYTE_ORDER_MARK = 0x01020304;
+const uint32_t FLAG_ROTATE_FORWARD = 1;
+
+// On-disk header; frames begin at headerSize bytes from the start of the file.
+// New fields may be appended to the reserved space by later versions.
+struct Header{
+	char magic[4];			// "GSPC"
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t byteOrder;		// BYTE_ORDER_MARK as written by the host
+	uint32_t sampleFormat;
+	uint32_t spectralType;
+	uint32_t windowType;
+	uint32_t winSize;
+	uint32_t hopSize;
+	uint32_t padSize;
+	uint32_t numBins;
+	uint32_t flags;
+	uint64_t numFrames;
+	uint64_t numSamples;
+	double sampleRate;
+	char reserved[56];
+};
+
+static_assert(sizeof(Header) == 128, "Spectrogram header must be 128 bytes");
+
+unsigned bytesPerValue(uint32_t fmt){
+	return SpectrogramFile::FLOAT16 == fmt ? 2 : 4;
+}
+
+
+// Memory mapping of an entire file
+class MappedFile{
+public:
+	MappedFile(): mData(0), mSize(0)
+	#if GAM_WINDOWS
+		, mFile(INVALID_HANDLE_VALUE), mMap(NULL)
+	#else
+		, mFD(-1)
+	#endif
+	{}
+
+	~MappedFile(){ close(); }
+
+	// Map existing file read-only
+	bool openRead(const char * path){
+		close();
+	#if GAM_WINDOWS
+		mFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+			OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if(INVALID_HANDLE_VALUE == mFile) return false;
+		LARGE_INTEGER size;
+		if(!GetFileSizeEx(mFile, &size) || 0 == size.QuadPart){ close(); return false; }
+		mSize = size.QuadPart;
+		mMap = CreateFileMappingA(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(!mMap){ close(); return false; }
+		mData = (char *)MapViewOfFile(mMap, FILE_MAP_READ, 0, 0, 0);
+	#else
+		mFD = ::open(path, O_RDONLY);
+		if(mFD < 0) return false;
+		struct stat st;
+		if(fstat(mFD, &st) != 0 || 0 == st.st_size){ close(); return false; }
+		mSize = st.st_size;
+		void * p = mmap(NULL, mSize, PROT_READ, MAP_SHARED, mFD, 0);
+		mData = MAP_FAILED == p ? 0 : (char *)p;
+	#endif
+		if(!mData){ close(); return false; }
+		return true;
+	}
+
+	// Create (or truncate) file of given size and map it read-write
+	bool openWrite(const char * path, uint64_t size){
+		close();
+		mSize = size;
+	#if GAM_WINDOWS
+		mFile = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL,
+			CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if(INVALID_HANDLE_VALUE == mFile) return false;
+		// creating a mapping larger than the file extends it
+		mMap = CreateFileMappingA(mFile, NULL, PAGE_READWRITE,
+			DWORD(size >> 32), DWORD(size), NULL);
+		if(!mMap){ close(); return false; }
+		mData = (char *)MapViewOfFile(mMap, FILE_MAP_WRITE, 0, 0, 0);
+	#else
+		mFD = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+		if(mFD < 0) return false;
+		// allocate blocks up front so a full disk fails here rather than
+		// faulting on a write through the mapping
+		#if GAM_LINUX
+		if(posix_fallocate(mFD, 0, size) != 0){ close(); return false; }
+		#else
+		if(ftruncate(mFD, size) != 0){ close(); return false; }
+		#endif
+		void * p = mmap(NULL, mSize, PROT_READ | PROT_WRITE, MAP_SHARED, mFD, 0);
+		mData = MAP_FAILED == p ? 0 : (char *)p;
+	#endif
+		if(!mData){ close(); return false; }
+		return true;
+	}
+
+	// Write mapped changes to disk
+	bool flush(){
+		if(!mData) return false;
+	#if GAM_WINDOWS
+		return FlushViewOfFile(mData, 0) && FlushFileBuffers(mFile);
+	#else
+		return 0 == msync(mData, mSize, MS_SYNC);
+	#endif
+	}
+
+	void close(){
+	#if GAM_WINDOWS
+		if(mData) UnmapViewOfFile(mData);
+		if(mMap) CloseHandle(mMap);
+		if(INVALID_HANDLE_VALUE != mFile) CloseHandle(mFile);
+		mMap = NULL;
+		mFile = INVALID_HANDLE_VALUE;
+	#else
+		if(mData) munmap(mData, mSize);
+		if(mFD >= 0) ::close(mFD);
+		mFD = -1;
+	#endif
+		mData = 0;
+		mSize = 0;
+	}
+
+	char * data() const { return mData; }
+	uint64_t size() const { return mSize; }
+
+private:
+	char * mData;
+	uint64_t mSize;
+	#if GAM_WINDOWS
+	HANDLE mFile, mMap;
+	#else
+	int mFD;
+	#endif
+
+	MappedFile(const MappedFile&);
+	MappedFile& operator= (const MappedFile&);
+};
+
+
+// Analyze frames [beg, end) into 'frames', the start of the frame data
+void analyzeFrames(
+	STFT& stft, SpectralType specType, const float * src, uint64_t numSamples,
+	unsigned stride, uint64_t beg, uint64_t end, uint32_t fmt, char * frames
+){
+	const unsigned W = stft.sizeWin();
+	const unsigned H = stft.sizeHop();
+	const unsigned nb = stft.numBins();
+	const unsigned frameSize = 2*nb*bytesPerValue(fmt);
+	std::vector<float> win(W);
+
+	// Frequency estimates depend on the previous frame's phases
+	uint64_t f = beg;
+	if(MAG_FREQ == specType && f > 0) --f;
+
+	for(; f < end; ++f){
+		// window start, in samples, may be negative
+		int64_t s0 = int64_t((f+1)*H) - int64_t(W);
+		for(unsigned i=0; i<W; ++i){
+			int64_t j = s0 + i;
+			win[i] = (j >= 0 && uint64_t(j) < numSamples) ? src[uint64_t(j)*stride] : 0.f;
+		}
+
+		stft.forward(&win[0]);
+
+		if(f < beg) continue;
+
+		char * dst = frames + f*frameSize;
+		if(SpectrogramFile::FLOAT16 == fmt){
+			uint16_t * d = (uint16_t *)dst;
+			const float * b = stft.bins()[0].elems;
+			for(unsigned i=0; i<2*nb; ++i) d[i] = floatToHalf(b[i]);
+		}
+		else{
+			memcpy(dst, stft.bins(), frameSize);
+		}
+	}
+}
+
+} // anonymous::
+
+
+
+class SpectrogramFile::Impl{
+public:
+	Impl(): header(0), frames(0), frameSize(0){}
+
+	bool open(const char * path){
+		close();
+		if(!file.openRead(path)) return false;
+
+		// Reject other formats, newer versions and files from other byte orders
+		const Header * h = (const Header *)file.data();
+		if(
+			file.size() < sizeof(Header)
+			|| memcmp(h->magic, "GSPC", 4) != 0
+			|| h->byteOrder != BYTE_ORDER_MARK
+			|| h->version < 1 || h->version > SpectrogramFile::version
+			|| h->headerSize < sizeof(Header) || h->headerSize > file.size()
+			|| h->sampleFormat > FLOAT16
+			|| h->spectralType > MAG_FREQ
+			|| h->numBins != (h->winSize + h->padSize)/2 + 1
+		){
+			close(); return false;
+		}
+
+		uint64_t size = 2*uint64_t(h->numBins)*bytesPerValue(h->sampleFormat);
+		if((file.size() - h->headerSize) / size < h->numFrames){
+			close(); return false;
+		}
+
+		header = h;
+		frames = file.data() + h->headerSize;
+		frameSize = unsigned(size);
+		return true;
+	}
+
+	void close(){
+		file.close();
+		header = 0;
+		frames = 0;
+		frameSize = 0;
+	}
+
+	MappedFile file;
+	const Header * header;
+	const char * frames;
+	unsigned frameSize;
+};
+
+
+
+SpectrogramFile::SpectrogramFile()
+:	mImpl(new Impl)
+{}
+
+SpectrogramFile::SpectrogramFile(const char * path)
+:	mImpl(new Impl)
+{
+	open(path);
+}
+
+SpectrogramFile::~SpectrogramFile(){
+	if(mImpl){ delete mImpl; mImpl=0; }
+}
+
+bool SpectrogramFile::open(const char * path){ return mImpl->open(path); }
+
+void SpectrogramFile::close(){ mImpl->close(); }
+
+bool SpectrogramFile::opened() const { return 0 != mImpl->header; }
+
+const void * SpectrogramFile::frameData(uint64_t index) const {
+	if(!opened() || index >= numFrames()) return NULL;
+	return mImpl->frames + index * mImpl->frameSize;
+}
+
+bool SpectrogramFile::frame(Complex<float> * dst, uint64_t index) const {
+	const void * src = frameData(index);
+	if(!src) return false;
+	float * d = dst[0].elems;
+	if(FLOAT16 == sampleFormat()){
+		const uint16_t * s = (const uint16_t *)src;
+		for(unsigned i=0; i<2*numBins(); ++i) d[i] = halfToFloat(s[i]);
+	}
+	else{
+		memcpy(d, src, mImpl->frameSize);
+	}
+	return true;
+}
+
+bool SpectrogramFile::frame(STFT& dst, uint64_t index) const {
+	if(dst.numBins() != numBins()) return false;
+	return frame(dst.bins(), index);
+}
+
+uint64_t SpectrogramFile::numFrames() const { return mImpl->header ? mImpl->header->numFrames : 0; }
+uint64_t SpectrogramFile::numSamples() const { return mImpl->header ? mImpl->header->numSamples : 0; }
+unsigned SpectrogramFile::numBins() const { return mImpl->header ? mImpl->header->numBins : 0; }
+unsigned SpectrogramFile::sizeWin() const { return mImpl->header ? mImpl->header->winSize : 0; }
+unsigned SpectrogramFile::sizeHop() const { return mImpl->header ? mImpl->header->hopSize : 0; }
+unsigned SpectrogramFile::sizePad() const { return mImpl->header ? mImpl->header->padSize : 0; }
+unsigned SpectrogramFile::sizeDFT() const { return sizeWin() + sizePad(); }
+unsigned SpectrogramFile::sizeFrame() const { return mImpl->frameSize; }
+double SpectrogramFile::sampleRate() const { return mImpl->header ? mImpl->header->sampleRate : 0; }
+
+bool SpectrogramFile::rotateForward() const {
+	return mImpl->header && (mImpl->header->flags & FLAG_ROTATE_FORWARD);
+}
+
+WindowType SpectrogramFile::windowType() const {
+	return mImpl->header ? WindowType(mImpl->header->windowType) : RECTANGLE;
+}
+
+SpectralType SpectrogramFile::spectralType() const {
+	return mImpl->header ? SpectralType(mImpl->header->spectralType) : COMPLEX;
+}
+
+SpectrogramFile::SampleFormat SpectrogramFile::sampleFormat() const {
+	return mImpl->header ? SampleFormat(mImpl->header->sampleFormat) : FLOAT32;
+}
+
+
+
+SpectrogramAnalyzer::SpectrogramAnalyzer(
+	unsigned winSize, unsigned hopSize, unsigned padSize,
+	WindowType winType, SpectralType specType
+)
+:	mWinSize(winSize < 1 ? 1 : winSize),
+	mHopSize(scl::clip<unsigned>(hopSize, mWinSize, 1)),
+	mPadSize(padSize),
+	mWinType(winType), mSpecType(specType), mSampleFormat(SpectrogramFile::FLOAT32),
+	mThreads(0), mPrecise(false), mRotateForward(false)
+{}
+
+uint64_t SpectrogramAnalyzer::numFrames(uint64_t numSamples) const {
+	if(0 == numSamples) return 0;
+	// last frame is the last whose window starts before the end of the signal
+	return (numSamples + mWinSize + mHopSize - 1) / mHopSize - 1;
+}
+
+bool SpectrogramAnalyzer::analyze(
+	const char * path, const float * src, uint64_t numSamples,
+	double sampleRate, unsigned stride
+) const {
+
+	const uint64_t numFrm = numFrames(numSamples);
+	const unsigned numBins = (mWinSize + mPadSize)/2 + 1;
+	const uint64_t frameSize = 2*uint64_t(numBins)*bytesPerValue(mSampleFormat);
+
+	MappedFile file;
+	if(!file.openWrite(path, sizeof(Header) + numFrm*frameSize)) return false;
+
+	Header& h = *(Header *)file.data();
+	memset(&h, 0, sizeof(Header));
+	memcpy(h.magic, "GSPC", 4);
+	h.version = SpectrogramFile::version;
+	h.headerSize = sizeof(Header);
+	h.byteOrder = BYTE_ORDER_MARK;
+	h.sampleFormat = mSampleFormat;
+	h.spectralType = mSpecType;
+	h.windowType = mWinType;
+	h.winSize = mWinSize;
+	h.hopSize = mHopSize;
+	h.padSize = mPadSize;
+	h.numBins = numBins;
+	h.flags = mRotateForward ? FLAG_ROTATE_FORWARD : 0;
+	h.numFrames = numFrm;
+	h.numSamples = numSamples;
+	h.sampleRate = sampleRate;
+
+	char * frames = file.data() + sizeof(Header);
+
+	// Give each thread a useful amount of work
+	unsigned nt = mThreads ? mThreads : std::thread::hardware_concurrency();
+	const uint64_t minFrames = 64;
+	if(uint64_t(nt) * minFrames > numFrm) nt = unsigned(numFrm / minFrames);
+	if(nt < 1) nt = 1;
+
+	// STFTs attach to a Domain on construction, so they must be created and
+	// destroyed on this thread
+	Domain domain(sampleRate);
+	std::vector<std::unique_ptr<STFT>> stfts;
+	for(unsigned k=0; k<nt; ++k){
+		stfts.emplace_back(new STFT(mWinSize, mHopSize, mPadSize, mWinType, mSpecType));
+		STFT& s = *stfts.back();
+		s.domain(domain);
+		s.precise(mPrecise);
+		s.rotateForward(mRotateForward);
+	}
+
+	struct Job{
+		STFT * stft;
+		SpectralType specType;
+		const float * src;
+		uint64_t numSamples, beg, end;
+		unsigned stride;
+		uint32_t fmt;
+		char * frames;
+
+		void run(){ analyzeFrames(*stft, specType, src, numSamples, stride, beg, end, fmt, frames); }
+
+		static void * call(void * user){
+			static_cast<Job*>(user)->run();
+			return NULL;
+		}
+	};
+
+	std::vector<Job> jobs(nt);
+	std::vector<Thread> threads(nt);
+	std::vector<bool> started(nt);
+
+	for(unsigned k=0; k<nt; ++k){
+		Job& j = jobs[k];
+		j.stft = stfts[k].get();
+		j.specType = mSpecType;
+		j.src = src;
+		j.numSamples = numSamples;
+		j.beg = numFrm * k / nt;
+		j.end = numFrm * (k+1) / nt;
+		j.stride = stride;
+		j.fmt = mSampleFormat;
+		j.frames = frames;
+	}
+
+	for(unsigned k=1; k<nt; ++k){
+		started[k] = threads[k].start(Job::call, &jobs[k]);
+		if(!started[k]) jobs[k].run();
+	}
+
+	jobs[0].run();
+
+	for(unsigned k=1; k<nt; ++k){
+		if(started[k]) threads[k].join();
+	}
+
+	return file.flush();
+}
+
+} // gam::
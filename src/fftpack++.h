@@ -136,6 +136,15 @@ void sint1(int *n, float *x, float *wsave, int *ifac);
 /* Initialization routine for (fftpack/sint) */
 void sinti1(int *n, float *wsave, int *ifac);
 
+/* Split-workspace variants: scratch 'ch' (2n complex, n real) is passed
+   separately from the twiddles 'wa' so 'wa' and 'ifac' can be shared */
+void cfftbw1(int *n, float *c, float *ch, float *wa, int *ifac);
+void cfftfw1(int *n, float *c, float *ch, float *wa, int *ifac);
+void cfftiw1(int *n, float *wa, int *ifac);
+void rfftbw1(int *n, float *r, float *ch, float *wa, int *ifac);
+void rfftfw1(int *n, float *r, float *ch, float *wa, int *ifac);
+void rfftiw1(int *n, float *wa, int *ifac);
+
 
 /* Double-precision */
 
@@ -184,6 +193,15 @@ void sint2(int *n, double *x, double *wsave, int *ifac);
 /* Initialization routine for (fftpack/sint) */
 void sinti2(int *n, double *wsave, int *ifac);
 
+/* Split-workspace variants: scratch 'ch' (2n complex, n real) is passed
+   separately from the twiddles 'wa' so 'wa' and 'ifac' can be shared */
+void cfftbw2(int *n, double *c, double *ch, double *wa, int *ifac);
+void cfftfw2(int *n, double *c, double *ch, double *wa, int *ifac);
+void cfftiw2(int *n, double *wa, int *ifac);
+void rfftbw2(int *n, double *r, double *ch, double *wa, int *ifac);
+void rfftfw2(int *n, double *r, double *ch, double *wa, int *ifac);
+void rfftiw2(int *n, double *wa, int *ifac);
+
 
 #ifdef __cplusplus
 }
@@ -242,6 +260,14 @@ inline void sint(int *n, float *x, float *wsave, int *ifac){ sint1(n,x,wsave,ifa
 /* Initialization routine for fftpack::sint */
 inline void sinti(int *n, float *wsave, int *ifac){ sinti1(n,wsave,ifac); }
 
+/* Split-workspace variants of the complex and real transforms */
+inline void cfftb(int *n, float *c, float *ch, float *wa, int *ifac){ cfftbw1(n,c,ch,wa,ifac); }
+inline void cfftf(int *n, float *c, float *ch, float *wa, int *ifac){ cfftfw1(n,c,ch,wa,ifac); }
+inline void cfftiw(int *n, float *wa, int *ifac){ cfftiw1(n,wa,ifac); }
+inline void rfftb(int *n, float *r, float *ch, float *wa, int *ifac){ rfftbw1(n,r,ch,wa,ifac); }
+inline void rfftf(int *n, float *r, float *ch, float *wa, int *ifac){ rfftfw1(n,r,ch,wa,ifac); }
+inline void rfftiw(int *n, float *wa, int *ifac){ rfftiw1(n,wa,ifac); }
+
 
 /* Double-precision */
 
@@ -290,6 +316,14 @@ inline void sint(int *n, double *x, double *wsave, int *ifac){ sint2(n,x,wsave,i
 /* Initialization routine for fftpack::sint */
 inline void sinti(int *n, double *wsave, int *ifac){ sinti2(n,wsave,ifac); }
 
+/* Split-workspace variants of the complex and real transforms */
+inline void cfftb(int *n, double *c, double *ch, double *wa, int *ifac){ cfftbw2(n,c,ch,wa,ifac); }
+inline void cfftf(int *n, double *c, double *ch, double *wa, int *ifac){ cfftfw2(n,c,ch,wa,ifac); }
+inline void cfftiw(int *n, double *wa, int *ifac){ cfftiw2(n,wa,ifac); }
+inline void rfftb(int *n, double *r, double *ch, double *wa, int *ifac){ rfftbw2(n,r,ch,wa,ifac); }
+inline void rfftf(int *n, double *r, double *ch, double *wa, int *ifac){ rfftfw2(n,r,ch,wa,ifac); }
+inline void rfftiw(int *n, double *wa, int *ifac){ rfftiw2(n,wa,ifac); }
+
 
 }; // fftpack::
 
@@ -72,6 +72,7 @@ int main(int argc, char* argv[]){
 	#include "ut/utEnvelope.cpp"
 	#include "ut/utFilter.cpp"
 	#include "ut/utGenerators.cpp"
+	#include "ut/utSpatial.cpp"
 
 //	printf("Unit testing succeeded.\n");
 
@@ -52,6 +52,22 @@
 	T(-0.0, 0)	T(-0.2, 0) T(-1.0, 1) T(-1.2, 1) T(-1.5, 1) T(-1.8, 1) 
 	#undef T
 
+	#define T(x, y) assert(floatToHalf(x) == y && halfToFloat(y) == x);
+	T(0.f, 0) T(-0.f, 0x8000) T(1.f, 0x3c00) T(-2.f, 0xc000) T(0.5f, 0x3800)
+	T(65504.f, 0x7bff) T(6.103515625e-05f, 0x0400) T(5.9604644775390625e-08f, 0x0001)
+	T(1.f/0.f, 0x7c00)
+	#undef T
+
+	// rounding to nearest even, overflow and underflow
+	#define T(x, y) assert(floatToHalf(x) == y);
+	T(1.f + 1.f/2048, 0x3c00) T(1.f + 3.f/2048, 0x3c02) T(65520.f, 0x7c00)
+	T(65519.f, 0x7bff) T(2.9802322387695312e-08f, 0) T(2.98023259e-08f, 1)
+	#undef T
+
+	for(int i=0; i<0x7c00; ++i){
+		assert(floatToHalf(halfToFloat(uint16_t(i))) == i);
+	}
+
 	#define T(x, y) assert(intToUnit(int16_t(x)) == y);
 	T(0, 0) T(-32768, -1) T(32767, 32767./32768)
 	#undef T
@@ -17,3 +17,139 @@
 	assert(4 == delay.read(3));
 	assert(3 == delay.read(4));
 }
+
+{
+	// Block processing matches sample processing
+	const int N = 300;
+	float in[N], out[N];
+	for(int i=0; i<N; ++i) in[i] = sin(i*0.37f) + 0.25f*float(i%7);
+
+	const float delays[] = {0, 1, 5, 31, 32, 7.25f, 0.5f, 19.8f};
+	for(float d : delays){
+		Delay<float, ipl::Linear, Domain1> a(32, d), b(32, d);
+		Delay<float, ipl::Cubic, Domain1> c(32, d), e(32, d);
+		for(int i=0; i<N; ++i) out[i] = in[i];
+		// odd block sizes cross the wrap point at different offsets
+		a.process(out, 45);
+		a.process(out+45, N-45);
+		for(int i=0; i<N; ++i) assert(out[i] == b(in[i]));
+
+		c.process(in, out, 77);
+		c.process(in+77, out+77, N-77);
+		for(int i=0; i<N; ++i) assert(out[i] == e(in[i]));
+
+		Comb<float, ipl::Linear, float, Domain1> f(32, d, 0.3f, -0.6f), g(32, d, 0.3f, -0.6f);
+		f.process(in, out, 50);
+		f.process(in+50, out+50, N-50);
+		for(int i=0; i<N; ++i) assert(out[i] == g(in[i]));
+	}
+
+	// Sweeping the delay across a block
+	Delay<float, ipl::Linear, Domain1> a(32, 4), b(32, 4);
+	a.process(in, out, 100, 12);
+	assert(a.delay() == 12);
+	for(int i=0; i<100; ++i){
+		b.delay(4 + 8*(i+1)/100.f);
+		assert(near(out[i], b(in[i]), 1e-4));
+	}
+}
+
+{
+	// Multitap sums and per-tap reads match single tap reads
+	const unsigned T = 37;
+	Multitap<float, ipl::Linear, Domain1> mt(64, T);
+	Multitap<float, ipl::Cubic, Domain1> mc(64, T);
+	for(unsigned t=0; t<T; ++t){
+		float d = 1 + t*1.618f;
+		float g = 1.f/(t+1);
+		mt.delay(d, t); mt.gain(g, t);
+		mc.delay(d, t); mc.gain(g, t);
+	}
+	assert(mt.gain(3) == 0.25f);
+
+	const int N = 200;
+	float in[N], out[N], taps[T];
+	for(int i=0; i<N; ++i) in[i] = sin(i*0.21f);
+	mt.process(in, out, N/2);
+	mc.process(in, N/2);
+	for(int i=N/2; i<N; ++i){
+		mt.readTaps(taps);
+		float sumT = 0, sumC = 0;
+		for(unsigned t=0; t<T; ++t){
+			assert(taps[t] == mt.read(t));
+			sumT += mt.read(t) * mt.gain(t);
+			sumC += mc.read(t) * mc.gain(t);
+		}
+		assert(near(mt.readSum(), sumT, 1e-5));
+		assert(near(mc.readSum(), sumC, 1e-5));
+		mt.write(in[i]);
+		mc.write(in[i]);
+	}
+
+	// block sums agree with reading each sample, including taps that
+	// read past the wrap point and blocks longer than the buffer allows
+	// writing ahead
+	const float tapDelays[] = {1, 1.5f, 7.25f, 20, 40.9f};
+	Multitap<float, ipl::Linear, Domain1> ms(64, 5), mr(64, 5);
+	for(unsigned t=0; t<5; ++t){
+		ms.delay(tapDelays[t], t); ms.gain(0.5f - 0.2f*t, t);
+		mr.delay(tapDelays[t], t); mr.gain(0.5f - 0.2f*t, t);
+	}
+	for(int i=0; i<N; ++i) out[i] = in[i];
+	ms.process(out, 30);
+	ms.process(out+30, N-30);
+	for(int i=0; i<N; ++i){
+		assert(near(out[i], mr.readSum(), 1e-5));
+		mr.write(in[i]);
+	}
+
+	// block and per-tap output agree with reading each sample
+	Multitap<float, ipl::Linear, Domain1> ma(64, 3), mb(64, 3);
+	float frames[3*N];
+	for(unsigned t=0; t<3; ++t){ ma.delay(2+t*5.5f, t); mb.delay(2+t*5.5f, t); }
+	ma.processTaps(in, frames, N);
+	for(int i=0; i<N; ++i){
+		for(unsigned t=0; t<3; ++t) assert(frames[i*3+t] == mb.read(t));
+		mb.write(in[i]);
+	}
+}
+
+{
+	// DelayPool lines behave like separate delay lines
+	DelayPool<float> pool{5, 16, 100};
+	assert(pool.lines() == 3);
+	assert(pool.size(0) == 8 && pool.size(1) == 16 && pool.size(2) == 128);
+	for(unsigned l=0; l<3; ++l){
+		assert(uintptr_t(pool.data(l)) % 64 == 0);
+		if(l) assert(pool.data(l) >= pool.data(l-1) + pool.size(l-1));
+	}
+
+	Delay<float, ipl::Trunc, Domain1> d0(8), d1(16), d2(128);
+	d0.delaySamples(5); d1.delaySamples(16); d2.delaySamples(77);
+	const unsigned delays[] = {5, 16, 77};
+	for(int i=0; i<300; ++i){
+		float v = sin(i*0.3f), frame[3], src[3] = {v, -v, 2*v};
+		pool.read(frame, delays);
+		assert(frame[0] == d0(src[0]));
+		assert(frame[1] == d1(src[1]));
+		assert(frame[2] == d2(src[2]));
+		assert(pool.read(2, 77u) == frame[2]);
+		pool.write(src);
+		pool.advance();
+		assert(pool.read(0, 1u) == v);
+		if(i > 0) assert(near(pool.read(1, 1.25f), -0.75f*v - 0.25f*sin((i-1)*0.3f), 1e-6));
+	}
+
+	// copies keep lines aligned and hold the same samples
+	std::vector<DelayPool<float>> copies(8, pool);
+	DelayPool<float> assigned;
+	assigned = pool;
+	copies.push_back(assigned);
+	for(const auto& c : copies){
+		assert(c.pos() == pool.pos());
+		for(unsigned l=0; l<3; ++l){
+			assert(uintptr_t(c.data(l)) % 64 == 0);
+			for(unsigned d=1; d<=pool.size(l); ++d) assert(c.read(l, d) == pool.read(l, d));
+		}
+	}
+}
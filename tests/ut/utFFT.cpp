@@ -107,3 +107,484 @@
 	}
 }
 
+
+
+// instances of equal size share a plan; results must not depend on sharing
+{
+	const int N = 24;
+	RFFT<float> * ffts[4];
+	for(int k=0; k<4; ++k) ffts[k] = new RFFT<float>(k<2 ? N : N/2);
+	ffts[3]->resize(N); // acquire existing plan after construction
+
+	float ref[N];
+	for(int i=0; i<N; ++i) ref[i] = float(i%5) - 2.f;
+
+	delete ffts[0]; // other users must keep the plan alive
+
+	float res[N];
+	for(int k=1; k<4; ++k){
+		if(ffts[k]->size() != N) continue;
+		for(int i=0; i<N; ++i) res[i] = ref[i];
+		ffts[k]->forward(res);
+		ffts[k]->inverse(res);
+		for(int i=0; i<N; ++i) assert(near(res[i], ref[i], 1e-5));
+	}
+
+	for(int k=1; k<4; ++k) delete ffts[k];
+}
+
+
+// batch transforms match individual transforms
+{
+	const int N = 32, M = 7;
+	const int S = N+2; // stride with room for complex buffer format
+	float block[M*S], ref[M*S];
+	float * bufs[M];
+
+	for(int i=0; i<M*S; ++i) ref[i] = block[i] = float((i*7)%11) - 5.f;
+	for(int m=0; m<M; ++m) bufs[m] = block + m*S;
+
+	RFFT<float> rfft(N);
+	for(int threads=1; threads<=3; ++threads){
+		rfft.batchThreads(threads);
+		rfft.forwardBatch(block, M, S, true);
+		for(int m=0; m<M; ++m){
+			float r[S];
+			for(int i=0; i<S; ++i) r[i] = ref[m*S+i];
+			rfft.forward(r, true);
+			for(int i=0; i<N+2; ++i) assert(near(r[i], bufs[m][i], 1e-6));
+		}
+		rfft.inverseBatch(bufs, M, true);
+		for(int m=0; m<M; ++m){
+			for(int i=1; i<N+1; ++i) assert(near(ref[m*S+i], bufs[m][i], 1e-5));
+		}
+		for(int i=0; i<M*S; ++i) block[i] = ref[i];
+	}
+
+	CFFT<float> cfft(N/2);
+	cfft.batchThreads(4);
+	cfft.forwardBatch(bufs, M);
+	cfft.inverseBatch(block, M, S);
+	for(int m=0; m<M; ++m){
+		for(int i=0; i<N; ++i) assert(near(ref[m*S+i], bufs[m][i], 1e-5));
+	}
+
+	// workers keep scratch for the new size and handle batches smaller
+	// than the thread count
+	cfft.resize(N);
+	float big[2*2*N];
+	for(int m=0; m<2; ++m){
+		for(int i=0; i<2*N; ++i) big[m*2*N+i] = block[m*2*N+i] = float((i*5+m)%9) - 4.f;
+	}
+	cfft.forwardBatch(block, 2, 2*N);
+	cfft.batchThreads(1);
+	cfft.forward(big, true);
+	cfft.forward(big + 2*N, true);
+	for(int i=0; i<2*2*N; ++i) assert(near(big[i], block[i], 1e-5));
+}
+
+
+// Convolver matches direct convolution
+{
+	const int B = 16, L = 700, M = 1200;
+	float ir[L], in[M], out[M], ref[M];
+
+	for(int i=0; i<L; ++i) ir[i] = float((i*13)%17 - 8) / (1 + i/32);
+	for(int i=0; i<M; ++i) in[i] = float((i*7)%5 - 2);
+	for(int i=0; i<M; ++i){
+		double s = 0;
+		for(int j=0; j<L && j<=i; ++j) s += double(ir[j])*in[i-j];
+		ref[i] = s;
+	}
+
+	// uniform, non-uniform, non-uniform threaded
+	for(int k=0; k<3; ++k){
+		Convolver conv(B, ir, L, k==0 ? B : 128);
+		conv.threaded(k==2);
+		assert((conv.numLevels() == 1) == (k==0));
+		assert(conv.partitionSize(0) == B);
+
+		for(int j=0; j<2; ++j){ // second pass tests reset
+			for(int i=0; i<M; i+=B) conv.process(in+i, out+i);
+			for(int i=0; i<M; ++i) assert(near(out[i], ref[i], 1e-3));
+			conv.reset();
+		}
+	}
+
+	// With tiny blocks the worker is likely to fall behind, so the audio
+	// thread may steal jobs while the worker is computing other levels
+	{
+		Convolver conv(2, ir, L, 256);
+		conv.threaded(true);
+		for(int i=0; i<M; i+=2) conv.process(in+i, out+i);
+		for(int i=0; i<M; ++i) assert(near(out[i], ref[i], 1e-3));
+	}
+}
+
+
+// MultiSTFT matches independent STFTs
+{
+	const int N = 32, C = 3;
+	SpectralType specType[] = {COMPLEX, MAG_PHASE, MAG_FREQ};
+
+	for(int j=0; j<3; ++j){
+		MultiSTFT mstft(C, N, N/4, 0, HANN, specType[j]);
+		MultiSTFT bstft(C, N, N/4, 0, HANN, specType[j]);
+		STFT stft[C];
+		for(int c=0; c<C; ++c){
+			stft[c].resize(N, 0);
+			stft[c].sizeHop(N/4);
+			stft[c].windowType(HANN);
+			stft[c].spectrumType(specType[j]);
+		}
+
+		const int M = N*4;
+		float inB[C][M], outB[C][M];
+		float * inP[C], * outP[C];
+		for(int c=0; c<C; ++c){ inP[c] = inB[c]; outP[c] = outB[c]; }
+
+		for(int i=0; i<M; ++i){
+			float in[C], out[C];
+			for(int c=0; c<C; ++c) inB[c][i] = in[c] = cos(float(i)/N * 2*M_PI*(c+1)) + 0.1*c;
+
+			bool frame = mstft(in);
+			for(int c=0; c<C; ++c){
+				assert(stft[c](in[c]) == frame);
+				if(frame){
+					for(unsigned k=0; k<stft[c].numBins(); ++k){
+						assert(near(stft[c].bin(k)[0], mstft.bin(c,k)[0], 1e-5));
+						assert(near(stft[c].bin(k)[1], mstft.bin(c,k)[1], 1e-5));
+					}
+				}
+			}
+
+			mstft.output(out);
+			for(int c=0; c<C; ++c) assert(near(stft[c](), out[c], 1e-5));
+		}
+
+		int frames = 0;
+		bstft(inP, outP, M, [&frames](){ ++frames; });
+		assert(frames == M/(N/4));
+
+		MultiSTFT rstft(C, N, N/4, 0, HANN, specType[j]);
+		for(int i=0; i<M; ++i){
+			float in[C], out[C];
+			for(int c=0; c<C; ++c) in[c] = inB[c][i];
+			rstft(in);
+			rstft.output(out);
+			for(int c=0; c<C; ++c) assert(near(outB[c][i], out[c], 1e-6));
+		}
+	}
+}
+
+
+// STFT zero-phase rotation and zero-padding do not change resynthesis
+{
+	const int N = 32, P = 16;
+	STFT stft1(N, N/4, P, HANN, COMPLEX);
+	STFT stft2(N, N/4, P, HANN, COMPLEX);
+	stft2.rotateForward(true);
+
+	for(int i=0; i<N*6; ++i){
+		float s = cos(float(i)/N * 2*M_PI * 3) + float((i*7)%5)*0.1f;
+		bool f1 = stft1(s);
+		bool f2 = stft2(s);
+		assert(f1 == f2);
+		if(f1){
+			// rotation by half a window only changes phases
+			for(unsigned k=0; k<stft1.numBins(); ++k){
+				assert(near(stft1.bin(k).mag(), stft2.bin(k).mag(), 1e-5));
+			}
+		}
+		assert(near(stft1(), stft2(), 1e-5));
+	}
+}
+
+
+// SlidingDFT
+{
+	const int N = 16;
+	const int M = 100;
+	float x[M];
+	for(int i=0; i<M; ++i) x[i] = cos(i*0.7) + float((i*5)%3)*0.3f;
+
+	for(int j=0; j<2; ++j){
+		const float r = j ? 0.99f : 1.f;
+		SlidingDFT<float> sdft(N, 1, N/2+1, r);
+		sdft.forward(x, M/2);
+		for(int i=M/2; i<M; ++i) sdft.forward(x[i]);
+
+		// compare against direct sum
+		for(int k=1; k<=N/2; ++k){
+			Complex<double> ref(0,0);
+			for(int n=0; n<N; ++n){
+				ref += Complex<double>().fromPhase(M_2PI*k*n/N) * (x[M-1-n] * ::pow(r,n));
+			}
+			ref *= 2./N;
+			assert(near(sdft.bin(k).r, ref.r, 1e-5));
+			assert(near(sdft.bin(k).i, ref.i, 1e-5));
+		}
+
+		// refresh gives same result
+		Complex<float> b = sdft.bin(3);
+		sdft.refresh();
+		assert(near(sdft.bin(3).r, b.r, 1e-5));
+		assert(near(sdft.bin(3).i, b.i, 1e-5));
+	}
+}
+
+
+// fast spectral format conversions stay close to precise ones
+{
+	const int N = 64;
+	SpectralType specType[] = {MAG_PHASE, MAG_FREQ};
+	for(int j=0; j<2; ++j){
+		STFT stft1(N, N/4, 0, HANN, specType[j]);
+		STFT stft2(N, N/4, 0, HANN, specType[j]);
+		stft1.precise(true);
+		stft2.precise(false);
+
+		for(int i=0; i<N*8; ++i){
+			float s = cos(i*0.31) + 0.5*sin(i*1.7);
+			if(stft1(s) & stft2(s)){
+				for(unsigned k=1; k<stft1.numBins()-1; ++k){
+					float m = stft1.bin(k)[0];
+					assert(near(m, stft2.bin(k)[0], 1e-5));
+					if(m > 1e-3 && j==0){
+						assert(near(0, scl::wrapPhase(stft1.bin(k)[1] - stft2.bin(k)[1]), 1e-4));
+					}
+				}
+			}
+			assert(near(stft1(), stft2(), 1e-4));
+		}
+	}
+}
+
+
+// Spectrogram cache matches streaming STFT
+{
+	const int N = 2000;
+	const unsigned W = 64, H = 16;
+	std::vector<float> sig(N*2);
+	for(int i=0; i<N; ++i){
+		sig[2*i  ] = cos(i*0.23) + 0.3*sin(i*0.051);
+		sig[2*i+1] = 0;
+	}
+
+	const char * path = "utSpectrogram.gspc";
+	const char * pathHalf = "utSpectrogramHalf.gspc";
+	SpectralType specType[] = {MAG_PHASE, MAG_FREQ};
+
+	for(int j=0; j<2; ++j){
+		SpectrogramAnalyzer ana(W, H, W, HANN, specType[j]);
+		ana.threads(3);
+		assert(ana.analyze(path, &sig[0], N, 1000, 2)); // left channel only
+
+		SpectrogramFile file(path);
+		assert(file.opened());
+		assert(file.numFrames() == ana.numFrames(N));
+		assert(file.numFrames() == (N+W)/H - 1);
+		assert(file.numBins() == W+1);
+		assert(file.sizeWin() == W && file.sizeHop() == H && file.sizePad() == W);
+		assert(file.spectralType() == specType[j]);
+		assert(file.sampleRate() == 1000);
+
+		Domain dom(1000);
+		STFT stft(W, H, W, HANN, specType[j]);
+		stft.domain(dom);
+		std::vector<Complex<float>> bins(file.numBins());
+
+		uint64_t frame = 0;
+		for(unsigned i=0; i<N+W-1; ++i){
+			if(stft(i<N ? sig[2*i] : 0.f)){
+				assert(frame < file.numFrames());
+				file.frame(&bins[0], frame++);
+				for(unsigned k=0; k<stft.numBins(); ++k){
+					assert(bins[k][0] == stft.bin(k)[0]);
+					assert(bins[k][1] == stft.bin(k)[1]);
+				}
+			}
+		}
+		assert(frame == file.numFrames());
+
+		// Half-precision values round to within 2^-11 relative
+		ana.sampleFormat(SpectrogramFile::FLOAT16);
+		assert(ana.analyze(pathHalf, &sig[0], N, 1000, 2));
+		SpectrogramFile half(pathHalf);
+		assert(half.sampleFormat() == SpectrogramFile::FLOAT16);
+		assert(half.sizeFrame()*2 == file.sizeFrame());
+		for(unsigned f=0; f<half.numFrames(); f+=7){
+			std::vector<Complex<float>> b32(file.numBins()), b16(file.numBins());
+			file.frame(&b32[0], f);
+			half.frame(&b16[0], f);
+			for(unsigned k=0; k<file.numBins(); ++k){
+				for(int c=0; c<2; ++c){
+					assert(near(b32[k][c], b16[k][c], scl::abs(b32[k][c])/2048 + 1e-7));
+				}
+			}
+		}
+
+		// Decode into STFT for resynthesis
+		assert(half.frame(stft, 0));
+		STFT wrongSize(W, H);
+		assert(!half.frame(wrongSize, 0));
+
+		// Frames past the end are not read
+		std::vector<Complex<float>> past(file.numBins());
+		assert(!file.frame(&past[0], file.numFrames()));
+		assert(!file.frameData(file.numFrames()));
+		assert(!half.frame(stft, half.numFrames()));
+	}
+
+	remove(path);
+	remove(pathHalf);
+	SpectrogramFile missing(path);
+	assert(!missing.opened());
+	Complex<float> bin;
+	assert(!missing.frameData(0) && !missing.frame(&bin, 0));
+}
+
+
+// CQT
+{
+	Domain dom(8000);
+	CQT cqt(110, 4, 12);
+	cqt.domain(dom);
+
+	assert(cqt.numBins() == 48);
+	assert(near(cqt.binFreq(12), 220));
+
+	// A sinusoid at a bin's center frequency gives it a magnitude of A/2
+	for(unsigned k : {3u, 20u, 45u}){
+		cqt.reset();
+		double f = cqt.binFreq(k) / 8000;
+		unsigned frames = 0;
+		for(int i=0; i<20000; ++i){
+			if(cqt(0.8*cos(M_2PI*f*i))){
+				++frames;
+				assert(cqt.binsUpdatedFrom() == (cqt.numOctaves() - cqt.octavesUpdated())*12);
+			}
+		}
+		assert(frames == 20000/cqt.sizeHop());
+		assert(near(cqt.bin(k).mag(), 0.4, 1e-3));
+		assert(cqt.bin(k-1).mag() < 0.3 && cqt.bin(k+1).mag() < 0.3);
+	}
+
+	// Frame centers of all octaves are at the same time
+	{
+		cqt.reset();
+		unsigned period = cqt.sizeHop() << (cqt.numOctaves()-1);
+		unsigned end = (cqt.latency() / period + 1) * period;
+		unsigned center = end - cqt.latency();
+		for(unsigned i=0; i<end; ++i) cqt(i == center ? 1.f : 0.f);
+		assert(cqt.octavesUpdated() == cqt.numOctaves());
+		for(unsigned k=0; k<cqt.numBins(); ++k){
+			// an impulse at the center has zero phase in every bin
+			assert(cqt.bin(k).mag() > 1e-4);
+			assert(near(cqt.bin(k).arg(), 0, 1e-3));
+		}
+	}
+
+	// Resynthesis within the analyzed range
+	for(double gamma : {0., 30.}){
+		cqt.resize(110, 4, 12, 0, 1, gamma);
+		unsigned L = cqt.latencyInverse();
+		double err = 0, pow = 0;
+		for(unsigned i=0; i<L+8000; ++i){
+			auto x = [](int n){
+				return n < 0 ? 0 : 0.5*cos(M_2PI*150./8000*n) + 0.3*sin(M_2PI*1100./8000*n);
+			};
+			if(cqt(x(i))) cqt.inverse();
+			float y = cqt();
+			if(i >= L+4000){
+				err += (y - x(i-L))*(y - x(i-L));
+				pow += x(i-L)*x(i-L);
+			}
+		}
+		assert(err < pow*1e-4); // -40 dB
+	}
+}
+
+
+// GoertzelBank
+{
+	Domain dom(1000);
+	const unsigned N = 100, H = 40;
+	GoertzelBank<double> gb(3, N, H, HANN);
+	gb.domain(dom);
+	double freqs[] = {50, 123.4, 250};
+	gb.freqs(freqs);
+	assert(gb.numFreqs() == 3 && gb.sizeWin() == N && gb.sizeHop() == H);
+
+	std::vector<double> win(N);
+	tbl::window(&win[0], N, HANN);
+	double winSum = 0;
+	for(auto v : win) winSum += v;
+
+	auto x = [](int n){ return cos(0.3*n) + 0.5*sin(M_2PI*123.4/1000*n + 1); };
+
+	// compare each completed window against a direct DFT sum
+	std::vector<double> sig(600);
+	for(unsigned i=0; i<sig.size(); ++i) sig[i] = x(i);
+
+	unsigned windows = 0;
+	gb(&sig[0], sig.size(), [&](){
+		unsigned start = windows++ * H;
+		for(unsigned k=0; k<gb.numFreqs(); ++k){
+			Complex<double> X(0);
+			for(unsigned n=0; n<N; ++n){
+				double p = -M_2PI*freqs[k]/1000*n;
+				X += Complex<double>(cos(p), sin(p)) * (sig[start+n]*win[n]);
+			}
+			X /= winSum;
+			assert(near(gb.bin(k).r, X.r, 1e-9) && near(gb.bin(k).i, X.i, 1e-9));
+		}
+	});
+	assert(windows == (sig.size()-N)/H + 1);
+
+	// sinusoid at an analyzed frequency gives half its amplitude
+	assert(near(gb.mag(1), 0.25, 0.01));
+
+	// frequencies follow the domain
+	dom.spu(2000);
+	assert(gb.freq(1) == 123.4);
+	gb.reset();
+	for(unsigned i=0; i<N; ++i) gb(0.5*sin(M_2PI*123.4/2000*i));
+	assert(near(gb.mag(1), 0.25, 0.01));
+}
+
+
+// PitchTrack
+{
+	Domain dom(48000);
+	const unsigned W = 2048, H = 512;
+
+	for(int m=0; m<2; ++m){
+		PitchTrack<float> pt(W, H, m ? PitchTrack<float>::YIN : PitchTrack<float>::MPM);
+		pt.domain(dom);
+		pt.range(50, 1000);
+
+		// harmonic tones with a weak fundamental
+		double f0s[] = {82.4, 196, 440.7, 987.8};
+		for(double f0 : f0s){
+			pt.reset();
+			for(unsigned i=0; i<W+H; ++i){
+				double p = M_2PI*f0/48000*i;
+				pt(float(0.3*sin(p) + 0.5*sin(2*p+1) + 0.4*sin(3*p+2) + 0.2*sin(5*p)));
+			}
+			assert(near(pt.freq(), f0, f0*1e-3));
+			assert(pt.confidence() > 0.9f);
+		}
+
+		// noise has low confidence
+		pt.reset();
+		RNGTaus rng(123);
+		unsigned estimates = 0;
+		float conf = 0;
+		for(unsigned i=0; i<W*4; ++i){
+			if(pt(rnd::uniS_float(rng))){ ++estimates; conf = pt.confidence(); }
+		}
+		assert(estimates == W*4/H);
+		assert(conf < 0.6f);
+	}
+}
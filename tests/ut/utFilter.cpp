@@ -4,6 +4,528 @@
 		
 }
 
+{
+	// lanes match individual biquads
+	const unsigned N = 5;
+	BiquadBank<N, float, float, Domain1> bank;
+	Biquad<float, float, Domain1> fils[N];
+	FilterType types[N] = {LOW_PASS, HIGH_PASS, BAND_PASS, PEAKING, LOW_SHELF};
+	for(unsigned i=0; i<N; ++i){
+		fils[i].set(0.01f + 0.05f*i, 0.5f + i, types[i]);
+		fils[i].level(2);
+		bank.set(i, fils[i].freq(), fils[i].res(), types[i]);
+		bank.level(i, 2);
+	}
+
+	float frames[8][N], outs[8][N];
+	for(unsigned n=0; n<8; ++n)
+		for(unsigned i=0; i<N; ++i) frames[n][i] = (n==0) + 0.1f*i*n;
+
+	bank.process(frames[0], outs[0], 4);
+	for(unsigned n=4; n<8; ++n) bank(frames[n], outs[n]);
+
+	for(unsigned n=0; n<8; ++n)
+		for(unsigned i=0; i<N; ++i) assert(near(outs[n][i], fils[i](frames[n][i]), 1e-6));
+
+	// same input through all lanes
+	bank.zero();
+	for(auto& f : fils) f.zero();
+	float in[8];
+	for(unsigned n=0; n<8; ++n) in[n] = frames[n][1];
+	bank.processBank(in, outs[0], 8);
+	for(unsigned n=0; n<8; ++n)
+		for(unsigned i=0; i<N; ++i) assert(near(outs[n][i], fils[i](in[n]), 1e-6));
+}
+
+{
+	// block processing matches per-sample processing when parameters are
+	// constant
+	float in[64], out[64];
+	for(int i=0; i<64; ++i) in[i] = (i==0) + 0.3f*sin(i*0.7f);
+
+	auto check = [&](auto& blk, auto& smp){
+		blk.process(in, out, 30);
+		blk.process(in+30, out+30, 34);
+		for(int i=0; i<64; ++i) assert(near(out[i], smp(in[i]), 1e-6));
+	};
+
+	{ Biquad<float,float,Domain1> a(0.1, 2, BAND_REJECT), b = a; check(a, b); }
+	{ OnePole<float,float,Domain1> a(0.05), b = a; check(a, b); }
+	{ AllPass1<float,float,Domain1> a(0.2), b = a; check(a, b); }
+	{ AllPass2<float,float,Domain1> a(0.2, 0.05), b = a; check(a, b); }
+	{ Notch<float,float,Domain1> a(0.2, 0.05), b = a; check(a, b); }
+	{ Reson<float,float,Domain1> a(0.2, 0.05), b = a; check(a, b); }
+	{ BlockDC<float,float,Domain1> a(0.01), b = a; check(a, b); }
+	{ BlockNyq<float,float,Domain1> a(0.01), b = a; check(a, b); }
+	{ Integrator<float,float> a(0.9), b = a; check(a, b); }
+
+	// coefficients ramp linearly from those of the previous block
+	Biquad<float,float,Domain1> blk(0.05, 1), ref = blk;
+	blk.process(in, out, 32);
+	for(int i=0; i<32; ++i) ref(in[i]);
+
+	Biquad<float,float,Domain1> c0 = blk;
+	blk.freq(0.2);
+	Biquad<float,float,Domain1> c1 = blk;
+	blk.process(in, out, 32);
+	for(int i=0; i<32; ++i){
+		float f = (i+1)/32.f;
+		auto lerp = [f](float a, float b){ return a + (b-a)*f; };
+		ref.coef(
+			lerp(c0.a()[0], c1.a()[0]), lerp(c0.a()[1], c1.a()[1]),
+			lerp(c0.a()[2], c1.a()[2]), lerp(c0.b()[1], c1.b()[1]),
+			lerp(c0.b()[2], c1.b()[2])
+		);
+		assert(near(out[i], ref(in[i]), 1e-5));
+	}
+	for(int k=0; k<3; ++k) assert(ref.a()[k] == c1.a()[k]);
+}
+
+{
+	// precise coefficients match exact formulas; default ones are close
+	Biquad<double,double,Domain1> bq(0.3, 1, ALL_PASS);
+	Biquad<double,double,Domain1> bqp = bq;
+	bqp.precise(true);
+	assert(bqp.precise() && !bq.precise());
+	double alpha = sin(M_2PI*0.3) * 0.5;
+	assert(near(bqp.b()[1], -2*cos(M_2PI*0.3)/(1+alpha), 1e-12));
+	assert(near(bqp.b()[2], (1-alpha)/(1+alpha), 1e-12));
+	for(int k=1; k<3; ++k) assert(near(bq.b()[k], bqp.b()[k], 2e-4));
+
+	// first output of impulse response is the gain
+	double r = exp(-M_PI*0.01);
+	Reson<double,double,Domain1> rs(0.1, 0.01), rsp = rs;
+	rsp.precise(true);
+	assert(near(rsp(1), (1 - r*r)*sin(M_2PI*0.1), 1e-12));
+	assert(near(rs(1), (1 - r*r)*sin(M_2PI*0.1), 0.02*(1 - r*r)));
+	Notch<double,double,Domain1> nt(0.1, 0.01), ntp = nt;
+	ntp.precise(true);
+	assert(near(ntp(1), 1/(1 + 2*r*cos(M_2PI*0.1) + r*r), 1e-12));
+	assert(near(nt(1), 1/(1 + 2*r*cos(M_2PI*0.1) + r*r), 1e-6));
+
+	OnePole<double,double,Domain1> op(0.2), opp = op;
+	opp.precise(true);
+	// exact low-pass is -3 dB at cutoff
+	double a0 = opp(1), b1 = opp(0)/a0;
+	double re = cos(M_2PI*0.2), im = -sin(M_2PI*0.2);
+	double den = (1 - b1*re)*(1 - b1*re) + b1*im*b1*im;
+	assert(near(a0*a0/den, 0.5, 1e-12));
+}
+
+{
+	// IIRDesign: band edges and ripple of each family
+	auto mag = [](const IIRDesign& d, double f){
+		IIRCascade<double,double,Domain1> c(d);
+		return std::abs(c.response(f));
+	};
+	auto dB = [](double m){ return 20*log10(m); };
+
+	for(unsigned N=1; N<=9; ++N){
+		IIRDesign d(BUTTERWORTH, LOW_PASS, N, 0.1);
+		assert(d.sections().size() == (N+1)/2);
+		assert(near(mag(d, 0), 1, 1e-9));
+		assert(near(dB(mag(d, 0.1)), -3.0103, 1e-4));
+		// |H|^2 = 1 / (1 + (tan(pi f) / tan(pi fc))^2N)
+		double r = pow(tan(M_PI*0.2)/tan(M_PI*0.1), 2*N);
+		assert(near(mag(d, 0.2), 1/sqrt(1 + r), 1e-9));
+
+		d.type(HIGH_PASS);
+		assert(near(mag(d, 0.5), 1, 1e-9));
+		assert(near(dB(mag(d, 0.1)), -3.0103, 1e-4));
+
+		d.family(CHEBYSHEV1).type(LOW_PASS).ripple(0.5);
+		assert(near(dB(mag(d, 0.1)), -0.5, 1e-6));
+		for(double f=0; f<0.1; f+=0.001) assert(dB(mag(d, f)) > -0.5 - 1e-6);
+
+		d.family(CHEBYSHEV2).attenuation(50);
+		assert(near(dB(mag(d, 0.1)), -50, 1e-6));
+		for(double f=0.1; f<0.5; f+=0.001) assert(dB(mag(d, f)) < -50 + 1e-6);
+
+		d.family(ELLIPTIC).ripple(0.5).attenuation(50);
+		assert(near(dB(mag(d, 0.1)), -0.5, 1e-6));
+		for(double f=0; f<0.1; f+=0.001) assert(dB(mag(d, f)) > -0.5 - 1e-6);
+		for(double f=0; f<0.5; f+=0.001) assert(dB(mag(d, f)) < 1e-6);
+		// stopband is equiripple at the attenuation
+		double fs = 0.1;
+		while(dB(mag(d, fs)) > -50) fs += 0.0001;
+		for(double f=fs; f<0.5; f+=0.001) assert(dB(mag(d, f)) < -50 + 1e-6);
+	}
+
+	// band types
+	IIRDesign bp(BUTTERWORTH, BAND_PASS, 3);
+	bp.freq(0.1, 0.2);
+	assert(bp.sections().size() == 3);
+	assert(near(dB(mag(bp, 0.1)), -3.0103, 1e-4));
+	assert(near(dB(mag(bp, 0.2)), -3.0103, 1e-4));
+	bp.type(BAND_REJECT);
+	assert(near(mag(bp, 0), 1, 1e-9) && near(mag(bp, 0.5), 1, 1e-9));
+	assert(near(dB(mag(bp, 0.1)), -3.0103, 1e-4));
+
+	// Linkwitz-Riley low and high pass sum to an all-pass
+	for(unsigned order=2; order<=8; order+=2){
+		IIRDesign lr(LINKWITZ_RILEY, LOW_PASS, order, 0.1);
+		IIRCascade<double,double,Domain1> lp(lr), hp(lr.type(HIGH_PASS));
+		for(double f=0.01; f<0.5; f+=0.01) assert(near(std::abs(lp.response(f) + hp.response(f)), 1, 1e-9));
+		assert(near(std::abs(lp.response(0.1)), 0.5, 1e-9));
+		assert(near(std::abs(hp.response(0.1)), 0.5, 1e-9));
+	}
+	IIRDesign lr(LINKWITZ_RILEY, HIGH_PASS, 4, 0.1);
+	IIRCascade<double,double,Domain1> hp(lr);
+
+	// expanded transfer function agrees with the cascade
+	TransferFunc tf = lr.transferFunc();
+	for(double f=0.01; f<0.5; f+=0.05) assert(near(std::abs(tf(f)), std::abs(hp.response(f)), 1e-9));
+
+	// frequencies follow the domain
+	Domain dom(48000);
+	IIRCascade<float,float> dc(IIRDesign(ELLIPTIC, LOW_PASS, 5, 4800));
+	dc.domain(dom);
+	assert(near(dB(std::abs(dc.response(4800))), -1, 1e-4));
+	dom.spu(96000);
+	assert(near(dB(std::abs(dc.response(4800))), -1, 1e-4));
+
+	// block processing matches sample processing and separate biquads
+	for(unsigned N=1; N<=16; ++N){
+		IIRCascade<float,float,Domain1> blk(IIRDesign(ELLIPTIC, LOW_PASS, N, 0.1)), smp = blk;
+		std::vector<Biquad<float,float,Domain1>> bqs(blk.numSections());
+		for(unsigned i=0; i<bqs.size(); ++i) blk.section(i).to(bqs[i]);
+
+		float buf[100];
+		for(int i=0; i<100; ++i) buf[i] = (i==0) + sin(i*0.3f);
+		float in[100];
+		for(int i=0; i<100; ++i) in[i] = buf[i];
+		blk.process(buf, 1);
+		blk.process(buf+1, 2);
+		blk.process(buf+3, 97);
+		for(int i=0; i<100; ++i){
+			float v = in[i];
+			for(auto& b : bqs) v = b(v);
+			assert(near(buf[i], smp(in[i]), 1e-6));
+			assert(near(buf[i], v, 1e-6));
+		}
+	}
+}
+
+{
+	// windowed-sinc lowpass: symmetric, unit DC gain, deep stopband
+	const unsigned L = 129;
+	double h[L];
+	firLowpass(h, L, 0.1);
+	double sum = 0;
+	for(unsigned i=0; i<L; ++i){
+		assert(near(h[i], h[L-1-i], 1e-12));
+		sum += h[i];
+	}
+	assert(near(sum, 1, 1e-12));
+
+	auto mag = [&](double f){
+		std::complex<double> r = 0;
+		for(unsigned i=0; i<L; ++i) r += h[i] * std::polar(1., -M_2PI*f*i);
+		return std::abs(r);
+	};
+	for(double f=0; f<0.06; f+=0.005) assert(near(mag(f), 1, 1e-4));
+	assert(near(mag(0.1), 0.5, 1e-3));
+	for(double f=0.14; f<0.5; f+=0.003) assert(20*log10(mag(f)) < -90);
+
+	// sample and block processing give the direct convolution
+	float hf[L];
+	for(unsigned i=0; i<L; ++i) hf[i] = h[i];
+	FIR<float,float> fir(hf, L), blk = fir;
+	assert(fir.size() == L && fir.delay() == 64);
+
+	// a filter without coefficients outputs zeros
+	FIR<float,float> none;
+	float io[3] = {1, 2, 3};
+	none.process(io, 3);
+	assert(none(1) == 0 && io[0] == 0 && io[2] == 0);
+	none.coefs(hf, 0);
+	assert(none.size() == 0 && none(1) == 0);
+	const int N = 400;
+	float in[N], out[N];
+	for(int i=0; i<N; ++i) in[i] = (i==0) + sin(i*0.3f) + 0.5f*sin(i*2.1f);
+	blk.process(in, out, 5);
+	blk.process(in+5, out+5, N-5);
+	for(int i=0; i<N; ++i){
+		double y = 0;
+		for(int k=0; k<int(L) && k<=i; ++k) y += hf[k]*in[i-k];
+		assert(near(fir(in[i]), y, 1e-5));
+		assert(near(out[i], y, 1e-5));
+	}
+
+	// decimator computes every factor-th filter output
+	for(unsigned M=1; M<=4; ++M){
+		FIRDecimator<float,float> dec;
+		dec.coefs(hf, L, M);
+		FIR<float,float> ref(hf, L);
+		float dout[N];
+		unsigned no = dec.process(in, dout, 7);
+		no += dec.process(in+7, dout+no, N-7);
+		assert(no == N/M);
+		for(int i=0; i<N; ++i){
+			float y = ref(in[i]);
+			if(i%M == M-1) assert(near(dout[i/M], y, 1e-6));
+		}
+	}
+
+	// interpolator filters zero-stuffed input with gain
+	for(unsigned M=1; M<=4; ++M){
+		FIRInterpolator<float,float> itp;
+		itp.coefs(hf, L, M);
+		FIR<float,float> ref(hf, L);
+		std::vector<float> iout(N*M);
+		itp.process(in, &iout[0], 3);
+		itp.process(in+3, &iout[3*M], N-3);
+		for(unsigned i=0; i<N*M; ++i){
+			float y = M * ref(i%M ? 0.f : in[i/M]);
+			assert(near(iout[i], y, 2e-5));
+		}
+	}
+
+	// default designs reject images and aliases
+	FIRInterpolator<double,double> up(4);
+	FIRDecimator<double,double> down(4);
+	assert(up.size() == 129 && down.factor() == 4);
+	double pow = 0;
+	for(int i=0; i<4000; ++i){
+		double o[4];
+		up(o, sin(M_2PI*0.05*i));
+		for(int p=0; p<4; ++p){
+			if(down(o[p]) && i>=200) pow += down.value()*down.value();
+		}
+	}
+	assert(near(sqrt(pow/3800*2), 1, 1e-4));
+	double peak = 0;
+	down.zero();
+	for(int i=0; i<4000; ++i){
+		// alias of 0.2 at the output rate
+		if(down(sin(M_2PI*0.2*i)) && i>200) peak = std::max(peak, std::abs(down.value()));
+	}
+	assert(20*log10(peak) < -90);
+}
+
+{
+	// shared tables
+	auto tab = SincTable::get(SincTable::HIGH);
+	assert(tab == SincTable::get(SincTable::HIGH));
+	assert(tab->taps() == 64 && tab->span() == 64 && tab->span(0.5) == 128);
+	assert(near(tab->passband(), 0.4167, 1e-3));
+	std::vector<float> c(tab->span(0.4));
+	for(double f : {0., 0.25, 0.7}){
+		tab->coefs(&c[0], f);
+		double sum = 0;
+		for(unsigned k=0; k<tab->span(); ++k) sum += c[k];
+		assert(near(sum, 1, 1e-6));
+		tab->coefs(&c[0], f, 0.4);
+		sum = 0;
+		for(unsigned k=0; k<tab->span(0.4); ++k) sum += c[k];
+		assert(near(sum, 1, 1e-4));
+		// kernel is symmetric about the interpolated position
+		assert(near(tab->at(0.3+f), tab->at(-0.3-f), 1e-6));
+	}
+
+	// a tone in the passband is interpolated accurately at any ratio, and
+	// block sizes do not matter
+	auto tone = [](double f, double t){ return sin(M_2PI*f*t + 0.3); };
+	for(double r : {0.37, 44100./48000, 1., 48000./44100, 2.5}){
+		for(auto q : {SincTable::MEDIUM, SincTable::HIGH, SincTable::BEST}){
+			Resampler<float> rs(r, q);
+			double f = 0.3 * scl::min(1., 1./r);	// below passband edges
+			const int N = 4000;
+			std::vector<float> in(N), out(N/r + 2);
+			for(int i=0; i<N; ++i) in[i] = tone(f, i);
+			unsigned no = 0, i = 0, blk = 1;
+			while(i < N){
+				unsigned n = scl::min(blk, N-i);
+				no += rs.process(&in[i], n, &out[no], out.size()-no);
+				i += n; blk = blk*3 % 97 + 1;
+			}
+			assert(no == unsigned(std::ceil((N - rs.latency())/r)));
+			double err = 0;
+			for(unsigned m=rs.span()/r; m<no-rs.span()/r; ++m){
+				err = scl::max(err, scl::abs(out[m] - tone(f, m*r)));
+			}
+			double tol = q==SincTable::MEDIUM ? 1e-3 : 2e-5;
+			assert(err < tol);
+		}
+	}
+
+	// downsampling rejects tones above the output Nyquist
+	{
+		Resampler<double> rs(2.5);
+		const int N = 10000;
+		std::vector<double> in(N), out(N);
+		for(int i=0; i<N; ++i) in[i] = sin(M_2PI*0.3*i);
+		unsigned no = rs.process(&in[0], N, &out[0], N);
+		double peak = 0;
+		for(unsigned m=100; m<no-100; ++m) peak = scl::max(peak, scl::abs(out[m]));
+		assert(20*log10(peak) < -100);
+	}
+
+	// variable ratio follows the accumulated position
+	{
+		Resampler<float> rs(0.5);
+		rs.maxRatio(1.1);
+		double t = 0, f = 0.05;
+		std::vector<double> pos;
+		float in[64], out[256];
+		unsigned i = 0;
+		double err = 0;
+		for(int b=0; b<100; ++b){
+			for(int k=0; k<64; ++k, ++i) in[k] = tone(f, i);
+			rs.ratio(0.8 + 0.3*sin(b*0.1));
+			// outputs produced with the ratio in effect at their time
+			unsigned no = rs.process(in, 64, out, 256);
+			for(unsigned m=0; m<no; ++m){
+				if(pos.size() > 100) err = scl::max(err, scl::abs(out[m] - tone(f, t)));
+				pos.push_back(t);
+				t += rs.ratio();
+			}
+		}
+		assert(err < 1e-4);
+	}
+
+	// interpolation strategy
+	{
+		const int N = 256;
+		ArrayPow2<float> a(N);
+		float s[N];
+		for(int i=0; i<N; ++i) a[i] = s[i] = cos(M_2PI*5./N*i);
+		ipl::Sinc<float> ip(SincTable::HIGH);
+		assert(ip.type() == ipl::SINC && ipl::SINC != ipl::ALLPASS);
+		for(double x=0; x<N; x+=3.7){
+			double y = cos(M_2PI*5./N*x);
+			assert(near(ip(a, uint32_t(x/N * 4294967296.)), y, 1e-5));
+			assert(near(ip(s, int(x), x-int(x), N-1), y, 1e-5));
+		}
+
+		Array<float> arr(s, N);
+		SamplePlayer<float, ipl::Sinc, phsInc::Loop> p(arr, 1);
+		p.ipol().ratio(1.5);
+		p.rate(1.5);
+		assert(near(p(), 1, 2e-4));
+	}
+}
+
+{
+	// halfband stages: interpolating then decimating a tone delays it
+	HalfbandInterpolator<double,double> up(8);
+	HalfbandDecimator<double,double> down(8);
+	assert(up.size() == 31 && up.delay() == 15 && down.delay() == 15);
+	double err = 0;
+	for(int i=0; i<400; ++i){
+		double a, b;
+		up(a, b, sin(0.3*i));
+		double y = down(a, b);
+		if(i > 40) err = scl::max(err, scl::abs(y - sin(0.3*(i-15))));
+	}
+	assert(err < 1e-3);
+
+	// oversampled identity is a pure delay in the passband
+	auto ident = [](double x){ return x; };
+	auto checkDelay = [&](auto& os){
+		double err = 0;
+		double L = os.latency();
+		for(int i=0; i<600; ++i){
+			double y = os(sin(0.9*i));
+			if(i > 200) err = scl::max(err, scl::abs(y - sin(0.9*(i-L))));
+		}
+		return err;
+	};
+	Oversample<2, decltype(ident), double> os2(ident);
+	Oversample<4, decltype(ident), double> os4(ident);
+	Oversample<8, decltype(ident), double> os8(ident);
+	assert(os2.latency() == 39 && os4.latency() == 45.5 && os8.latency() == 48.25);
+	assert(checkDelay(os2) < 1e-4);
+	assert(checkDelay(os4) < 1e-4);
+	assert(checkDelay(os8) < 1e-4);
+
+	// a cubic nonlinearity's third harmonic is removed instead of aliased
+	auto cube = [](double x){ return x*x*x; };
+	auto level = [](const std::vector<double>& v, double w){
+		std::complex<double> s = 0;
+		for(unsigned i=0; i<v.size(); ++i) s += v[i]*std::polar(1., -w*i);
+		return 2.*std::abs(s)/v.size();
+	};
+	const double w = M_2PI*0.3;	// harmonic at 0.9 aliases to 0.1
+	const int N = 4000;
+	std::vector<double> in(N), out(N), ref(N);
+	for(int i=0; i<N; ++i) in[i] = sin(w*i);
+	for(int i=0; i<N; ++i) ref[i] = cube(in[i]);
+	Oversample<2, decltype(cube), double> osc(cube);
+	osc.process(&in[0], &out[0], N);
+	std::vector<double> tail(out.begin()+1000, out.end()), reft(ref.begin()+1000, ref.end());
+	assert(near(level(reft, M_2PI*0.1), 0.25, 1e-3));
+	assert(near(level(tail, w), 0.75, 1e-3));
+	assert(level(tail, M_2PI*0.1) < 1e-4);
+
+	// block and sample processing agree
+	Oversample<4, decltype(cube), float> ob(cube), os(cube);
+	float buf[300];
+	for(int i=0; i<300; ++i) buf[i] = sin(i*0.2f);
+	float ins[300];
+	for(int i=0; i<300; ++i) ins[i] = buf[i];
+	ob.process(buf, 100);
+	ob.process(buf+100, 200);
+	for(int i=0; i<300; ++i) assert(near(buf[i], os(ins[i]), 1e-6));
+}
+
+{
+	// Hilbert: real and imaginary parts are in quadrature at any rate
+	const double rates[] = {44100, 96000, 192000};
+	for(double sr : rates){
+		Domain dom(sr);
+		Hilbert<double,double> hil;
+		hil.domain(dom);
+		const double freqs[] = {100, 1000, 10000};
+		for(double f : freqs){
+			hil.zero();
+			double lo = 2, hi = 0;
+			for(int i=0; i<int(sr/5); ++i){
+				Complex<double> c = hil(sin(M_2PI*f/sr*i));
+				if(i > sr/10){
+					lo = scl::min(lo, c.mag());
+					hi = scl::max(hi, c.mag());
+				}
+			}
+			assert(lo > 0.99 && hi < 1.01);
+		}
+	}
+
+	// a normalized domain is treated as 44.1 kHz
+	{
+		Domain dom(44100);
+		Hilbert<double,double> h44;
+		h44.domain(dom);
+		Hilbert<double,double,Domain1> hn;
+		for(int i=0; i<500; ++i){
+			double x = sin(i*0.05) + 0.3*sin(i*1.1);
+			Complex<double> a = h44(x), b = hn(x);
+			assert(a.r == b.r && a.i == b.i);
+		}
+	}
+
+	// block and sample processing agree
+	Hilbert<float,float> h1, h2;
+	float in[200], re[200], im[200];
+	Complex<float> cs[200];
+	for(int i=0; i<200; ++i) in[i] = sin(i*0.1f) + 0.5f*sin(i*0.73f);
+	h1.process(in, re, im, 200);
+	h2.process(in, cs, 200);
+	h1.zero();
+	for(int i=0; i<200; ++i){
+		Complex<float> c = h1(in[i]);
+		assert(c.r == re[i] && c.i == im[i]);
+		assert(cs[i].r == re[i] && cs[i].i == im[i]);
+	}
+
+	// FreqShift block and sample processing agree
+	FreqShift<float> fs1(500), fs2(500);
+	for(int i=0; i<200; ++i) re[i] = in[i];
+	fs1.process(re, 100);
+	fs1.process(re+100, 100);
+	for(int i=0; i<200; ++i) assert(near(re[i], fs2(in[i]), 1e-6));
+}
+
 {
 	MovingAvg<> fil(4);
 	assert(near(fil(1), 0.25));
@@ -0,0 +1,169 @@
+{
+	// FDN reverb decays by 60 dB over its decay length
+	auto level = [](const std::vector<double>& v, unsigned beg, unsigned len){
+		double e = 0;
+		for(unsigned i=beg; i<beg+len; ++i) e += v[i]*v[i];
+		return 10*log10(e/len);
+	};
+	const unsigned T60 = 20000;
+	const FeedbackMatrix matrices[] = {HADAMARD, HOUSEHOLDER};
+	for(auto m : matrices){
+		FDNReverb<8, double, Domain1> rev(T60, 0);
+		rev.matrix(m);
+		std::vector<double> ir(T60 + 8000);
+		for(unsigned i=0; i<ir.size(); ++i) ir[i] = rev(i==0 ? 1. : 0.);
+		double drop = level(ir, 6000, 2000) - level(ir, T60 + 6000, 2000);
+		assert(near(drop, 60, 3));
+	}
+
+	// damping shortens the decay of high frequencies but not of low ones
+	const float dampings[] = {0, 0.6};
+	for(float d : dampings){
+		FDNReverb<8, double, Domain1> rev(T60, d);
+		Biquad<double,double,Domain1> lp(0.01, 0.707, LOW_PASS), hp(0.3, 0.707, HIGH_PASS);
+		std::vector<double> lo(T60/2 + 8000), hi(lo.size());
+		for(unsigned i=0; i<lo.size(); ++i){
+			double y = rev(i==0 ? 1. : 0.);
+			lo[i] = lp(y);
+			hi[i] = hp(y);
+		}
+		double dropLo = level(lo, 6000, 2000) - level(lo, T60/2 + 6000, 2000);
+		double dropHi = level(hi, 6000, 2000) - level(hi, T60/2 + 6000, 2000);
+		assert(near(dropLo, 30, 3));
+		if(d == 0)	assert(near(dropHi, dropLo, 3));
+		else		assert(dropHi > dropLo + 15);
+	}
+
+	// modulated lines still decay by 60 dB over the decay length
+	FDNReverb<16, double, Domain1> mod(T60, 0);
+	mod.modulate(6, 0.001);
+	std::vector<double> ir(T60 + 8000);
+	for(unsigned i=0; i<ir.size(); ++i) ir[i] = mod(i==0 ? 1. : 0.);
+	assert(near(level(ir, 6000, 2000) - level(ir, T60 + 6000, 2000), 60, 5));
+}
+
+{
+	// ReverbMS comb lanes match a network of separate Echos and Combs
+	Domain dom(1);	// decay in samples
+	ReverbMS<float, Loop1P, ipl::Trunc> rev;
+	rev.domain(dom);
+	rev.resize({1116, 1188, 1277, 1356}, {556, 225});
+	rev.decay(30000).damping(0.3);
+	assert(rev.combs() == 4 && rev.combDelay(2) == 1277);
+
+	const unsigned cd[] = {1116, 1188, 1277, 1356}, ad[] = {556, 225};
+	Echo<float, ipl::Trunc, Loop1P, Domain1> echos[4];
+	Comb<float, ipl::Trunc, float, Domain1> aps[2];
+	for(int i=0; i<4; ++i){
+		echos[i].maxDelay(cd[i]); echos[i].delay(cd[i]);
+		echos[i].decay(30000); echos[i].damping(0.3);
+	}
+	for(int i=0; i<2; ++i){
+		aps[i].maxDelay(ad[i]); aps[i].delay(ad[i]); aps[i].allPass(0.71);
+	}
+
+	const int N = 6000;
+	std::vector<float> in(N), out(N);
+	for(int i=0; i<N; ++i) in[i] = (i%1500 == 0) ? 1.f : 0.f;
+	ReverbMS<float, Loop1P, ipl::Trunc> blk = rev;
+	for(int i=0; i<N; ++i){
+		float x = in[i];
+		for(auto& ap : aps) x = ap(x);
+		float y = 0;
+		for(auto& e : echos) y += e(x);
+		out[i] = rev(in[i]);
+		assert(out[i] == y);
+	}
+
+	// block processing, with spans split at line wraps
+	for(int i=0; i<N; i+=500) blk.process(&in[i], 500);
+	for(int i=0; i<N; ++i) assert(in[i] == out[i]);
+}
+
+{
+	// Dist block processing matches sample processing, including delays
+	// under one sample that cannot be written ahead
+	const float dists[][3] = {{1.3, 2.9, 0.7}, {0.001, 1.1, 4}};
+	for(auto& d : dists){
+		Dist<3> a, b;
+		for(int j=0; j<3; ++j){ a.dist(j, d[j]); b.dist(j, d[j]); }
+		const int N = 3000;
+		std::vector<float> in(N), o0(N), o1(N), o2(N);
+		for(int i=0; i<N; ++i) in[i] = sin(i*0.05) + (i%300 == 0);
+		float * out[3] = {&o0[0], &o1[0], &o2[0]};
+		a.process(&in[0], out, 1000);
+		float * out2[3] = {&o0[1000], &o1[1000], &o2[1000]};
+		a.process(&in[1000], out2, N-1000);
+		for(int i=0; i<N; ++i){
+			float3 r = b(in[i]);
+			assert(r[0] == o0[i] && r[1] == o1[i] && r[2] == o2[i]);
+		}
+	}
+}
+
+{
+	// Dynamic scene matches the fixed scene and does not depend on threads
+	const float pose[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+	auto place = [&](HRFilter& s, int i){
+		s.pos(float3(2*cos(i*0.7), 0.3*(i%3) - 0.3, 2*sin(i*0.7)), pose);
+	};
+	const int N = 1200, B = 200;
+	std::vector<std::vector<float>> in(20, std::vector<float>(N));
+	for(int k=0; k<20; ++k){
+		for(int i=0; i<N; ++i) in[k][i] = sin(i*0.01*(k+1)) * ((i/B)%3 != 1);
+	}
+
+	HRScene<5> fix;
+	DynamicHRScene dyn(5);
+	for(int k=0; k<5; ++k){ place(fix.source(k), k); place(dyn.source(k), k); }
+	std::vector<float> L(N), R(N);
+	const float * blk[20];
+	for(int i=0; i<N; i+=B){
+		for(int k=0; k<5; ++k) blk[k] = &in[k][i];
+		dyn.process(blk, &L[i], &R[i], B);
+	}
+	for(int i=0; i<N; ++i){
+		for(int k=0; k<5; ++k) fix.sample(k) = in[k][i];
+		float2 o = fix();
+		assert(o[0] == L[i] && o[1] == R[i]);
+	}
+
+	// sources in three groups, split across threads
+	DynamicHRScene one(20), many(20);
+	many.threads(3);
+	assert(many.threads() == 3 && one.numSources() == 20 && one.slots() == 20);
+	one.removeSource(3); many.removeSource(3);
+	assert(one.numSources() == 19 && one.addSource() == 3 && many.addSource() == 3);
+	one.active(9, false); many.active(9, false);
+	for(int k=0; k<20; ++k){ place(one.source(k), k); place(many.source(k), k); }
+	std::vector<float> L2(N), R2(N);
+	for(int i=0; i<N; i+=B){
+		for(int k=0; k<20; ++k) blk[k] = (k==7) ? nullptr : &in[k][i];
+		one.process(blk, &L[i], &R[i], B);
+		many.process(blk, &L2[i], &R2[i], B);
+	}
+	for(int i=0; i<N; ++i) assert(L[i] == L2[i] && R[i] == R2[i]);
+
+	// a gap longer than the tail silences every group; sources then restart
+	const int G = B*60;
+	std::vector<std::vector<float>> gin(20, std::vector<float>(G));
+	for(int k=0; k<20; ++k){
+		for(int i=0; i<G; ++i) gin[k][i] = (i < 4*B || i >= G-5*B) ? sin(i*0.01*(k+1)) : 0.f;
+	}
+	HRScene<20> gfix;
+	DynamicHRScene gone(20), gmany(20);
+	gmany.threads(3);
+	for(int k=0; k<20; ++k){ place(gfix.source(k), k); place(gone.source(k), k); place(gmany.source(k), k); }
+	std::vector<float> GL(G), GR(G), GL2(G), GR2(G);
+	for(int i=0; i<G; i+=B){
+		for(int k=0; k<20; ++k) blk[k] = &gin[k][i];
+		gone.process(blk, &GL[i], &GR[i], B);
+		gmany.process(blk, &GL2[i], &GR2[i], B);
+	}
+	for(int i=0; i<G; ++i){
+		assert(GL[i] == GL2[i] && GR[i] == GR2[i]);
+		for(int k=0; k<20; ++k) gfix.sample(k) = gin[k][i];
+		float2 o = gfix();
+		assert(near(o[0], GL[i], 1e-6) && near(o[1], GR[i], 1e-6));
+	}
+}